@@ -0,0 +1,313 @@
+// Measures the decoder tuning profiles (DecoderTuning::LowLatency and
+// DecoderTuning::Throughput) on every H.264 decoder installed here.
+//
+// Usage: decoder-bench [--decoder ELEMENT] [--frames N] [--width W] [--height H] [--fps F]
+//
+// A clip is encoded once with x264enc (tune=zerolatency, as cameras send it)
+// and fed to "h264parse ! <decoder>" through appsrc twice per profile:
+// - latency: frames pushed at the clip frame rate; time from push to the
+//   decoded frame reaching appsink (median, p95 and max)
+// - throughput: all frames pushed at once; decoded frames per second
+
+#include "decodertuning.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Same candidates StreamManager probes on Windows, Linux and macOS
+const char *const kDecoders[] = {
+    "d3d12h264dec", "d3d11h264dec", "nvh264dec", "qsvh264dec", "vaapih264dec",
+    "v4l2h264dec", "vtdec", "avdec_h264", "openh264dec",
+};
+
+struct Clip {
+    GstCaps *caps = nullptr;
+    std::vector<GstBuffer*> frames;
+    GstClockTime frameDuration = 0;
+};
+
+struct Run {
+    bool ok = false;
+    int decoded = 0;
+    double seconds = 0.0;
+    std::vector<double> latenciesMs;
+};
+
+// Written by the appsink streaming thread, read after EOS
+struct RunContext {
+    GstClockTime frameDuration = 0;
+    std::vector<gint64> pushedUs;
+    std::vector<gint64> decodedUs;
+    int decoded = 0;
+};
+
+bool encodeClip(int width, int height, int fps, int frameCount, Clip &clip)
+{
+    QString description = QString(
+        "videotestsrc num-buffers=%1 pattern=ball ! "
+        "video/x-raw,format=I420,width=%2,height=%3,framerate=%4/1 ! "
+        "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=%5 bitrate=8000 ! "
+        "video/x-h264,stream-format=byte-stream,alignment=au ! "
+        "appsink name=sink sync=false")
+        .arg(frameCount).arg(width).arg(height).arg(fps).arg(fps * 2);
+
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.toUtf8().constData(), &error);
+    if (!pipeline) {
+        std::fprintf(stderr, "Cannot build the encoder (x264enc needed): %s\n",
+                     error ? error->message : "unknown error");
+        g_clear_error(&error);
+        return false;
+    }
+    g_clear_error(&error);
+
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    while (GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink))) {
+        if (!clip.caps) {
+            clip.caps = gst_caps_ref(gst_sample_get_caps(sample));
+        }
+        clip.frames.push_back(gst_buffer_ref(gst_sample_get_buffer(sample)));
+        gst_sample_unref(sample);
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+
+    clip.frameDuration = GST_SECOND / fps;
+    return clip.caps && !clip.frames.empty();
+}
+
+void freeClip(Clip &clip)
+{
+    for (GstBuffer *buffer : clip.frames) {
+        gst_buffer_unref(buffer);
+    }
+    clip.frames.clear();
+    if (clip.caps) {
+        gst_caps_unref(clip.caps);
+        clip.caps = nullptr;
+    }
+}
+
+GstFlowReturn onNewSample(GstAppSink *sink, gpointer userData)
+{
+    RunContext *context = static_cast<RunContext*>(userData);
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_ERROR;
+    }
+
+    const gint64 now = g_get_monotonic_time();
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    if (buffer && GST_BUFFER_PTS_IS_VALID(buffer)) {
+        const size_t index = GST_BUFFER_PTS(buffer) / context->frameDuration;
+        if (index < context->decodedUs.size() && context->decodedUs[index] == 0) {
+            context->decodedUs[index] = now;
+        }
+    }
+    ++context->decoded;
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+Run runDecoder(const Clip &clip, const char *element, DecoderTuning::Profile profile, bool paced)
+{
+    Run run;
+    const QString description = QString("appsrc name=src format=time ! h264parse ! %1 name=decoder ! "
+                                        "appsink name=sink sync=false").arg(QString::fromUtf8(element));
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.toUtf8().constData(), &error);
+    if (!pipeline) {
+        g_clear_error(&error);
+        return run;
+    }
+    g_clear_error(&error);
+
+    GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement *decoder = gst_bin_get_by_name(GST_BIN(pipeline), "decoder");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    DecoderTuning::apply(decoder, QString::fromUtf8(element), profile);
+
+    RunContext context;
+    context.frameDuration = clip.frameDuration;
+    context.pushedUs.assign(clip.frames.size(), 0);
+    context.decodedUs.assign(clip.frames.size(), 0);
+
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, &context, nullptr);
+    gst_app_src_set_caps(GST_APP_SRC(src), clip.caps);
+    // Throughput runs queue the whole clip up front
+    gst_app_src_set_max_bytes(GST_APP_SRC(src), 0);
+
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE) {
+        const gint64 startUs = g_get_monotonic_time();
+        const gint64 intervalUs = static_cast<gint64>(clip.frameDuration / GST_USECOND);
+
+        for (size_t i = 0; i < clip.frames.size(); ++i) {
+            if (paced) {
+                const gint64 dueUs = startUs + static_cast<gint64>(i) * intervalUs;
+                const gint64 waitUs = dueUs - g_get_monotonic_time();
+                if (waitUs > 0) {
+                    g_usleep(static_cast<gulong>(waitUs));
+                }
+            }
+            GstBuffer *buffer = gst_buffer_copy(clip.frames[i]);
+            GST_BUFFER_PTS(buffer) = i * clip.frameDuration;
+            GST_BUFFER_DTS(buffer) = i * clip.frameDuration;
+            GST_BUFFER_DURATION(buffer) = clip.frameDuration;
+            context.pushedUs[i] = g_get_monotonic_time();
+            if (gst_app_src_push_buffer(GST_APP_SRC(src), buffer) != GST_FLOW_OK) {
+                break;
+            }
+        }
+        gst_app_src_end_of_stream(GST_APP_SRC(src));
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+        GstMessage *message = gst_bus_timed_pop_filtered(bus, 120 * GST_SECOND,
+                                                         GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        run.ok = message && GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+        run.seconds = (g_get_monotonic_time() - startUs) / 1e6;
+        if (message) {
+            gst_message_unref(message);
+        }
+        gst_object_unref(bus);
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(src);
+    gst_object_unref(decoder);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+
+    run.decoded = context.decoded;
+    for (size_t i = 0; i < context.decodedUs.size(); ++i) {
+        if (context.decodedUs[i] > 0) {
+            run.latenciesMs.push_back((context.decodedUs[i] - context.pushedUs[i]) / 1000.0);
+        }
+    }
+    std::sort(run.latenciesMs.begin(), run.latenciesMs.end());
+    return run;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+bool decoderAvailable(const char *element)
+{
+    GstElementFactory *factory = gst_element_factory_find(element);
+    if (!factory) {
+        return false;
+    }
+    // Hardware plugins can register without a usable device
+    GstElement *probe = gst_element_factory_create(factory, nullptr);
+    gst_object_unref(factory);
+    if (!probe) {
+        return false;
+    }
+    gst_object_unref(probe);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    QStringList decoders;
+    int frames = 300;
+    int width = 1920;
+    int height = 1080;
+    int fps = 30;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--decoder") == 0 && hasValue) {
+            decoders.append(QString::fromUtf8(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+            width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+            height = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && hasValue) {
+            fps = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--decoder ELEMENT] [--frames N] [--width W] [--height H] [--fps F]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (frames <= 0 || width <= 0 || height <= 0 || fps <= 0) {
+        std::fprintf(stderr, "frames, width, height and fps must be positive\n");
+        return 2;
+    }
+    if (decoders.isEmpty()) {
+        for (const char *element : kDecoders) {
+            if (decoderAvailable(element)) {
+                decoders.append(QString::fromUtf8(element));
+            }
+        }
+    }
+    if (decoders.isEmpty()) {
+        std::fprintf(stderr, "No H.264 decoder available\n");
+        return 1;
+    }
+
+    Clip clip;
+    if (!encodeClip(width, height, fps, frames, clip)) {
+        freeClip(clip);
+        return 1;
+    }
+
+    std::printf("%dx%d@%d, %zu frames\n", width, height, fps, clip.frames.size());
+    std::printf("%-14s %-10s %10s %10s %10s %12s\n",
+                "decoder", "profile", "median ms", "p95 ms", "max ms", "throughput");
+
+    const DecoderTuning::Profile profiles[] = { DecoderTuning::LowLatency, DecoderTuning::Throughput };
+    const char *const profileNames[] = { "latency", "throughput" };
+    int failures = 0;
+
+    for (const QString &name : decoders) {
+        const QByteArray element = name.toUtf8();
+        for (DecoderTuning::Profile profile : profiles) {
+            Run latency = runDecoder(clip, element.constData(), profile, true);
+            Run throughput = runDecoder(clip, element.constData(), profile, false);
+            if (!latency.ok || !throughput.ok) {
+                std::printf("%-14s %-10s failed\n", element.constData(), profileNames[profile]);
+                ++failures;
+                continue;
+            }
+            std::printf("%-14s %-10s %10.2f %10.2f %10.2f %8.1f fps\n",
+                        element.constData(), profileNames[profile],
+                        percentile(latency.latenciesMs, 0.5), percentile(latency.latenciesMs, 0.95),
+                        latency.latenciesMs.empty() ? 0.0 : latency.latenciesMs.back(),
+                        throughput.decoded / throughput.seconds);
+        }
+    }
+
+    freeClip(clip);
+    return failures == 0 ? 0 : 1;
+}
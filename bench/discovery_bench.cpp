@@ -0,0 +1,161 @@
+// Times DiscoveryParser on browse tool output for many cameras on one link,
+// in both formats MdnsManager reads:
+// - avahi-browse -rpt: a "+" and an "=" line per instance
+// - dns-sd -Z: PTR, SRV, TXT, A and AAAA lines per instance, shuffled so
+//   records arrive out of order as they do from a busy network
+//
+// Usage: discovery-bench [--instances N] [--runs N] [--chunk BYTES]
+//
+// Output is fed in pipe-sized chunks, each followed by takeResolved(true) as
+// MdnsManager::onProcessOutput does, so the timing includes the incremental
+// promotion. Exits with status 1 if any instance fails to resolve.
+
+#include "discoveryparser.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const QString kServiceType = "_f1sh-camera._tcp";
+
+quint32 nextRandom(quint32 &state)
+{
+    // xorshift32; deterministic across platforms
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+QByteArray txtRecord(int i)
+{
+    return QString("\"protocol=%1\" \"encoding=%2\" \"control_port=%3\"")
+        .arg(QString(i % 2 ? "tcp" : "udp"), QString(i % 3 ? "h264" : "h265")).arg(50051 + i % 7).toUtf8();
+}
+
+QByteArray avahiOutput(int instances)
+{
+    QByteArray out;
+    for (int i = 0; i < instances; ++i) {
+        out += QString("+;eth0;IPv4;F1sh\\032Camera\\032%1;_f1sh-camera._tcp;local\n").arg(i).toUtf8();
+    }
+    for (int i = 0; i < instances; ++i) {
+        out += QString("=;eth0;IPv4;F1sh\\032Camera\\032%1;_f1sh-camera._tcp;local;cam-%1.local;10.%2.%3.%4;%5;")
+            .arg(i).arg((i >> 16) & 255).arg((i >> 8) & 255).arg(i & 255).arg(8888 + i % 100).toUtf8();
+        out += txtRecord(i) + '\n';
+    }
+    return out;
+}
+
+QByteArray dnsSdOutput(int instances)
+{
+    std::vector<QByteArray> lines;
+    lines.reserve(instances * 5);
+    for (int i = 0; i < instances; ++i) {
+        const QString owner = QString("F1sh Camera %1._f1sh-camera._tcp").arg(i);
+        const QString host = QString("cam-%1.local.").arg(i);
+        lines.push_back(QString("%1 PTR     %2\n").arg(kServiceType, -48).arg(owner).toUtf8());
+        lines.push_back(QString("%1 SRV     0 0 %2 %3\n").arg(owner, -48).arg(8888 + i % 100).arg(host).toUtf8());
+        lines.push_back(QString("%1 TXT     ").arg(owner, -48).toUtf8() + txtRecord(i) + '\n');
+        lines.push_back(QString("%1 A       10.%2.%3.%4\n").arg(host, -48)
+            .arg((i >> 16) & 255).arg((i >> 8) & 255).arg(i & 255).toUtf8());
+        lines.push_back(QString("%1 AAAA    fe80::%2\n").arg(host, -48).arg(i + 1, 0, 16).toUtf8());
+    }
+
+    // Fisher-Yates with a fixed seed, so every run parses the same order
+    quint32 state = 0x5eed1234u;
+    for (size_t i = lines.size() - 1; i > 0; --i) {
+        std::swap(lines[i], lines[nextRandom(state) % (i + 1)]);
+    }
+
+    QByteArray out = "; Zone file for _f1sh-camera._tcp.local.\n";
+    for (const QByteArray &line : lines) {
+        out += line;
+    }
+    return out;
+}
+
+struct Result {
+    int resolved = 0;
+    double ms = 0.0;
+};
+
+Result parseOnce(const QByteArray &output, int chunk)
+{
+    Result result;
+    DiscoveryParser parser(kServiceType);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int pos = 0; pos < output.size(); pos += chunk) {
+        parser.feed(output.mid(pos, chunk));
+        result.resolved += int(parser.takeResolved(true).size());
+    }
+    parser.finish();
+    result.resolved += int(parser.takeResolved(false).size());
+    result.ms = timer.nsecsElapsed() / 1e6;
+    return result;
+}
+
+int run(const char *format, const QByteArray &output, int instances, int runs, int chunk)
+{
+    std::vector<double> times;
+    int failures = 0;
+    for (int i = 0; i < runs; ++i) {
+        const Result result = parseOnce(output, chunk);
+        if (result.resolved != instances) {
+            std::printf("%s: %d of %d instances resolved\n", format, result.resolved, instances);
+            ++failures;
+        }
+        times.push_back(result.ms);
+    }
+    std::sort(times.begin(), times.end());
+
+    const int lines = int(output.count('\n'));
+    const double median = times[times.size() / 2];
+    std::printf("%-8s %9d %9d %10.3f %10.3f %10.0f\n", format, lines, int(output.size()),
+                median, times.back(), median * 1e6 / lines);
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int instances = 1000;
+    int runs = 20;
+    int chunk = 4096;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--instances") == 0 && hasValue) {
+            instances = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--runs") == 0 && hasValue) {
+            runs = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--chunk") == 0 && hasValue) {
+            chunk = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--instances N] [--runs N] [--chunk BYTES]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (instances <= 0 || runs <= 0 || chunk <= 0) {
+        std::fprintf(stderr, "instances, runs and chunk must be positive\n");
+        return 2;
+    }
+
+    std::printf("%d instances, %d runs, %d byte chunks\n", instances, runs, chunk);
+    std::printf("%-8s %9s %9s %10s %10s %10s\n", "format", "lines", "bytes", "median ms", "max ms", "ns/line");
+
+    int failures = run("avahi", avahiOutput(instances), instances, runs, chunk);
+    failures += run("dns-sd", dnsSdOutput(instances), instances, runs, chunk);
+    return failures == 0 ? 0 : 1;
+}
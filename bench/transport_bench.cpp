@@ -0,0 +1,463 @@
+// Compares the stream transports end to end over loopback: RTP/UDP, RTP/TCP,
+// RTSP (UDP and interleaved TCP) and SRT.
+//
+// Usage: transport-bench [--transport NAME] [--frames N] [--fps F] [--latency MS]
+//                        [--bitrate KBPS] [--port BASE]
+//
+// A sender pipeline encodes synthetic frames with x264enc tune=zerolatency and
+// serves them the way a camera would; the receiver is the source string
+// StreamManager builds (TransportSource::build) followed by h264parse and
+// avdec_h264 in the low-latency profile. Each frame carries its index as a
+// row of black/white blocks, so the receiver can match decoded frames to the
+// moment they were pushed. Reported latency therefore includes encode and
+// decode, which are the same for every transport; the differences between
+// rows are the transport's own cost. Lost frames are those never decoded.
+//
+// RTSP needs gstreamer-rtsp-server at build time and is skipped without it.
+
+#include "decodertuning.h"
+#include "transportsource.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/video/video.h>
+#ifdef HAVE_RTSP_SERVER
+#include <gst/rtsp-server/rtsp-server.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char *const kTransports[] = { "udp", "tcp", "rtsp", "rtsp-tcp", "srt" };
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+
+// Frame index code: 16 index bits and a 4-bit check, one 32x32 block each
+constexpr int kIndexBits = 16;
+constexpr int kCheckBits = 4;
+constexpr int kBlockSize = 32;
+constexpr int kWarmupFrames = 60;   // Connection setup and first keyframe; not measured
+
+struct Config {
+    int frames = 300;
+    int fps = 30;
+    int latencyMs = 50;
+    int bitrateKbps = 4000;
+    int basePort = 5600;
+};
+
+struct Result {
+    bool ok = false;
+    int received = 0;
+    std::vector<double> latenciesMs;
+    QString error;
+};
+
+// Shared between the pushing thread and the receiver's streaming thread
+struct Session {
+    explicit Session(int frames)
+        : total(frames),
+          sentUs(new std::atomic<gint64>[frames]),
+          receivedUs(new std::atomic<gint64>[frames])
+    {
+        for (int i = 0; i < frames; ++i) {
+            sentUs[i] = 0;
+            receivedUs[i] = 0;
+        }
+    }
+
+    int total;
+    std::unique_ptr<std::atomic<gint64>[]> sentUs;
+    std::unique_ptr<std::atomic<gint64>[]> receivedUs;
+
+    std::mutex mutex;
+    GstElement *appsrc = nullptr;   // Owned reference; created late for RTSP
+};
+
+quint32 checkBits(quint32 index)
+{
+    return (index ^ (index >> 4) ^ (index >> 8) ^ (index >> 12)) & 0xf;
+}
+
+void fillFrame(std::vector<quint8> &frame, quint32 index)
+{
+    quint8 *y = frame.data();
+    quint8 *chroma = y + kWidth * kHeight;
+
+    // Moving diagonal gradient so the encoder has real work every frame
+    for (int row = 0; row < kHeight; ++row) {
+        quint8 *line = y + row * kWidth;
+        for (int x = 0; x < kWidth; ++x) {
+            line[x] = static_cast<quint8>(x + row + index * 4);
+        }
+    }
+    std::memset(chroma, 128, kWidth * kHeight / 2);
+
+    const quint32 code = index | (checkBits(index) << kIndexBits);
+    for (int bit = 0; bit < kIndexBits + kCheckBits; ++bit) {
+        const quint8 value = (code >> bit) & 1 ? 235 : 16;
+        for (int row = 0; row < kBlockSize; ++row) {
+            std::memset(y + row * kWidth + bit * kBlockSize, value, kBlockSize);
+        }
+    }
+}
+
+// Returns the frame index, or -1 if the code is damaged
+int readFrameIndex(const quint8 *y, int stride)
+{
+    quint32 code = 0;
+    for (int bit = 0; bit < kIndexBits + kCheckBits; ++bit) {
+        // Centre of the block only, away from edge ringing
+        int sum = 0;
+        for (int row = kBlockSize / 4; row < kBlockSize * 3 / 4; ++row) {
+            const quint8 *line = y + row * stride + bit * kBlockSize;
+            for (int x = kBlockSize / 4; x < kBlockSize * 3 / 4; ++x) {
+                sum += line[x];
+            }
+        }
+        if (sum / (kBlockSize * kBlockSize / 4) > 128) {
+            code |= 1u << bit;
+        }
+    }
+
+    const quint32 index = code & ((1u << kIndexBits) - 1);
+    return (code >> kIndexBits) == checkBits(index) ? static_cast<int>(index) : -1;
+}
+
+GstFlowReturn onNewSample(GstAppSink *sink, gpointer userData)
+{
+    Session *session = static_cast<Session*>(userData);
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_ERROR;
+    }
+
+    const gint64 now = g_get_monotonic_time();
+    GstVideoInfo info;
+    GstMapInfo map;
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    if (gst_video_info_from_caps(&info, gst_sample_get_caps(sample))
+        && buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        const int index = readFrameIndex(map.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 0),
+                                         GST_VIDEO_INFO_PLANE_STRIDE(&info, 0));
+        if (index >= 0 && index < session->total) {
+            gint64 expected = 0;
+            session->receivedUs[index].compare_exchange_strong(expected, now);
+        }
+        gst_buffer_unmap(buffer, &map);
+    }
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+QString encoderString(const Config &config)
+{
+    return QString("appsrc name=src is-live=true format=time do-timestamp=true "
+                   "caps=video/x-raw,format=I420,width=%1,height=%2,framerate=%3/1 ! "
+                   "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=%4 bitrate=%5 ! "
+                   "h264parse config-interval=-1 ! ")
+        .arg(kWidth).arg(kHeight).arg(config.fps).arg(config.fps * 2).arg(config.bitrateKbps);
+}
+
+// Sender for the non-RTSP transports; the camera side of each receive string
+QString senderString(const QString &transport, const Config &config, int port)
+{
+    const QString encoder = encoderString(config);
+    if (transport == "udp") {
+        return encoder + QString("rtph264pay config-interval=-1 pt=96 ! "
+                                 "udpsink host=127.0.0.1 port=%1 sync=false").arg(port);
+    }
+    if (transport == "tcp") {
+        return encoder + QString("rtph264pay config-interval=-1 pt=96 ! rtpstreampay ! "
+                                 "tcpserversink host=127.0.0.1 port=%1 sync=false").arg(port);
+    }
+    if (transport == "srt") {
+        return encoder + QString("mpegtsmux ! srtsink uri=srt://:%1?mode=listener latency=%2 "
+                                 "wait-for-connection=false sync=false").arg(port).arg(config.latencyMs);
+    }
+    return QString();
+}
+
+#ifdef HAVE_RTSP_SERVER
+void onMediaConfigure(GstRTSPMediaFactory *, GstRTSPMedia *media, gpointer userData)
+{
+    Session *session = static_cast<Session*>(userData);
+    GstElement *element = gst_rtsp_media_get_element(media);
+    GstElement *appsrc = gst_bin_get_by_name_recurse_up(GST_BIN(element), "src");
+    gst_object_unref(element);
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->appsrc) {
+        gst_object_unref(session->appsrc);
+    }
+    session->appsrc = appsrc;
+}
+#endif
+
+GstElement *launch(const QString &description, QString *error)
+{
+    GError *gerror = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.toUtf8().constData(), &gerror);
+    if (!pipeline) {
+        *error = QString::fromUtf8(gerror ? gerror->message : "unknown error");
+    }
+    g_clear_error(&gerror);
+    return pipeline;
+}
+
+QString busError(GstElement *pipeline)
+{
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *message = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+    gst_object_unref(bus);
+    if (!message) {
+        return QString();
+    }
+    GError *error = nullptr;
+    gst_message_parse_error(message, &error, nullptr);
+    QString text = QString::fromUtf8(error ? error->message : "unknown error");
+    g_clear_error(&error);
+    gst_message_unref(message);
+    return text;
+}
+
+Result runTransport(const QString &transport, const Config &config, int port)
+{
+    Result result;
+    const int total = kWarmupFrames + config.frames;
+    Session session(total);
+
+    GstElement *sender = nullptr;
+#ifdef HAVE_RTSP_SERVER
+    GMainContext *context = nullptr;
+    GMainLoop *loop = nullptr;
+    GstRTSPServer *server = nullptr;
+    std::thread serverThread;
+#endif
+
+    if (transport.startsWith("rtsp")) {
+#ifdef HAVE_RTSP_SERVER
+        context = g_main_context_new();
+        loop = g_main_loop_new(context, FALSE);
+        server = gst_rtsp_server_new();
+        gst_rtsp_server_set_address(server, "127.0.0.1");
+        gst_rtsp_server_set_service(server, QByteArray::number(port).constData());
+
+        GstRTSPMediaFactory *factory = gst_rtsp_media_factory_new();
+        const QString launchLine = QString("( %1rtph264pay name=pay0 config-interval=-1 pt=96 )")
+                                       .arg(encoderString(config));
+        gst_rtsp_media_factory_set_launch(factory, launchLine.toUtf8().constData());
+        gst_rtsp_media_factory_set_shared(factory, TRUE);
+        g_signal_connect(factory, "media-configure", G_CALLBACK(onMediaConfigure), &session);
+
+        GstRTSPMountPoints *mounts = gst_rtsp_server_get_mount_points(server);
+        gst_rtsp_mount_points_add_factory(mounts, "/", factory);
+        g_object_unref(mounts);
+
+        if (gst_rtsp_server_attach(server, context) == 0) {
+            result.error = "cannot start the RTSP server";
+        } else {
+            serverThread = std::thread([loop]() { g_main_loop_run(loop); });
+        }
+#else
+        result.error = "built without gstreamer-rtsp-server";
+        return result;
+#endif
+    } else {
+        sender = launch(senderString(transport, config, port), &result.error);
+        if (sender) {
+            session.appsrc = gst_bin_get_by_name(GST_BIN(sender), "src");
+            gst_element_set_state(sender, GST_STATE_PLAYING);
+            // Let listeners (tcpserversink, srtsink) bind before the receiver connects
+            g_usleep(200 * 1000);
+        }
+    }
+
+    GstElement *receiver = nullptr;
+    if (result.error.isEmpty()) {
+        TransportSource::Options options;
+        options.host = "127.0.0.1";
+        options.port = port;
+        options.latencyMs = config.latencyMs;
+
+        QString source = TransportSource::build(transport, options, &result.error);
+        if (!source.isEmpty()) {
+            receiver = launch(source + "h264parse ! avdec_h264 name=decoder ! videoconvert ! "
+                                       "video/x-raw,format=I420 ! appsink name=sink sync=false",
+                              &result.error);
+        }
+    }
+
+    if (receiver) {
+        GstElement *decoder = gst_bin_get_by_name(GST_BIN(receiver), "decoder");
+        DecoderTuning::apply(decoder, "avdec_h264", DecoderTuning::LowLatency);
+        gst_object_unref(decoder);
+
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(receiver), "sink");
+        GstAppSinkCallbacks callbacks = {};
+        callbacks.new_sample = onNewSample;
+        gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, &session, nullptr);
+        gst_object_unref(sink);
+
+        gst_element_set_state(receiver, GST_STATE_PLAYING);
+
+        std::vector<quint8> frame(kWidth * kHeight * 3 / 2);
+        const gint64 intervalUs = 1000000 / config.fps;
+        const gint64 startUs = g_get_monotonic_time();
+
+        for (int i = 0; i < total; ++i) {
+            const gint64 waitUs = startUs + i * intervalUs - g_get_monotonic_time();
+            if (waitUs > 0) {
+                g_usleep(static_cast<gulong>(waitUs));
+            }
+
+            GstElement *appsrc = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(session.mutex);
+                if (session.appsrc) {
+                    appsrc = GST_ELEMENT(gst_object_ref(session.appsrc));
+                }
+            }
+            if (!appsrc) {
+                continue;   // RTSP media not created yet
+            }
+
+            fillFrame(frame, static_cast<quint32>(i));
+            GstBuffer *buffer = gst_buffer_new_allocate(nullptr, frame.size(), nullptr);
+            gst_buffer_fill(buffer, 0, frame.data(), frame.size());
+            session.sentUs[i] = g_get_monotonic_time();
+            gst_app_src_push_buffer(GST_APP_SRC(appsrc), buffer);
+            gst_object_unref(appsrc);
+        }
+
+        // Frames still in flight
+        g_usleep(static_cast<gulong>(qMax(1000, config.latencyMs * 4)) * 1000);
+
+        result.error = busError(receiver);
+        result.ok = result.error.isEmpty();
+        gst_element_set_state(receiver, GST_STATE_NULL);
+        gst_object_unref(receiver);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(session.mutex);
+        if (session.appsrc) {
+            gst_object_unref(session.appsrc);
+            session.appsrc = nullptr;
+        }
+    }
+    if (sender) {
+        gst_element_set_state(sender, GST_STATE_NULL);
+        gst_object_unref(sender);
+    }
+#ifdef HAVE_RTSP_SERVER
+    if (loop) {
+        g_main_loop_quit(loop);
+        if (serverThread.joinable()) {
+            serverThread.join();
+        }
+        g_main_loop_unref(loop);
+    }
+    if (server) {
+        g_object_unref(server);
+    }
+    if (context) {
+        g_main_context_unref(context);
+    }
+#endif
+
+    for (int i = kWarmupFrames; i < total; ++i) {
+        const gint64 sent = session.sentUs[i];
+        const gint64 received = session.receivedUs[i];
+        if (sent > 0 && received > 0) {
+            result.latenciesMs.push_back((received - sent) / 1000.0);
+        }
+    }
+    result.received = static_cast<int>(result.latenciesMs.size());
+    std::sort(result.latenciesMs.begin(), result.latenciesMs.end());
+    return result;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    Config config;
+    QStringList transports;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--transport") == 0 && hasValue) {
+            transports.append(QString::fromUtf8(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            config.frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && hasValue) {
+            config.fps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--latency") == 0 && hasValue) {
+            config.latencyMs = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bitrate") == 0 && hasValue) {
+            config.bitrateKbps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            config.basePort = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--transport NAME] [--frames N] [--fps F] [--latency MS] "
+                                 "[--bitrate KBPS] [--port BASE]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (config.frames <= 0 || config.fps <= 0 || config.latencyMs < 0 || config.bitrateKbps <= 0
+        || config.frames + kWarmupFrames >= (1 << kIndexBits)) {
+        std::fprintf(stderr, "Invalid option value\n");
+        return 2;
+    }
+    if (transports.isEmpty()) {
+        for (const char *transport : kTransports) {
+            transports.append(QString::fromUtf8(transport));
+        }
+    }
+
+    std::printf("%dx%d@%d, %d kbit/s, %d measured frames, rtsp/srt latency %d ms\n",
+                kWidth, kHeight, config.fps, config.bitrateKbps, config.frames, config.latencyMs);
+    std::printf("%-9s %10s %10s %10s %8s\n", "transport", "median ms", "p95 ms", "max ms", "lost");
+
+    int failures = 0;
+    for (int i = 0; i < transports.size(); ++i) {
+        const QByteArray name = transports[i].toUtf8();
+        Result result = runTransport(transports[i], config, config.basePort + i * 2);
+        if (!result.ok) {
+            std::printf("%-9s failed: %s\n", name.constData(), result.error.toUtf8().constData());
+            ++failures;
+            continue;
+        }
+        std::printf("%-9s %10.2f %10.2f %10.2f %8d\n", name.constData(),
+                    percentile(result.latenciesMs, 0.5), percentile(result.latenciesMs, 0.95),
+                    result.latenciesMs.empty() ? 0.0 : result.latenciesMs.back(),
+                    config.frames - result.received);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -27,6 +27,11 @@ Item {
             errorText.text = error
             errorText.visible = true
         }
+        function onSnapshotSaved(success, path) {
+            snapshotToastText.text = success ? "Saved " + path : "Snapshot failed"
+            snapshotToast.visible = true
+            snapshotToastTimer.restart()
+        }
     }
 
     // Background
@@ -57,6 +62,25 @@ Item {
             visible: streamManager ? streamManager.isStreaming : false
         }
 
+        // Only decode keyframes while this page or its window is hidden
+        Binding {
+            target: streamManager
+            property: "lowPower"
+            when: streamManager !== null
+            value: !root.visible
+                   || root.Window.visibility === Window.Minimized
+                   || root.Window.visibility === Window.Hidden
+        }
+
+        // Let the pipeline scale frames down to what is actually displayed
+        Binding {
+            target: streamManager
+            property: "viewportSize"
+            when: streamManager !== null
+            value: Qt.size(Math.round(videoFrame.width * Screen.devicePixelRatio),
+                           Math.round(videoFrame.height * Screen.devicePixelRatio))
+        }
+
         // Placeholder when not streaming
         Column {
             anchors.centerIn: parent
@@ -96,6 +120,53 @@ Item {
             }
         }
 
+        // Time-shift banner: the picture is from the replay buffer, not live
+        Rectangle {
+            anchors.top: parent.top
+            anchors.horizontalCenter: parent.horizontalCenter
+            anchors.margins: 10 * scaleFactor
+            width: timeShiftText.width + 20 * scaleFactor
+            height: timeShiftText.height + 10 * scaleFactor
+            color: "#c0ff8800"
+            radius: 5
+            visible: streamManager ? streamManager.isTimeShifting : false
+
+            Text {
+                id: timeShiftText
+                anchors.centerIn: parent
+                text: "REPLAY"
+                color: "white"
+                font.bold: true
+                font.pixelSize: 16 * scaleFactor
+            }
+        }
+
+        // Snapshot result, shown briefly
+        Rectangle {
+            id: snapshotToast
+            anchors.bottom: parent.bottom
+            anchors.horizontalCenter: parent.horizontalCenter
+            anchors.margins: 10 * scaleFactor
+            width: snapshotToastText.width + 20 * scaleFactor
+            height: snapshotToastText.height + 10 * scaleFactor
+            color: "#80000000"
+            radius: 5
+            visible: false
+
+            Text {
+                id: snapshotToastText
+                anchors.centerIn: parent
+                color: "white"
+                font.pixelSize: 12 * scaleFactor
+            }
+
+            Timer {
+                id: snapshotToastTimer
+                interval: 2500
+                onTriggered: snapshotToast.visible = false
+            }
+        }
+
         // Streaming indicator
         Rectangle {
             anchors.bottom: parent.bottom
@@ -192,6 +263,61 @@ Item {
                 }
             }
 
+            // Record toggle: writes the encoded stream to disk without touching the live view
+            Button {
+                width: 100 * scaleFactor
+                height: 40 * scaleFactor
+                text: streamManager && streamManager.isRecording ? "Stop Rec" : "Record"
+                font.pixelSize: 14 * scaleFactor
+                enabled: streamManager ? streamManager.isStreaming : false
+                highlighted: streamManager ? streamManager.isRecording : false
+
+                onClicked: {
+                    if (streamManager.isRecording) {
+                        streamManager.stopRecording()
+                    } else {
+                        streamManager.startRecording()
+                    }
+                }
+            }
+
+            // Still capture; encoding happens off the GUI thread
+            Button {
+                width: 100 * scaleFactor
+                height: 40 * scaleFactor
+                text: "Snapshot"
+                font.pixelSize: 14 * scaleFactor
+                enabled: streamManager ? streamManager.isStreaming : false
+                onClicked: streamManager.captureSnapshot(streamManager.snapshotFullResolution)
+            }
+
+            // Instant replay: save the buffered history, or watch it instead of live video
+            Button {
+                width: 100 * scaleFactor
+                height: 40 * scaleFactor
+                text: streamManager && streamManager.isExporting ? "Saving..." : "Save Replay"
+                font.pixelSize: 14 * scaleFactor
+                visible: streamManager ? streamManager.replayEnabled : false
+                enabled: streamManager ? !streamManager.isExporting && streamManager.replayBufferedSeconds > 0 : false
+                onClicked: streamManager.exportReplay(streamManager.replaySeconds)
+            }
+
+            Button {
+                width: 100 * scaleFactor
+                height: 40 * scaleFactor
+                text: streamManager && streamManager.isTimeShifting ? "Live" : "Replay"
+                font.pixelSize: 14 * scaleFactor
+                visible: streamManager ? streamManager.replayEnabled : false
+                highlighted: streamManager ? streamManager.isTimeShifting : false
+                onClicked: {
+                    if (streamManager.isTimeShifting) {
+                        streamManager.stopTimeShift()
+                    } else {
+                        streamManager.startTimeShift(streamManager.replaySeconds)
+                    }
+                }
+            }
+
             // Log button
             Button {
                 width: 50 * scaleFactor
@@ -260,11 +386,60 @@ Item {
                 font.pixelSize: 11 * scaleFactor
             }
 
+            Text {
+                text: "Transport: " + (streamManager ? streamManager.activeTransport : "udp")
+                color: "#cccccc"
+                font.pixelSize: 11 * scaleFactor
+            }
+
             Text {
                 text: "Decoder: " + (streamManager ? streamManager.currentDecoder : "None")
                 color: "#cccccc"
                 font.pixelSize: 11 * scaleFactor
             }
+
+            Text {
+                text: "FPS: " + (streamManager ? streamManager.fps.toFixed(1) : "0.0")
+                color: "#cccccc"
+                font.pixelSize: 11 * scaleFactor
+            }
+
+            Text {
+                visible: streamManager ? streamManager.replayEnabled : false
+                text: streamManager
+                      ? "Replay: " + streamManager.replayBufferedSeconds.toFixed(1) + " s, "
+                        + (streamManager.replayMemoryUsed / 1048576).toFixed(1) + " / "
+                        + (streamManager.replayMemoryAllocated / 1048576).toFixed(1) + " MB"
+                      : ""
+                color: "#cccccc"
+                font.pixelSize: 11 * scaleFactor
+            }
+
+            Text {
+                visible: streamManager ? streamManager.isRecording : false
+                text: "REC: " + (streamManager ? streamManager.recordingPath : "")
+                color: "#ff6666"
+                font.pixelSize: 11 * scaleFactor
+            }
+
+            // Frames lost before display, by cause
+            Text {
+                text: "Dropped: " + (streamManager ? streamManager.droppedTotal : 0)
+                color: streamManager && streamManager.droppedTotal > 0 ? "#ffcc66" : "#cccccc"
+                font.pixelSize: 11 * scaleFactor
+            }
+
+            Text {
+                visible: streamManager ? streamManager.droppedTotal > 0 : false
+                text: streamManager
+                      ? "  queue " + streamManager.droppedQueue
+                        + " / sink " + streamManager.droppedAppsink
+                        + " / render " + streamManager.droppedSuperseded
+                        + " / decode " + streamManager.droppedDecodeError
+                      : ""
+                color: "#999999"
+                font.pixelSize: 10 * scaleFactor
+            }
         }
     }
 
@@ -279,6 +454,23 @@ Item {
             }
             streamManager.port = streamPort
 
+            // Join the multicast group the camera was told to send to
+            if (configManager) {
+                streamManager.multicastInterface = configManager.multicastInterface
+                streamManager.multicastGroup = configManager.multicastEnabled ? configManager.multicastGroup : ""
+            }
+
+            // Client-side transports (tcp/rtsp/srt) connect to the camera;
+            // "auto" follows the protocol advertised over mDNS
+            if (mdnsManager && mdnsManager.cameraFound) {
+                streamManager.discoveredProtocol = mdnsManager.protocol
+            }
+            if (mdnsManager && mdnsManager.cameraIp) {
+                streamManager.host = mdnsManager.cameraIp
+            } else if (configManager) {
+                streamManager.host = configManager.txServerIp
+            }
+
             // Set rotation from config
             // SwapResolution only swaps resolution dimensions (landscape/portrait),
             // the actual video rotation must be done locally via videoflip
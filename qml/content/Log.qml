@@ -45,27 +45,31 @@ Item {
             border.width: 1
             radius: 5
 
-            ScrollView {
-                id: scrollView
+            ListView {
+                id: logView
                 anchors.fill: parent
                 anchors.margins: 5
                 clip: true
+                model: logManager ? logManager.model : null
+                boundsBehavior: Flickable.StopAtBounds
+                ScrollBar.vertical: ScrollBar { }
 
-                TextArea {
-                    id: logTextArea
-                    text: logManager ? logManager.logText : ""
+                // Follow new entries unless the user has scrolled up
+                property bool followTail: true
+                onMovementEnded: followTail = atYEnd
+                onCountChanged: {
+                    if (followTail) Qt.callLater(positionViewAtEnd)
+                }
+
+                delegate: TextEdit {
+                    width: logView.width - 12
+                    text: model.message.replace(/\n$/, "")
                     font.family: "Consolas, Monaco, monospace"
                     font.pixelSize: 14
                     readOnly: true
-                    wrapMode: TextArea.Wrap
+                    wrapMode: TextEdit.Wrap
                     selectByMouse: true
                     color: "#333333"
-                    background: Rectangle { color: "transparent" }
-                    
-                    // Auto-scroll to bottom when new log entries are added
-                    onTextChanged: {
-                        cursorPosition = text.length
-                    }
                 }
             }
         }
@@ -86,6 +90,23 @@ Item {
                 }
             }
 
+            Button {
+                text: traceManager && traceManager.enabled ? qsTr("Save Trace") : qsTr("Start Trace")
+                font.pixelSize: 18
+                font.bold: true
+                Layout.preferredWidth: 150
+                Layout.preferredHeight: 50
+                onClicked: {
+                    if (!traceManager) return
+                    if (traceManager.enabled) {
+                        traceManager.saveTrace()
+                        traceManager.enabled = false
+                    } else {
+                        traceManager.enabled = true
+                    }
+                }
+            }
+
             Button {
                 text: qsTr("Close")
                 font.pixelSize: 18
@@ -98,14 +119,4 @@ Item {
             }
         }
     }
-    
-    // Connection to auto-scroll when new log entries arrive
-    Connections {
-        target: logManager
-        enabled: logManager !== null
-        function onNewLogEntry(message) {
-            // Scroll to bottom
-            logTextArea.cursorPosition = logTextArea.text.length
-        }
-    }
 }
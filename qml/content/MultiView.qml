@@ -0,0 +1,131 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+
+Item {
+    id: root
+    anchors.fill: parent
+
+    // Scale factor for responsive UI
+    readonly property real scaleFactor: Math.min(width / 1920, height / 1080)
+
+    // Square-ish grid: 1, 2x1, 2x2, 3x2, 3x3 ...
+    readonly property int sessionCount: sessionManager ? sessionManager.sessionCount : 0
+    readonly property int columns: Math.max(1, Math.ceil(Math.sqrt(sessionCount)))
+    readonly property int rows: Math.max(1, Math.ceil(sessionCount / columns))
+
+    Rectangle {
+        anchors.fill: parent
+        color: "#1a1a1a"
+    }
+
+    // Header bar
+    Rectangle {
+        id: header
+        anchors.top: parent.top
+        anchors.left: parent.left
+        anchors.right: parent.right
+        height: 60 * scaleFactor
+        color: "#2d2d2d"
+
+        Text {
+            anchors.centerIn: parent
+            text: "Multi View (" + sessionCount + ")"
+            color: "white"
+            font.pixelSize: 28 * scaleFactor
+            font.bold: true
+        }
+    }
+
+    Grid {
+        id: grid
+        anchors.top: header.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 4
+        columns: root.columns
+        spacing: 4
+
+        Repeater {
+            model: sessionManager ? sessionManager.sessions : []
+
+            delegate: Rectangle {
+                id: tile
+                width: (grid.width - (root.columns - 1) * grid.spacing) / root.columns
+                height: (grid.height - (root.rows - 1) * grid.spacing) / root.rows
+                color: "black"
+                border.color: modelData.active ? "#0031ff" : "#333333"
+                border.width: modelData.active ? 3 : 1
+
+                property int frameCount: 0
+
+                // Report the tile size so the compositor can budget this camera's pipeline
+                function reportSize() {
+                    if (sessionManager) {
+                        sessionManager.setTileSize(index, Qt.size(Math.round(width * Screen.devicePixelRatio),
+                                                                  Math.round(height * Screen.devicePixelRatio)))
+                    }
+                }
+                onWidthChanged: reportSize()
+                onHeightChanged: reportSize()
+                Component.onCompleted: reportSize()
+
+                Connections {
+                    target: modelData.stream
+                    function onFrameReady() {
+                        tile.frameCount++
+                        tileImage.source = "image://" + modelData.providerId + "/frame?" + tile.frameCount
+                    }
+                }
+
+                Image {
+                    id: tileImage
+                    anchors.fill: parent
+                    anchors.margins: tile.border.width
+                    fillMode: Image.PreserveAspectFit
+                    cache: false
+                    asynchronous: false
+                    source: ""
+                }
+
+                // Camera name, status and budget
+                Rectangle {
+                    anchors.left: parent.left
+                    anchors.bottom: parent.bottom
+                    anchors.margins: 6
+                    width: tileLabel.width + 12
+                    height: tileLabel.height + 6
+                    color: "#80000000"
+                    radius: 4
+
+                    Text {
+                        id: tileLabel
+                        anchors.centerIn: parent
+                        text: modelData.name + " - " + modelData.status
+                              + (modelData.frameRateBudget > 0 ? " (" + modelData.frameRateBudget + " fps)" : "")
+                              + " - " + modelData.stream.fps.toFixed(1) + " fps"
+                        color: "white"
+                        font.pixelSize: 12
+                    }
+                }
+
+                MouseArea {
+                    anchors.fill: parent
+                    onClicked: if (sessionManager) sessionManager.activeIndex = index
+                }
+            }
+        }
+    }
+
+    Text {
+        anchors.centerIn: parent
+        visible: sessionCount === 0
+        text: "No cameras in the session"
+        color: "#888888"
+        font.pixelSize: 24 * scaleFactor
+    }
+
+    Component.onCompleted: if (sessionManager) sessionManager.startAll()
+    Component.onDestruction: if (sessionManager) sessionManager.stopAll()
+}
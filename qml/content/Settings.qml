@@ -108,6 +108,224 @@ Item {
                 font.pixelSize: 18
                 onValueChanged: if (configManager) configManager.rotate = value
             }
+
+            Text {
+                text: qsTr("Decoder Profile:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            ComboBox {
+                id: decoderProfileCombo
+                model: streamManager ? streamManager.decoderProfileOptions : ["Lowest latency", "Highest throughput"]
+                currentIndex: streamManager ? streamManager.decoderProfile : 0
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onCurrentIndexChanged: if (streamManager) streamManager.decoderProfile = currentIndex
+            }
+
+            Text {
+                text: qsTr("Transport:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            ComboBox {
+                id: transportCombo
+                model: streamManager ? streamManager.transportOptions : ["Auto (from discovery)"]
+                currentIndex: streamManager ? streamManager.transportIndex : 0
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onCurrentIndexChanged: if (streamManager) streamManager.transportIndex = currentIndex
+            }
+
+            Text {
+                text: qsTr("Recording Format:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            ComboBox {
+                id: recordingFormatCombo
+                model: streamManager ? streamManager.recordingFormatOptions : ["MP4 (fragmented)"]
+                currentIndex: streamManager ? streamManager.recordingFormat : 0
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onCurrentIndexChanged: if (streamManager) streamManager.recordingFormat = currentIndex
+            }
+
+            Text {
+                text: qsTr("Recording Folder:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            TextField {
+                id: recordingDirectoryInput
+                text: streamManager ? streamManager.recordingDirectory : ""
+                font.pixelSize: 20
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                onEditingFinished: if (streamManager) streamManager.recordingDirectory = text
+            }
+
+            Text {
+                text: qsTr("Snapshot Format:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            ComboBox {
+                id: snapshotFormatCombo
+                model: streamManager ? streamManager.snapshotFormatOptions : ["PNG (lossless)"]
+                currentIndex: streamManager ? streamManager.snapshotFormat : 0
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onCurrentIndexChanged: if (streamManager) streamManager.snapshotFormat = currentIndex
+            }
+
+            Text {
+                text: qsTr("Full-Resolution Snapshots:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            Switch {
+                id: snapshotFullResSwitch
+                checked: streamManager ? streamManager.snapshotFullResolution : false
+                onToggled: if (streamManager) streamManager.snapshotFullResolution = checked
+            }
+
+            Text {
+                text: qsTr("Replay Buffer:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            Switch {
+                id: replaySwitch
+                checked: streamManager ? streamManager.replayEnabled : false
+                onToggled: if (streamManager) streamManager.replayEnabled = checked
+            }
+
+            Text {
+                text: qsTr("Replay Length (s):")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            SpinBox {
+                id: replaySecondsSpin
+                from: 1
+                to: 600
+                value: streamManager ? streamManager.replaySeconds : 30
+                enabled: replaySwitch.checked
+                editable: true
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onValueModified: if (streamManager) streamManager.replaySeconds = value
+            }
+
+            Text {
+                text: qsTr("Replay Memory, all cameras (MB):")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            SpinBox {
+                id: replayMemorySpin
+                from: 8
+                to: 1024
+                stepSize: 8
+                value: streamManager ? streamManager.replayMemoryLimit : 64
+                enabled: replaySwitch.checked
+                editable: true
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                font.pixelSize: 18
+                onValueModified: if (streamManager) streamManager.replayMemoryLimit = value
+            }
+
+            Text {
+                text: qsTr("Multicast:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            Switch {
+                id: multicastSwitch
+                checked: configManager ? configManager.multicastEnabled : false
+                onToggled: if (configManager) configManager.multicastEnabled = checked
+            }
+
+            Text {
+                text: qsTr("Multicast Group:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            TextField {
+                id: multicastGroupInput
+                text: configManager ? configManager.multicastGroup : "239.255.42.1"
+                enabled: multicastSwitch.checked
+                font.pixelSize: 20
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                placeholderText: "239.255.42.1"
+                onEditingFinished: if (configManager) configManager.multicastGroup = text
+            }
+
+            Text {
+                text: qsTr("Multicast Interface:")
+                font.pixelSize: 24
+                font.bold: true
+            }
+            TextField {
+                id: multicastIfaceInput
+                text: configManager ? configManager.multicastInterface : ""
+                enabled: multicastSwitch.checked
+                font.pixelSize: 20
+                Layout.preferredWidth: 300
+                Layout.preferredHeight: 40
+                placeholderText: qsTr("default")
+                onEditingFinished: if (configManager) configManager.multicastInterface = text
+            }
+
+            Text {
+                text: qsTr("Log Levels:")
+                font.pixelSize: 24
+                font.bold: true
+                Layout.alignment: Qt.AlignTop
+            }
+            GridLayout {
+                columns: 2
+                columnSpacing: 10
+                rowSpacing: 5
+
+                Repeater {
+                    model: logManager ? logManager.categoryNames : []
+
+                    RowLayout {
+                        spacing: 5
+
+                        Text {
+                            text: modelData
+                            font.pixelSize: 16
+                            Layout.preferredWidth: 60
+                        }
+                        ComboBox {
+                            id: levelCombo
+                            model: logManager ? logManager.levelNames : []
+                            currentIndex: logManager ? logManager.categoryLevel(modelData) : 1
+                            Layout.preferredWidth: 110
+                            Layout.preferredHeight: 32
+                            font.pixelSize: 14
+                            onActivated: if (logManager) logManager.setCategoryLevel(modelData, currentIndex)
+
+                            Connections {
+                                target: logManager
+                                function onLevelsChanged() {
+                                    levelCombo.currentIndex = logManager.categoryLevel(modelData)
+                                }
+                            }
+                        }
+                    }
+                }
+            }
         }
 
         // Status label
@@ -184,5 +402,11 @@ Item {
         function onRotateChanged() {
             if (configManager) rotateSpin.value = configManager.rotate
         }
+        function onMulticastChanged() {
+            if (!configManager) return
+            multicastSwitch.checked = configManager.multicastEnabled
+            multicastGroupInput.text = configManager.multicastGroup
+            multicastIfaceInput.text = configManager.multicastInterface
+        }
     }
 }
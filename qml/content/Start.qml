@@ -36,7 +36,29 @@ Item {
         anchors.centerIn: parent
         width: 450
         height: 350
-        standardButtons: Dialog.Cancel
+
+        footer: DialogButtonBox {
+            Button {
+                text: "View All"
+                DialogButtonBox.buttonRole: DialogButtonBox.ActionRole
+                onClicked: {
+                    // Receive every discovered camera at once in the grid view
+                    if (sessionManager && mdnsManager) {
+                        sessionManager.clear()
+                        for (var i = 0; i < mdnsManager.discoveredCameras.length; i++) {
+                            sessionManager.addCamera(mdnsManager.discoveredCameras[i])
+                        }
+                        if (logManager) logManager.logMessage("Opening multi view with " + sessionManager.sessionCount + " cameras")
+                    }
+                    cameraSelectionDialog.close()
+                    mainWindow.openMultiView()
+                }
+            }
+            Button {
+                text: "Cancel"
+                DialogButtonBox.buttonRole: DialogButtonBox.RejectRole
+            }
+        }
 
         ColumnLayout {
             anchors.fill: parent
@@ -702,6 +724,9 @@ Item {
                     return notBusy && notDiscovering
                 }
                 onClicked: {
+                    // Spans the whole flow in a trace, ended by the result handlers below
+                    if (traceManager) traceManager.beginSpan("Connect Camera")
+
                     // If camera already found via mDNS, connect via gRPC
                     if (mdnsManager && mdnsManager.cameraFound && mdnsManager.cameraIp) {
                         // Detect local IP for the camera's subnet
@@ -748,14 +773,15 @@ Item {
                     target: grpcManager
                     function onHealthCheckResult(success) {
                         if (success) {
-                            if (logManager) logManager.logMessage("Connect Camera: Health check OK, sending RX host IP...")
-                            // Now send the RX host IP to the camera
-                            var rxIp = configManager ? configManager.rxHostIp : "127.0.0.1"
+                            if (logManager) logManager.logMessage("Connect Camera: Health check OK, sending stream destination...")
+                            // Now send the RX host IP (or multicast group) to the camera
+                            var destination = configManager ? configManager.streamDestination : "127.0.0.1"
                             if (grpcManager) {
-                                grpcManager.updateHost(rxIp)
+                                grpcManager.updateHost(destination)
                             }
                         } else {
                             if (logManager) logManager.logMessage("Connect Camera: Connection failed. Check if camera is running.")
+                            if (traceManager) traceManager.endSpan("Connect Camera", "health check failed")
                         }
                     }
 
@@ -772,10 +798,12 @@ Item {
                             }
                         } else {
                             if (logManager) logManager.logMessage("Connect Camera: Failed to update host - " + message)
+                            if (traceManager) traceManager.endSpan("Connect Camera", "update host failed")
                         }
                     }
 
                     function onSwapResolutionResult(success, message, width, height) {
+                        if (traceManager) traceManager.endSpan("Connect Camera", success ? "connected" : "rotation failed")
                         if (success) {
                             if (logManager) logManager.logMessage("Connect Camera: Rotation applied successfully! Resolution: " + width + "x" + height)
                             // Save the settings after rotation is applied
@@ -816,6 +844,7 @@ Item {
                             }
                         } else if (!found) {
                             if (logManager) logManager.logMessage("Connect Camera: Camera not found via mDNS. Try connecting to camera WiFi network.")
+                            if (traceManager) traceManager.endSpan("Connect Camera", "camera not found")
                         }
                     }
                 }
@@ -271,6 +271,44 @@ Window {
         }
     }
     
+    // Multi-camera grid popup
+    Popup {
+        id: multiViewPopup
+        anchors.centerIn: parent
+        width: parent.width * 0.95
+        height: parent.height * 0.95
+        modal: true
+        focus: true
+        closePolicy: Popup.CloseOnEscape
+
+        background: Rectangle {
+            color: "white"
+            border.color: "#0031ff"
+            border.width: 2
+            radius: 10
+        }
+
+        Loader {
+            id: multiViewLoader
+            anchors.fill: parent
+            active: multiViewPopup.opened
+            source: "content/MultiView.qml"
+        }
+
+        // Close button for popup
+        Button {
+            anchors.right: parent.right
+            anchors.top: parent.top
+            anchors.margins: 10
+            width: 50
+            height: 50
+            text: "X"
+            font.bold: true
+            font.pixelSize: 24
+            onClicked: multiViewPopup.close()
+        }
+    }
+
     // Function to open settings
     function openSettings() {
         settingsPopup.open()
@@ -285,4 +323,9 @@ Window {
     function openCameraDisplay() {
         cameraDisplayPopup.open()
     }
+
+    // Function to open the multi-camera grid
+    function openMultiView() {
+        multiViewPopup.open()
+    }
 }
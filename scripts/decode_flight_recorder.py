@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Decode a flight recorder file (logs/flight.bin or logs/flight.prev.bin)
+written by F1sh Camera RX into readable text, oldest record first.
+
+Usage: decode_flight_recorder.py <flight.bin> [--no-metrics]
+"""
+
+import struct
+import sys
+from datetime import datetime
+
+MAGIC = b'F1SHFLT1'
+RECORD_HEADER = struct.Struct('<IHBBQq')
+
+SESSION_RECORD = 1
+LOG_RECORD = 2
+METRICS_RECORD = 3
+
+# Must match LogManager::Category and LogManager::Level
+CATEGORIES = ['general', 'stream', 'grpc', 'mdns', 'serial', 'wifi', 'config']
+LEVELS = ['debug', 'info', 'warning', 'error']
+
+
+def format_time(ms):
+    """Format milliseconds since epoch as local time."""
+    return datetime.fromtimestamp(ms / 1000.0).strftime('%Y-%m-%d %H:%M:%S.%f')[:-3]
+
+
+def read_records(data):
+    """Return (header, records) with records sorted by sequence number."""
+    if len(data) < 36 or data[:8] != MAGIC:
+        raise ValueError('not a flight recorder file')
+    version, header_size, block_size, block_count, created_ms, pid = struct.unpack_from('<IIIIqI', data, 8)
+    if version != 1:
+        raise ValueError(f'unsupported version {version}')
+
+    records = []
+    for block in range(block_count):
+        start = header_size + block * block_size
+        offset = 0
+        # A zero length ends the block, including a record cut short by a crash
+        while offset + RECORD_HEADER.size <= block_size:
+            length, rtype, level, category, seq, timestamp = RECORD_HEADER.unpack_from(data, start + offset)
+            if length < RECORD_HEADER.size or offset + length > block_size:
+                break
+            payload = data[start + offset + RECORD_HEADER.size:start + offset + length]
+            records.append((seq, rtype, level, category, timestamp, payload.decode('utf-8', 'replace')))
+            offset += (length + 7) & ~7
+
+    records.sort(key=lambda r: r[0])
+    return {'created': created_ms, 'pid': pid}, records
+
+
+def main():
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    show_metrics = '--no-metrics' not in sys.argv
+    if len(args) != 1:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    with open(args[0], 'rb') as f:
+        data = f.read()
+    try:
+        header, records = read_records(data)
+    except ValueError as e:
+        print(f'{args[0]}: {e}', file=sys.stderr)
+        return 1
+
+    print(f'# created {format_time(header["created"])}, pid {header["pid"]}, {len(records)} records')
+    for seq, rtype, level, category, timestamp, text in records:
+        when = format_time(timestamp)
+        if rtype == SESSION_RECORD:
+            print(f'[{when}] === {text}')
+        elif rtype == LOG_RECORD:
+            cat = CATEGORIES[category] if category < len(CATEGORIES) else str(category)
+            lvl = LEVELS[level] if level < len(LEVELS) else str(level)
+            print(f'[{when}] [{cat}] {lvl}: {text}')
+        elif rtype == METRICS_RECORD and show_metrics:
+            for line in text.splitlines():
+                print(f'[{when}] metric {line}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Minimal mDNS responder that advertises fake _f1sh-camera._tcp instances, for
+exercising discovery without camera hardware (locally or on a CI runner with
+multicast-capable networking).
+
+Usage: mdns_test_responder.py [--count N] [--name PREFIX] [--address IPV4]
+                              [--port PORT] [--protocol udp] [--encoding h264]
+                              [--control-port 50051] [--ttl SECONDS]
+
+Answers PTR queries for the service with PTR records plus SRV, TXT and A
+records in the additional section, and answers direct SRV/TXT/A questions.
+Sends goodbye packets (TTL 0) on Ctrl+C.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+MDNS_GROUP = '224.0.0.251'
+MDNS_PORT = 5353
+SERVICE = '_f1sh-camera._tcp.local'
+
+TYPE_A, TYPE_PTR, TYPE_TXT, TYPE_SRV, TYPE_ANY = 1, 12, 16, 33, 255
+CLASS_IN = 1
+CACHE_FLUSH = 0x8000
+
+
+def encode_name(labels):
+    """Encode a list of labels as an uncompressed DNS name."""
+    out = b''
+    for label in labels:
+        raw = label.encode('utf-8')
+        out += bytes([len(raw)]) + raw
+    return out + b'\0'
+
+
+def read_name(packet, pos):
+    """Decode a possibly compressed name; returns (labels, next position)."""
+    labels, end, jumps = [], None, 0
+    while True:
+        length = packet[pos]
+        if length == 0:
+            pos += 1
+            break
+        if length & 0xC0 == 0xC0:
+            if end is None:
+                end = pos + 2
+            pos = ((length & 0x3F) << 8) | packet[pos + 1]
+            jumps += 1
+            if jumps > 16:
+                raise ValueError('compression loop')
+            continue
+        labels.append(packet[pos + 1:pos + 1 + length].decode('utf-8', 'replace'))
+        pos += 1 + length
+    return labels, (end if end is not None else pos)
+
+
+def record(labels, rtype, ttl, rdata, flush=True):
+    rclass = CLASS_IN | (CACHE_FLUSH if flush else 0)
+    return encode_name(labels) + struct.pack('!HHIH', rtype, rclass, ttl, len(rdata)) + rdata
+
+
+class Responder:
+    def __init__(self, args):
+        self.args = args
+        self.service = SERVICE.split('.')
+        self.instances = []
+        for i in range(args.count):
+            name = args.name if args.count == 1 else f'{args.name} {i + 1}'
+            host = f'f1sh-test-{i + 1}'
+            self.instances.append({
+                'name': name,
+                'labels': [name] + self.service,
+                'host': [host, 'local'],
+                'port': args.port,
+            })
+
+    def records_for(self, instance, ttl):
+        txt = b''
+        for entry in (f'protocol={self.args.protocol}', f'encoding={self.args.encoding}',
+                      f'control_port={self.args.control_port}'):
+            raw = entry.encode()
+            txt += bytes([len(raw)]) + raw
+        srv = struct.pack('!HHH', 0, 0, instance['port']) + encode_name(instance['host'])
+        return {
+            'ptr': record(self.service, TYPE_PTR, ttl, encode_name(instance['labels']), flush=False),
+            'srv': record(instance['labels'], TYPE_SRV, ttl, srv),
+            'txt': record(instance['labels'], TYPE_TXT, ttl, txt),
+            'a': record(instance['host'], TYPE_A, ttl, socket.inet_aton(self.args.address)),
+        }
+
+    def response(self, answers, additional, query_id=0):
+        header = struct.pack('!HHHHHH', query_id, 0x8400, 0, len(answers), 0, len(additional))
+        return header + b''.join(answers) + b''.join(additional)
+
+    def answer(self, packet):
+        """Build a response to a query packet, or None if nothing matches."""
+        query_id, flags, qdcount = struct.unpack_from('!HHH', packet, 0)
+        if flags & 0x8000:
+            return None
+        pos = 12
+        answers, additional = [], []
+        for _ in range(qdcount):
+            labels, pos = read_name(packet, pos)
+            qtype, _ = struct.unpack_from('!HH', packet, pos)
+            pos += 4
+            name = [label.lower() for label in labels]
+            for instance in self.instances:
+                recs = self.records_for(instance, self.args.ttl)
+                if name == [label.lower() for label in self.service] and qtype in (TYPE_PTR, TYPE_ANY):
+                    answers.append(recs['ptr'])
+                    additional += [recs['srv'], recs['txt'], recs['a']]
+                elif name == [label.lower() for label in instance['labels']]:
+                    if qtype in (TYPE_SRV, TYPE_ANY):
+                        answers.append(recs['srv'])
+                        additional.append(recs['a'])
+                    if qtype in (TYPE_TXT, TYPE_ANY):
+                        answers.append(recs['txt'])
+                elif name == [label.lower() for label in instance['host']] and qtype in (TYPE_A, TYPE_ANY):
+                    answers.append(recs['a'])
+        if not answers:
+            return None
+        additional = [r for r in dict.fromkeys(additional) if r not in answers]
+        return self.response(list(dict.fromkeys(answers)), additional, query_id)
+
+    def goodbye(self):
+        answers = []
+        for instance in self.instances:
+            answers += self.records_for(instance, 0).values()
+        return self.response(answers, [])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Advertise fake F1sh cameras over mDNS')
+    parser.add_argument('--count', type=int, default=1)
+    parser.add_argument('--name', default='F1sh Test Camera')
+    parser.add_argument('--address', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8888)
+    parser.add_argument('--protocol', default='udp')
+    parser.add_argument('--encoding', default='h264')
+    parser.add_argument('--control-port', type=int, default=50051)
+    parser.add_argument('--ttl', type=int, default=120)
+    args = parser.parse_args()
+
+    responder = Responder(args)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, 'SO_REUSEPORT'):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.bind(('', MDNS_PORT))
+    membership = socket.inet_aton(MDNS_GROUP) + socket.inet_aton('0.0.0.0')
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 255)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+
+    print(f'Advertising {args.count} instance(s) of {SERVICE} at {args.address}:{args.port}', flush=True)
+    try:
+        while True:
+            packet, sender = sock.recvfrom(9000)
+            try:
+                reply = responder.answer(packet)
+            except (IndexError, struct.error, ValueError):
+                continue
+            if reply is None:
+                continue
+            # Legacy unicast queries (source port other than 5353) get a unicast reply
+            destination = (MDNS_GROUP, MDNS_PORT) if sender[1] == MDNS_PORT else sender
+            sock.sendto(reply, destination)
+    except KeyboardInterrupt:
+        sock.sendto(responder.goodbye(), (MDNS_GROUP, MDNS_PORT))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
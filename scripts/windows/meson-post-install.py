@@ -101,7 +101,7 @@ def copy_gstreamer_plugins(dest_plugin_dir, ucrt64_root, ntldd_exe, copied_dlls,
     # Keep this list aligned with src/streammanager.cpp decoder candidates.
     required_plugins = {
         # Core elements
-        'libgstcoreelements.dll',       # queue, capsfilter
+        'libgstcoreelements.dll',       # queue, capsfilter, tee, filesink
         'libgstapp.dll',                # appsink
 
         # RTP/UDP streaming
@@ -126,6 +126,10 @@ def copy_gstreamer_plugins(dest_plugin_dir, ucrt64_root, ntldd_exe, copied_dlls,
         'libgstvideoconvertscale.dll',  # videoconvert, videoscale
         'libgstvideofilter.dll',        # videoflip
 
+        # Recording muxers
+        'libgstisomp4.dll',             # mp4mux
+        'libgstmatroska.dll',           # matroskamux
+
         # Type finding
         'libgsttypefindfunctions.dll',
     }
@@ -0,0 +1,443 @@
+#include "colorconvert.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLORCONVERT_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// AVX2 is compiled per-function and selected at runtime
+#define COLORCONVERT_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COLORCONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ColorConvert {
+
+namespace {
+
+// Q6 fixed-point YUV -> RGB coefficients. All kernels use the same integer
+// arithmetic so SIMD and scalar output are bit-identical.
+struct Coefficients {
+    int yOffset;
+    int yScale;
+    int rv;
+    int gu;
+    int gv;
+    int bu;
+};
+
+const Coefficients kBt601Limited = { 16, 75, 102, -25, -52, 129 };
+const Coefficients kBt709Limited = { 16, 75, 115, -14, -34, 135 };
+const Coefficients kBt601Full    = {  0, 64,  90, -22, -46, 113 };
+const Coefficients kBt709Full    = {  0, 64, 101, -12, -30, 119 };
+
+// Converts count pixels of one row. For I420 u/v point at the chroma sample of
+// the first pixel; for NV12 u points at its interleaved UV pair and v is unused.
+using RowKernel = void (*)(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+                           int count, quint32 *dst, const Coefficients &c);
+
+inline quint32 clampToByte(int value)
+{
+    return value < 0 ? 0u : (value > 255 ? 255u : static_cast<quint32>(value));
+}
+
+inline quint32 yuvToRgb32(int y, int u, int v, const Coefficients &c)
+{
+    int yTerm = (y - c.yOffset) * c.yScale + 32;
+    u -= 128;
+    v -= 128;
+
+    int r = (yTerm + c.rv * v) >> 6;
+    int g = (yTerm + c.gu * u + c.gv * v) >> 6;
+    int b = (yTerm + c.bu * u) >> 6;
+
+    return 0xff000000u | (clampToByte(r) << 16) | (clampToByte(g) << 8) | clampToByte(b);
+}
+
+void rowScalarFrom(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+                   int from, int count, quint32 *dst, const Coefficients &c)
+{
+    for (int x = from; x < count; ++x) {
+        int chroma = x / 2;
+        int uValue = nv12 ? u[chroma * 2] : u[chroma];
+        int vValue = nv12 ? u[chroma * 2 + 1] : v[chroma];
+        dst[x] = yuvToRgb32(y[x], uValue, vValue, c);
+    }
+}
+
+void rowScalar(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+               int count, quint32 *dst, const Coefficients &c)
+{
+    rowScalarFrom(y, u, v, nv12, 0, count, dst, c);
+}
+
+#ifdef COLORCONVERT_SSE2
+// 16 pixels per iteration
+void rowSse2(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+             int count, quint32 *dst, const Coefficients &c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i round = _mm_set1_epi16(32);
+    const __m128i yOffset = _mm_set1_epi16(static_cast<short>(c.yOffset));
+    const __m128i yScale = _mm_set1_epi16(static_cast<short>(c.yScale));
+    const __m128i rv = _mm_set1_epi16(static_cast<short>(c.rv));
+    const __m128i gu = _mm_set1_epi16(static_cast<short>(c.gu));
+    const __m128i gv = _mm_set1_epi16(static_cast<short>(c.gv));
+    const __m128i bu = _mm_set1_epi16(static_cast<short>(c.bu));
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xff));
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i uw;
+        __m128i vw;
+        if (nv12) {
+            __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+            uw = _mm_and_si128(uv, lowMask);
+            vw = _mm_srli_epi16(uv, 8);
+        } else {
+            uw = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)), zero);
+            vw = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)), zero);
+        }
+        uw = _mm_sub_epi16(uw, bias);
+        vw = _mm_sub_epi16(vw, bias);
+
+        __m128i rc = _mm_mullo_epi16(vw, rv);
+        __m128i gc = _mm_add_epi16(_mm_mullo_epi16(uw, gu), _mm_mullo_epi16(vw, gv));
+        __m128i bc = _mm_mullo_epi16(uw, bu);
+
+        // Each chroma sample covers two horizontal pixels
+        __m128i rcLo = _mm_unpacklo_epi16(rc, rc);
+        __m128i rcHi = _mm_unpackhi_epi16(rc, rc);
+        __m128i gcLo = _mm_unpacklo_epi16(gc, gc);
+        __m128i gcHi = _mm_unpackhi_epi16(gc, gc);
+        __m128i bcLo = _mm_unpacklo_epi16(bc, bc);
+        __m128i bcHi = _mm_unpackhi_epi16(bc, bc);
+
+        __m128i yv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        __m128i yLo = _mm_unpacklo_epi8(yv, zero);
+        __m128i yHi = _mm_unpackhi_epi8(yv, zero);
+        yLo = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(yLo, yOffset), yScale), round);
+        yHi = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(yHi, yOffset), yScale), round);
+
+        __m128i r = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(yLo, rcLo), 6),
+                                     _mm_srai_epi16(_mm_adds_epi16(yHi, rcHi), 6));
+        __m128i g = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(yLo, gcLo), 6),
+                                     _mm_srai_epi16(_mm_adds_epi16(yHi, gcHi), 6));
+        __m128i b = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(yLo, bcLo), 6),
+                                     _mm_srai_epi16(_mm_adds_epi16(yHi, bcHi), 6));
+
+        // Interleave to B,G,R,A bytes (0xffRRGGBB little-endian)
+        __m128i bgLo = _mm_unpacklo_epi8(b, g);
+        __m128i bgHi = _mm_unpackhi_epi8(b, g);
+        __m128i raLo = _mm_unpacklo_epi8(r, alpha);
+        __m128i raHi = _mm_unpackhi_epi8(r, alpha);
+
+        __m128i *out = reinterpret_cast<__m128i*>(dst + x);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(bgLo, raLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+    }
+
+    rowScalarFrom(y, u, v, nv12, x, count, dst, c);
+}
+#endif
+
+#ifdef COLORCONVERT_AVX2
+// 32 pixels per iteration; remainder is handed to the SSE2 kernel
+__attribute__((target("avx2")))
+void rowAvx2(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+             int count, quint32 *dst, const Coefficients &c)
+{
+    const __m256i lowMask = _mm256_set1_epi16(0x00ff);
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i round = _mm256_set1_epi16(32);
+    const __m256i yOffset = _mm256_set1_epi16(static_cast<short>(c.yOffset));
+    const __m256i yScale = _mm256_set1_epi16(static_cast<short>(c.yScale));
+    const __m256i rv = _mm256_set1_epi16(static_cast<short>(c.rv));
+    const __m256i gu = _mm256_set1_epi16(static_cast<short>(c.gu));
+    const __m256i gv = _mm256_set1_epi16(static_cast<short>(c.gv));
+    const __m256i bu = _mm256_set1_epi16(static_cast<short>(c.bu));
+    const __m256i alpha = _mm256_set1_epi8(static_cast<char>(0xff));
+
+    int x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i uw;
+        __m256i vw;
+        if (nv12) {
+            __m256i uv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x));
+            uw = _mm256_and_si256(uv, lowMask);
+            vw = _mm256_srli_epi16(uv, 8);
+        } else {
+            uw = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x / 2)));
+            vw = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x / 2)));
+        }
+        uw = _mm256_sub_epi16(uw, bias);
+        vw = _mm256_sub_epi16(vw, bias);
+
+        __m256i rc = _mm256_mullo_epi16(vw, rv);
+        __m256i gc = _mm256_add_epi16(_mm256_mullo_epi16(uw, gu), _mm256_mullo_epi16(vw, gv));
+        __m256i bc = _mm256_mullo_epi16(uw, bu);
+
+        // Duplicate chroma per pixel pair. unpack works per 128-bit lane, so
+        // recombine lanes to get pixels 0-15 in *Lo and 16-31 in *Hi.
+        __m256i t0 = _mm256_unpacklo_epi16(rc, rc);
+        __m256i t1 = _mm256_unpackhi_epi16(rc, rc);
+        __m256i rcLo = _mm256_permute2x128_si256(t0, t1, 0x20);
+        __m256i rcHi = _mm256_permute2x128_si256(t0, t1, 0x31);
+        t0 = _mm256_unpacklo_epi16(gc, gc);
+        t1 = _mm256_unpackhi_epi16(gc, gc);
+        __m256i gcLo = _mm256_permute2x128_si256(t0, t1, 0x20);
+        __m256i gcHi = _mm256_permute2x128_si256(t0, t1, 0x31);
+        t0 = _mm256_unpacklo_epi16(bc, bc);
+        t1 = _mm256_unpackhi_epi16(bc, bc);
+        __m256i bcLo = _mm256_permute2x128_si256(t0, t1, 0x20);
+        __m256i bcHi = _mm256_permute2x128_si256(t0, t1, 0x31);
+
+        __m256i yLo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+        __m256i yHi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x + 16)));
+        yLo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(yLo, yOffset), yScale), round);
+        yHi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(yHi, yOffset), yScale), round);
+
+        // packus leaves lanes as [0-7, 16-23 | 8-15, 24-31]
+        __m256i r = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_adds_epi16(yLo, rcLo), 6),
+                                        _mm256_srai_epi16(_mm256_adds_epi16(yHi, rcHi), 6));
+        __m256i g = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_adds_epi16(yLo, gcLo), 6),
+                                        _mm256_srai_epi16(_mm256_adds_epi16(yHi, gcHi), 6));
+        __m256i b = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_adds_epi16(yLo, bcLo), 6),
+                                        _mm256_srai_epi16(_mm256_adds_epi16(yHi, bcHi), 6));
+
+        // bgLo/raLo hold pixels [0-7 | 8-15], bgHi/raHi hold [16-23 | 24-31]
+        __m256i bgLo = _mm256_unpacklo_epi8(b, g);
+        __m256i bgHi = _mm256_unpackhi_epi8(b, g);
+        __m256i raLo = _mm256_unpacklo_epi8(r, alpha);
+        __m256i raHi = _mm256_unpackhi_epi8(r, alpha);
+
+        __m256i p0 = _mm256_unpacklo_epi16(bgLo, raLo);  // [0-3 | 8-11]
+        __m256i p1 = _mm256_unpackhi_epi16(bgLo, raLo);  // [4-7 | 12-15]
+        __m256i p2 = _mm256_unpacklo_epi16(bgHi, raHi);  // [16-19 | 24-27]
+        __m256i p3 = _mm256_unpackhi_epi16(bgHi, raHi);  // [20-23 | 28-31]
+
+        __m256i *out = reinterpret_cast<__m256i*>(dst + x);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+
+    if (x < count) {
+        rowSse2(y + x, nv12 ? u + x : u + x / 2, nv12 ? v : v + x / 2, nv12,
+                count - x, dst + x, c);
+    }
+}
+#endif
+
+#ifdef COLORCONVERT_NEON
+// 16 pixels per iteration
+void rowNeon(const quint8 *y, const quint8 *u, const quint8 *v, bool nv12,
+             int count, quint32 *dst, const Coefficients &c)
+{
+    const int16x8_t bias = vdupq_n_s16(128);
+    const int16x8_t round = vdupq_n_s16(32);
+    const int16x8_t yOffset = vdupq_n_s16(static_cast<int16_t>(c.yOffset));
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        int16x8_t uw;
+        int16x8_t vw;
+        if (nv12) {
+            uint8x8x2_t uv = vld2_u8(u + x);
+            uw = vreinterpretq_s16_u16(vmovl_u8(uv.val[0]));
+            vw = vreinterpretq_s16_u16(vmovl_u8(uv.val[1]));
+        } else {
+            uw = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x / 2)));
+            vw = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + x / 2)));
+        }
+        uw = vsubq_s16(uw, bias);
+        vw = vsubq_s16(vw, bias);
+
+        int16x8_t rc = vmulq_n_s16(vw, static_cast<int16_t>(c.rv));
+        int16x8_t gc = vmlaq_n_s16(vmulq_n_s16(uw, static_cast<int16_t>(c.gu)), vw, static_cast<int16_t>(c.gv));
+        int16x8_t bc = vmulq_n_s16(uw, static_cast<int16_t>(c.bu));
+
+        // Each chroma sample covers two horizontal pixels
+        int16x8x2_t rcz = vzipq_s16(rc, rc);
+        int16x8x2_t gcz = vzipq_s16(gc, gc);
+        int16x8x2_t bcz = vzipq_s16(bc, bc);
+
+        uint8x16_t yv = vld1q_u8(y + x);
+        int16x8_t yLo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(yv)));
+        int16x8_t yHi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(yv)));
+        yLo = vaddq_s16(vmulq_n_s16(vsubq_s16(yLo, yOffset), static_cast<int16_t>(c.yScale)), round);
+        yHi = vaddq_s16(vmulq_n_s16(vsubq_s16(yHi, yOffset), static_cast<int16_t>(c.yScale)), round);
+
+        uint8x16x4_t bgra;
+        bgra.val[0] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, bcz.val[0]), 6),
+                                  vqshrun_n_s16(vqaddq_s16(yHi, bcz.val[1]), 6));
+        bgra.val[1] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, gcz.val[0]), 6),
+                                  vqshrun_n_s16(vqaddq_s16(yHi, gcz.val[1]), 6));
+        bgra.val[2] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, rcz.val[0]), 6),
+                                  vqshrun_n_s16(vqaddq_s16(yHi, rcz.val[1]), 6));
+        bgra.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + x), bgra);
+    }
+
+    rowScalarFrom(y, u, v, nv12, x, count, dst, c);
+}
+#endif
+
+struct KernelChoice {
+    RowKernel kernel;
+    const char *name;
+};
+
+KernelChoice selectKernel()
+{
+#ifdef COLORCONVERT_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { rowAvx2, "AVX2" };
+    }
+#endif
+#ifdef COLORCONVERT_SSE2
+    return { rowSse2, "SSE2" };
+#elif defined(COLORCONVERT_NEON)
+    return { rowNeon, "NEON" };
+#else
+    return { rowScalar, "scalar" };
+#endif
+}
+
+const KernelChoice &kernelChoice()
+{
+    static const KernelChoice choice = selectKernel();
+    return choice;
+}
+
+// Source tile converted before being scattered to its rotated position.
+// 16 x 128 RGB32 pixels = 8 KB, so a tile stays in L1 while it is transposed
+// and each destination row receives a full 64-byte line per tile.
+constexpr int kTileRows = 16;
+constexpr int kTileCols = 128;
+
+inline quint32 *dstRow(quint8 *dst, int dstStride, int row)
+{
+    return reinterpret_cast<quint32*>(dst + static_cast<qsizetype>(row) * dstStride);
+}
+
+void convertSegment(const YuvImage &src, int row, int x0, int count, quint32 *out,
+                    RowKernel kernel, const Coefficients &c)
+{
+    const quint8 *y = src.y + static_cast<qsizetype>(row) * src.strideY + x0;
+    const int chromaRow = row / 2;
+
+    if (src.layout == Layout::NV12) {
+        const quint8 *uv = src.u + static_cast<qsizetype>(chromaRow) * src.strideU + x0;
+        kernel(y, uv, nullptr, true, count, out, c);
+    } else {
+        const quint8 *u = src.u + static_cast<qsizetype>(chromaRow) * src.strideU + x0 / 2;
+        const quint8 *v = src.v + static_cast<qsizetype>(chromaRow) * src.strideV + x0 / 2;
+        kernel(y, u, v, false, count, out, c);
+    }
+}
+
+template <int Rotation>
+void convertRotated(const YuvImage &src, quint8 *dst, int dstStride,
+                    RowKernel kernel, const Coefficients &c)
+{
+    const int w = src.width;
+    const int h = src.height;
+
+    if constexpr (Rotation == 0) {
+        for (int row = 0; row < h; ++row) {
+            convertSegment(src, row, 0, w, dstRow(dst, dstStride, row), kernel, c);
+        }
+    } else if constexpr (Rotation == 2) {
+        // 180: convert a row, then write it reversed to the mirrored row
+        std::vector<quint32> line(static_cast<size_t>(w));
+        for (int row = 0; row < h; ++row) {
+            convertSegment(src, row, 0, w, line.data(), kernel, c);
+            std::reverse_copy(line.begin(), line.end(), dstRow(dst, dstStride, h - 1 - row));
+        }
+    } else {
+        quint32 tile[kTileRows * kTileCols];
+
+        for (int ty = 0; ty < h; ty += kTileRows) {
+            const int rows = std::min(kTileRows, h - ty);
+
+            for (int tx = 0; tx < w; tx += kTileCols) {
+                const int cols = std::min(kTileCols, w - tx);
+
+                for (int r = 0; r < rows; ++r) {
+                    convertSegment(src, ty + r, tx, cols, tile + r * kTileCols, kernel, c);
+                }
+
+                for (int col = 0; col < cols; ++col) {
+                    const int sx = tx + col;
+                    if constexpr (Rotation == 1) {
+                        // Clockwise: (sx, sy) -> (h - 1 - sy, sx)
+                        quint32 *out = dstRow(dst, dstStride, sx) + (h - 1 - ty);
+                        for (int r = 0; r < rows; ++r) {
+                            out[-r] = tile[r * kTileCols + col];
+                        }
+                    } else {
+                        // Counter-clockwise: (sx, sy) -> (sy, w - 1 - sx)
+                        quint32 *out = dstRow(dst, dstStride, w - 1 - sx) + ty;
+                        for (int r = 0; r < rows; ++r) {
+                            out[r] = tile[r * kTileCols + col];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool convert(const YuvImage &src, int rotate, quint8 *dst, int dstStride, RowKernel kernel)
+{
+    if (!dst || !src.y || !src.u || src.width <= 0 || src.height <= 0) {
+        return false;
+    }
+    if (src.layout == Layout::I420 && !src.v) {
+        return false;
+    }
+
+    const Coefficients &c = src.matrix == Matrix::Bt601
+        ? (src.fullRange ? kBt601Full : kBt601Limited)
+        : (src.fullRange ? kBt709Full : kBt709Limited);
+
+    switch (rotate) {
+        case 0: convertRotated<0>(src, dst, dstStride, kernel, c); return true;
+        case 1: convertRotated<1>(src, dst, dstStride, kernel, c); return true;
+        case 2: convertRotated<2>(src, dst, dstStride, kernel, c); return true;
+        case 3: convertRotated<3>(src, dst, dstStride, kernel, c); return true;
+        default: return false;
+    }
+}
+
+} // namespace
+
+bool convertToRgb32(const YuvImage &src, int rotate, quint8 *dst, int dstStride)
+{
+    return convert(src, rotate, dst, dstStride, kernelChoice().kernel);
+}
+
+bool convertToRgb32Scalar(const YuvImage &src, int rotate, quint8 *dst, int dstStride)
+{
+    return convert(src, rotate, dst, dstStride, rowScalar);
+}
+
+const char *implementationName()
+{
+    return kernelChoice().name;
+}
+
+} // namespace ColorConvert
@@ -0,0 +1,53 @@
+#ifndef COLORCONVERT_H
+#define COLORCONVERT_H
+
+#include <QtGlobal>
+
+// Fused YUV 4:2:0 -> RGB32 conversion and 0/90/180/270 rotation.
+//
+// Replaces "videoconvert ! videoflip ! videoconvert" on the appsink side with a
+// single pass: rows are converted in small cache-resident tiles by a SIMD row
+// kernel (AVX2/SSE2/NEON, scalar fallback) and written straight to their
+// rotated position. Output is QImage::Format_RGB32 (0xffRRGGBB), which Qt can
+// upload without a further conversion.
+namespace ColorConvert {
+
+enum class Layout {
+    I420,   // Planar Y, U, V
+    NV12    // Planar Y, interleaved UV
+};
+
+enum class Matrix {
+    Bt601,
+    Bt709
+};
+
+struct YuvImage {
+    Layout layout = Layout::I420;
+    Matrix matrix = Matrix::Bt709;
+    bool fullRange = false;
+    int width = 0;
+    int height = 0;
+    const quint8 *y = nullptr;
+    const quint8 *u = nullptr;   // UV plane for NV12
+    const quint8 *v = nullptr;   // Unused for NV12
+    int strideY = 0;
+    int strideU = 0;
+    int strideV = 0;
+};
+
+// rotate follows StreamManager: 0 = none, 1 = 90 clockwise, 2 = 180,
+// 3 = 90 counter-clockwise. dst must hold the rotated size
+// (height x width for 1 and 3). Returns false on invalid input.
+bool convertToRgb32(const YuvImage &src, int rotate, quint8 *dst, int dstStride);
+
+// Same conversion with the portable scalar kernel regardless of CPU. The SIMD
+// kernels must match it bit for bit; bench/colorconvert_bench.cpp checks that.
+bool convertToRgb32Scalar(const YuvImage &src, int rotate, quint8 *dst, int dstStride);
+
+// Name of the row kernel selected for this CPU, for logging
+const char *implementationName();
+
+} // namespace ColorConvert
+
+#endif // COLORCONVERT_H
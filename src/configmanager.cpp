@@ -1,5 +1,6 @@
 #include "configmanager.h"
 #include "logmanager.h"
+#include "trace.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -12,6 +13,7 @@
 #include <QCoreApplication>
 #include <QNetworkInterface>
 #include <QSerialPort>
+#include <QHostAddress>
 
 // Resolution presets (width, height)
 static const int kResolutionPresets[][2] = {
@@ -126,6 +128,7 @@ bool ConfigWorker::httpSendConfig(const QString &txServerIp, int txHttpPort,
 
 QByteArray ConfigWorker::sendSerialCommand(const QString &serialPort, const QString &command)
 {
+    TRACE_SCOPE("serial", "command", command.trimmed());
     if (serialPort.isEmpty()) {
         return QByteArray();
     }
@@ -173,7 +176,7 @@ QByteArray ConfigWorker::sendSerialCommand(const QString &serialPort, const QStr
 bool ConfigWorker::sendRotateViaSerial(const QString &serialPort, int rotate)
 {
     if (serialPort.isEmpty()) {
-        LogManager::log("Cannot send rotation: No serial port connected");
+        LOG_WARNING(Config, "Cannot send rotation: No serial port connected");
         return false;
     }
 
@@ -182,30 +185,30 @@ bool ConfigWorker::sendRotateViaSerial(const QString &serialPort, int rotate)
     int swap = (rotate == 1 || rotate == 3) ? 1 : 0;
 
     QString command = QString("{\"status\":24,\"payload\":{\"swap\":%1}}\n").arg(swap);
-    LogManager::log(QString("Sending rotation via serial (status 24, swap=%1)").arg(swap));
+    LOG_INFO(Config, QString("Sending rotation via serial (status 24, swap=%1)").arg(swap));
 
     QByteArray response = sendSerialCommand(serialPort, command);
 
     if (response.isEmpty()) {
-        LogManager::log("No response to rotation command (this may be OK)");
+        LOG_INFO(Config, "No response to rotation command (this may be OK)");
         // No response expected for status 24 according to protocol
         return true;
     }
 
-    LogManager::log(QString("Rotation command response: %1").arg(QString::fromUtf8(response).trimmed()));
+    LOG_DEBUG(Config, QString("Rotation command response: %1").arg(QString::fromUtf8(response).trimmed()));
     return true;
 }
 
 void ConfigWorker::doTestConnection(const QString &host, int port)
 {
-    LogManager::log(QString("Testing connection to TX server at %1...").arg(host));
+    LOG_INFO(Config, QString("Testing connection to TX server at %1...").arg(host));
 
     bool success = httpTestConnection(host, port);
 
     if (success) {
-        LogManager::log("TX server connection successful");
+        LOG_INFO(Config, "TX server connection successful");
     } else {
-        LogManager::log("TX server connection failed");
+        LOG_WARNING(Config, "TX server connection failed");
     }
 
     emit testConnectionFinished(success);
@@ -215,15 +218,15 @@ void ConfigWorker::doSaveConfig(const QString &serialPort, const QString &txServ
                                  const QString &rxHostIp, int rxStreamPort,
                                  int width, int height, int framerate, int rotate)
 {
-    LogManager::log("Saving configuration...");
-    LogManager::log(QString("Config: %1x%2 @ %3fps, rotate=%4").arg(width).arg(height).arg(framerate).arg(rotate));
+    LOG_INFO(Config, "Saving configuration...");
+    LOG_INFO(Config, QString("Config: %1x%2 @ %3fps, rotate=%4").arg(width).arg(height).arg(framerate).arg(rotate));
 
     QString statusMessage;
 
     // If we have a serial port, send rotation via serial protocol (status 24)
     if (!serialPort.isEmpty()) {
         if (!sendRotateViaSerial(serialPort, rotate)) {
-            LogManager::log("Warning: Failed to send rotation via serial");
+            LOG_WARNING(Config, "Failed to send rotation via serial");
             // Continue anyway - save locally
         }
     }
@@ -232,16 +235,16 @@ void ConfigWorker::doSaveConfig(const QString &serialPort, const QString &txServ
     if (!txServerIp.isEmpty() && txServerIp != "192.168.4.1") {
         if (httpTestConnection(txServerIp, txHttpPort)) {
             if (httpSendConfig(txServerIp, txHttpPort, rxHostIp, rxStreamPort, width, height, framerate)) {
-                LogManager::log("Configuration sent to TX server via HTTP");
+                LOG_INFO(Config, "Configuration sent to TX server via HTTP");
             } else {
-                LogManager::log("Warning: Failed to send config via HTTP");
+                LOG_WARNING(Config, "Failed to send config via HTTP");
             }
         } else {
-            LogManager::log("TX server not reachable via HTTP (this is OK if using serial)");
+            LOG_INFO(Config, "TX server not reachable via HTTP (this is OK if using serial)");
         }
     }
 
-    LogManager::log("Configuration saved successfully");
+    LOG_INFO(Config, "Configuration saved successfully");
     emit saveConfigFinished(true, "Configuration saved");
 }
 
@@ -383,6 +386,46 @@ void ConfigManager::setRxHostIp(const QString &ip)
     if (m_rxHostIp != ip) {
         m_rxHostIp = ip;
         emit rxHostIpChanged();
+        if (!m_multicastEnabled) {
+            emit streamDestinationChanged();
+        }
+    }
+}
+
+void ConfigManager::setMulticastEnabled(bool enabled)
+{
+    if (m_multicastEnabled != enabled) {
+        m_multicastEnabled = enabled;
+        emit multicastChanged();
+        emit streamDestinationChanged();
+    }
+}
+
+void ConfigManager::setMulticastGroup(const QString &group)
+{
+    if (m_multicastGroup == group) {
+        return;
+    }
+
+    if (!QHostAddress(group).isMulticast()) {
+        LOG_INFO(Config, QString("Config: '%1' is not a multicast address, keeping %2")
+                        .arg(group, m_multicastGroup));
+        emit multicastChanged();
+        return;
+    }
+
+    m_multicastGroup = group;
+    emit multicastChanged();
+    if (m_multicastEnabled) {
+        emit streamDestinationChanged();
+    }
+}
+
+void ConfigManager::setMulticastInterface(const QString &iface)
+{
+    if (m_multicastInterface != iface) {
+        m_multicastInterface = iface;
+        emit multicastChanged();
     }
 }
 
@@ -504,6 +547,9 @@ void ConfigManager::loadSettings()
     m_rotate = m_settings->value("rotate", 0).toInt();
     m_grpcServerAddress = m_settings->value("grpcServerAddress", "192.168.4.1:50051").toString();
     m_useGrpc = m_settings->value("useGrpc", true).toBool();
+    m_multicastEnabled = m_settings->value("multicastEnabled", false).toBool();
+    m_multicastGroup = m_settings->value("multicastGroup", m_multicastGroup).toString();
+    m_multicastInterface = m_settings->value("multicastInterface", QString()).toString();
 
     applyResolutionSelection();
     applyFramerateSelection();
@@ -515,6 +561,8 @@ void ConfigManager::loadSettings()
     emit rotateChanged();
     emit grpcServerAddressChanged();
     emit useGrpcChanged();
+    emit multicastChanged();
+    emit streamDestinationChanged();
 
     qDebug() << "Settings loaded - TX:" << m_txServerIp << "RX:" << m_rxHostIp
              << "Resolution:" << m_width << "x" << m_height
@@ -531,6 +579,9 @@ void ConfigManager::saveSettings()
     m_settings->setValue("rotate", m_rotate);
     m_settings->setValue("grpcServerAddress", m_grpcServerAddress);
     m_settings->setValue("useGrpc", m_useGrpc);
+    m_settings->setValue("multicastEnabled", m_multicastEnabled);
+    m_settings->setValue("multicastGroup", m_multicastGroup);
+    m_settings->setValue("multicastInterface", m_multicastInterface);
     m_settings->sync();
 
     qDebug() << "Settings saved to local storage";
@@ -578,7 +629,7 @@ void ConfigManager::saveConfig()
 
     // Trigger worker thread
     emit startSaveConfig(m_serialPort, m_txServerIp, m_txHttpPort,
-                         m_rxHostIp, m_rxStreamPort,
+                         streamDestination(), m_rxStreamPort,
                          m_width, m_height, m_framerate, m_rotate);
 }
 
@@ -621,7 +672,11 @@ void ConfigManager::loadConfigFromCamera()
 void ConfigManager::onLoadConfigFinished(bool success, const QString &rxHostIp, int resolutionIndex, int framerateIndex)
 {
     if (success) {
-        if (!rxHostIp.isEmpty()) {
+        // A camera already sending to a group means multicast is in use
+        if (QHostAddress(rxHostIp).isMulticast()) {
+            setMulticastGroup(rxHostIp);
+            setMulticastEnabled(true);
+        } else if (!rxHostIp.isEmpty()) {
             setRxHostIp(rxHostIp);
         }
         if (resolutionIndex >= 0) {
@@ -673,7 +728,7 @@ QString ConfigManager::detectLocalIp()
 
             // Prefer 192.168.x.x addresses (common for home networks)
             if (ipStr.startsWith("192.168.")) {
-                LogManager::log(QString("Detected local IP: %1 (interface: %2)").arg(ipStr, iface.humanReadableName()));
+                LOG_INFO(Config, QString("Detected local IP: %1 (interface: %2)").arg(ipStr, iface.humanReadableName()));
                 return ipStr;
             }
         }
@@ -701,12 +756,12 @@ QString ConfigManager::detectLocalIp()
             }
 
             QString ipStr = addr.toString();
-            LogManager::log(QString("Detected local IP: %1 (interface: %2)").arg(ipStr, iface.humanReadableName()));
+            LOG_INFO(Config, QString("Detected local IP: %1 (interface: %2)").arg(ipStr, iface.humanReadableName()));
             return ipStr;
         }
     }
 
-    LogManager::log("Could not detect local IP, using 127.0.0.1");
+    LOG_WARNING(Config, "Could not detect local IP, using 127.0.0.1");
     return "127.0.0.1";
 }
 
@@ -729,7 +784,7 @@ QString ConfigManager::detectLocalIpForTarget(const QString &targetIp)
 
     QHostAddress targetAddr(targetIp);
     if (targetAddr.isNull() || targetAddr.protocol() != QAbstractSocket::IPv4Protocol) {
-        LogManager::log(QString("Invalid target IP: %1, using default detection").arg(targetIp));
+        LOG_WARNING(Config, QString("Invalid target IP: %1, using default detection").arg(targetIp));
         return detectLocalIp();
     }
 
@@ -769,7 +824,7 @@ QString ConfigManager::detectLocalIpForTarget(const QString &targetIp)
 
                 if (localNet == targetNet) {
                     QString ipStr = addr.toString();
-                    LogManager::log(QString("Detected local IP for target %1: %2 (interface: %3, netmask: %4)")
+                    LOG_INFO(Config, QString("Detected local IP for target %1: %2 (interface: %3, netmask: %4)")
                                    .arg(targetIp, ipStr, iface.humanReadableName(), netmask.toString()));
                     return ipStr;
                 }
@@ -778,6 +833,6 @@ QString ConfigManager::detectLocalIpForTarget(const QString &targetIp)
     }
 
     // No matching subnet found, fall back to default detection
-    LogManager::log(QString("No interface on same subnet as %1, using default detection").arg(targetIp));
+    LOG_INFO(Config, QString("No interface on same subnet as %1, using default detection").arg(targetIp));
     return detectLocalIp();
 }
@@ -47,6 +47,12 @@ class ConfigManager : public QObject
     Q_PROPERTY(QString txServerIp READ txServerIp WRITE setTxServerIp NOTIFY txServerIpChanged)
     Q_PROPERTY(QString rxHostIp READ rxHostIp WRITE setRxHostIp NOTIFY rxHostIpChanged)
 
+    // Multicast: camera sends to a group instead of rxHostIp so several RX stations can watch
+    Q_PROPERTY(bool multicastEnabled READ multicastEnabled WRITE setMulticastEnabled NOTIFY multicastChanged)
+    Q_PROPERTY(QString multicastGroup READ multicastGroup WRITE setMulticastGroup NOTIFY multicastChanged)
+    Q_PROPERTY(QString multicastInterface READ multicastInterface WRITE setMulticastInterface NOTIFY multicastChanged)
+    Q_PROPERTY(QString streamDestination READ streamDestination NOTIFY streamDestinationChanged)
+
     // Resolution
     Q_PROPERTY(int resolutionIndex READ resolutionIndex WRITE setResolutionIndex NOTIFY resolutionIndexChanged)
     Q_PROPERTY(QStringList resolutionOptions READ resolutionOptions CONSTANT)
@@ -89,6 +95,17 @@ public:
     QString rxHostIp() const { return m_rxHostIp; }
     void setRxHostIp(const QString &ip);
 
+    // Multicast getters/setters
+    bool multicastEnabled() const { return m_multicastEnabled; }
+    void setMulticastEnabled(bool enabled);
+    QString multicastGroup() const { return m_multicastGroup; }
+    void setMulticastGroup(const QString &group);
+    QString multicastInterface() const { return m_multicastInterface; }
+    void setMulticastInterface(const QString &iface);
+
+    // Address the camera should stream to: the multicast group or rxHostIp
+    QString streamDestination() const { return m_multicastEnabled ? m_multicastGroup : m_rxHostIp; }
+
     // Resolution getters/setters
     int resolutionIndex() const { return m_resolutionIndex; }
     void setResolutionIndex(int index);
@@ -139,6 +156,8 @@ public:
 signals:
     void txServerIpChanged();
     void rxHostIpChanged();
+    void multicastChanged();
+    void streamDestinationChanged();
     void resolutionIndexChanged();
     void resolutionChanged();
     void framerateIndexChanged();
@@ -179,6 +198,11 @@ private:
     int m_txHttpPort = 80;                  // TX server HTTP port
     int m_rxStreamPort = 8888;              // RX stream port
 
+    // Multicast (administratively scoped group by default)
+    bool m_multicastEnabled = false;
+    QString m_multicastGroup = "239.255.42.1";
+    QString m_multicastInterface;           // Empty = system default route
+
     // Resolution presets
     QStringList m_resolutionOptions = {"1280 x 720", "720 x 1280"};
     int m_resolutionIndex = 0;
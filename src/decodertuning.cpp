@@ -0,0 +1,57 @@
+#include "decodertuning.h"
+
+namespace DecoderTuning {
+
+namespace {
+
+struct Setting {
+    const char *element;
+    const char *property;
+    const char *lowLatency;   // Value for LowLatency, nullptr = leave default
+    const char *throughput;   // Value for Throughput, nullptr = leave default
+};
+
+// Values go through gst_util_set_object_arg, so enums and flags use their nicks
+const Setting kSettings[] = {
+    // Frame threading holds one frame per thread before output; slice threading adds none
+    {"avdec_h264", "thread-type", "slice", "frame+slice"},
+    // 0 = one thread per core; with slice threading this costs no latency
+    {"avdec_h264", "max-threads", "0", "0"},
+    // Show concealed frames after loss instead of waiting for the next keyframe
+    {"avdec_h264", "output-corrupt", "true", "false"},
+    {"vaapih264dec", "low-latency", "true", "false"},
+    // Frames NVDEC may hold for reordering before display (-1 = driver default)
+    {"nvh264dec", "max-display-delay", "0", "-1"},
+};
+
+} // namespace
+
+QStringList apply(GstElement *decoder, const QString &elementName, Profile profile, QStringList *skipped)
+{
+    const QByteArray element = elementName.toUtf8();
+    QStringList applied;
+
+    for (const Setting &setting : kSettings) {
+        if (element != setting.element) {
+            continue;
+        }
+
+        const char *value = profile == Throughput ? setting.throughput : setting.lowLatency;
+        if (!value) {
+            continue;
+        }
+
+        if (!g_object_class_find_property(G_OBJECT_GET_CLASS(decoder), setting.property)) {
+            if (skipped) {
+                skipped->append(QString::fromUtf8(setting.property));
+            }
+            continue;
+        }
+
+        gst_util_set_object_arg(G_OBJECT(decoder), setting.property, value);
+        applied.append(QString("%1=%2").arg(QString::fromUtf8(setting.property), QString::fromUtf8(value)));
+    }
+    return applied;
+}
+
+} // namespace DecoderTuning
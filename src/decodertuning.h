@@ -0,0 +1,26 @@
+#ifndef DECODERTUNING_H
+#define DECODERTUNING_H
+
+#include <QString>
+#include <QStringList>
+#include <gst/gst.h>
+
+// Per-element decoder properties for the "lowest latency" and "highest
+// throughput" profiles. StreamManager applies them to its decoder, and
+// bench/decoder_bench.cpp applies the same table when measuring each profile.
+namespace DecoderTuning {
+
+enum Profile {
+    LowLatency = 0,
+    Throughput = 1
+};
+
+// Sets the profile's properties on decoder (created from the factory
+// elementName). Returns "property=value" for each property set; properties
+// the installed plugin version lacks are appended to skipped instead.
+QStringList apply(GstElement *decoder, const QString &elementName, Profile profile,
+                  QStringList *skipped = nullptr);
+
+} // namespace DecoderTuning
+
+#endif // DECODERTUNING_H
@@ -0,0 +1,309 @@
+#include "discoveryparser.h"
+#include <QHostAddress>
+#include <cctype>
+
+DiscoveryParser::DiscoveryParser(const QString &serviceType)
+    : m_serviceType(serviceType)
+{
+}
+
+void DiscoveryParser::clear()
+{
+    m_buffer.clear();
+    m_services.clear();
+    m_servicesWithTxt.clear();
+    m_dirtyServices.clear();
+    m_takenServices.clear();
+    m_hostAddresses.clear();
+    m_servicesByHost.clear();
+}
+
+void DiscoveryParser::feed(const QByteArray &chunk)
+{
+    m_buffer += chunk;
+
+    int start = 0;
+    int newline;
+    while ((newline = m_buffer.indexOf('\n', start)) >= 0) {
+        parseLine(QString::fromUtf8(m_buffer.constData() + start, newline - start));
+        start = newline + 1;
+    }
+    m_buffer.remove(0, start);
+}
+
+void DiscoveryParser::finish()
+{
+    if (!m_buffer.isEmpty()) {
+        parseLine(QString::fromUtf8(m_buffer));
+        m_buffer.clear();
+    }
+}
+
+void DiscoveryParser::parseLine(const QString &line)
+{
+    if (line.startsWith('+') || line.startsWith('=') || line.startsWith('-')) {
+        parseAvahiLine(line);
+    } else if (!line.startsWith(';')) {
+        parseDnsSdLine(line);
+    }
+}
+
+void DiscoveryParser::parseAvahiLine(const QString &line)
+{
+    // avahi-browse -rpt output, fields separated by ';':
+    // +;eth0;IPv4;F1sh\032Camera\032TX;_f1sh-camera._tcp;local
+    // =;eth0;IPv4;F1sh\032Camera\032TX;_f1sh-camera._tcp;local;s4v-cam2-1.local;192.168.3.132;8888;"protocol=udp" "encoding=h264" "control_port=50051"
+    const QList<QStringView> fields = QStringView(line).split(';');
+    if (fields.size() < 6 || fields.at(4).compare(m_serviceType, Qt::CaseInsensitive) != 0) {
+        return;
+    }
+
+    const QString name = unescapeDnsName(fields.at(3));
+    if (name.isEmpty() || fields.at(0) == u"-") {
+        return;
+    }
+    CameraInfo &info = service(name);
+    if (fields.at(0) != u"=" || fields.size() < 10) {
+        return;
+    }
+
+    setServiceTarget(name, info, fields.at(6), fields.at(8).toInt());
+    // TXT strings may themselves contain ';'
+    parseTxtRecord(QStringView(line).mid(fields.at(9).data() - line.constData()), info);
+    m_servicesWithTxt.insert(name);
+
+    const QStringView address = fields.at(7);
+    if (fields.at(2) == u"IPv4" && !address.isEmpty()) {
+        addHostAddress(info.hostname, address.toString());
+    }
+}
+
+void DiscoveryParser::parseDnsSdLine(const QString &line)
+{
+    // dns-sd -Z output on macOS, owner names may contain spaces:
+    // _f1sh-camera._tcp                               PTR     F1sh Camera TX._f1sh-camera._tcp
+    // F1sh Camera TX._f1sh-camera._tcp                SRV     0 0 8888 s4v-cam2-1.local.
+    // F1sh Camera TX._f1sh-camera._tcp                TXT     "protocol=udp" "encoding=h264" "control_port=50051"
+    // s4v-cam2-1.local.                               A       192.168.3.132
+    // s4v-cam2-1.local.                               AAAA    fe80::fdc7:793:e4c1:e78e
+    const QStringView view(line);
+    QStringView owner;
+    QStringView type;
+    QStringView rdata;
+    QStringView previous;
+    int pos = 0;
+    while (pos < view.size()) {
+        while (pos < view.size() && view[pos].isSpace()) {
+            ++pos;
+        }
+        int end = pos;
+        while (end < view.size() && !view[end].isSpace()) {
+            ++end;
+        }
+        if (end == pos) {
+            break;
+        }
+
+        // The record type follows the owner name, which ends in the service
+        // type or a .local host name, never in a word of the instance name
+        const QStringView token = view.mid(pos, end - pos);
+        const bool afterOwner = previous.endsWith(u"_tcp") || previous.endsWith(u"_tcp.")
+                                || previous.endsWith(u".local") || previous.endsWith(u".local.");
+        if (afterOwner && (token == u"PTR" || token == u"SRV" || token == u"TXT" || token == u"A")) {
+            owner = view.left(pos).trimmed();
+            type = token;
+            rdata = view.mid(end).trimmed();
+            break;
+        }
+        previous = token;
+        pos = end;
+    }
+    if (type.isEmpty() || rdata.isEmpty()) {
+        return;
+    }
+
+    if (type == u"PTR") {
+        if (owner.startsWith(m_serviceType, Qt::CaseInsensitive)) {
+            const QString name = instanceName(rdata);
+            if (!name.isEmpty()) {
+                service(name);
+            }
+        }
+        return;
+    }
+
+    if (type == u"A") {
+        addHostAddress(owner.toString(), rdata.toString());
+        return;
+    }
+
+    const QString name = instanceName(owner);
+    if (name.isEmpty()) {
+        return;
+    }
+    CameraInfo &info = service(name);
+
+    if (type == u"SRV") {
+        // priority weight port target
+        const QList<QStringView> parts = rdata.split(' ', Qt::SkipEmptyParts);
+        if (parts.size() >= 4) {
+            setServiceTarget(name, info, parts.at(3), parts.at(2).toInt());
+        }
+    } else {
+        parseTxtRecord(rdata, info);
+        m_servicesWithTxt.insert(name);
+    }
+}
+
+QString DiscoveryParser::instanceName(QStringView fqdn) const
+{
+    // "F1sh Camera TX._f1sh-camera._tcp.local." -> "F1sh Camera TX"
+    const int suffix = fqdn.lastIndexOf(QString("." + m_serviceType), -1, Qt::CaseInsensitive);
+    return suffix > 0 ? unescapeDnsName(fqdn.left(suffix)) : QString();
+}
+
+QString DiscoveryParser::unescapeDnsName(QStringView text)
+{
+    if (!text.contains('\\')) {
+        return text.toString();
+    }
+
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray out;
+    out.reserve(utf8.size());
+    for (int i = 0; i < utf8.size(); ++i) {
+        const char c = utf8.at(i);
+        if (c != '\\' || i + 1 >= utf8.size()) {
+            out += c;
+        } else if (i + 3 < utf8.size() && std::isdigit(uchar(utf8.at(i + 1)))
+                   && std::isdigit(uchar(utf8.at(i + 2))) && std::isdigit(uchar(utf8.at(i + 3)))) {
+            out += char(utf8.mid(i + 1, 3).toInt());
+            i += 3;
+        } else {
+            out += utf8.at(++i);
+        }
+    }
+    return QString::fromUtf8(out);
+}
+
+void DiscoveryParser::parseTxtRecord(QStringView txt, CameraInfo &info)
+{
+    int pos = 0;
+    while (pos < txt.size()) {
+        while (pos < txt.size() && (txt[pos].isSpace() || txt[pos] == '"')) {
+            ++pos;
+        }
+        int end = pos;
+        while (end < txt.size() && !txt[end].isSpace() && txt[end] != '"') {
+            ++end;
+        }
+
+        const QStringView entry = txt.mid(pos, end - pos);
+        pos = end;
+        const int eq = entry.indexOf('=');
+        if (eq <= 0 || eq == entry.size() - 1) {
+            continue;
+        }
+
+        const QStringView key = entry.left(eq);
+        const QStringView value = entry.mid(eq + 1);
+        if (key.compare(u"protocol", Qt::CaseInsensitive) == 0) {
+            info.protocol = value.toString();
+        } else if (key.compare(u"encoding", Qt::CaseInsensitive) == 0) {
+            info.encoding = value.toString();
+        } else if (key.compare(u"control_port", Qt::CaseInsensitive) == 0) {
+            info.controlPort = value.toInt();
+        }
+    }
+}
+
+CameraInfo &DiscoveryParser::service(const QString &name)
+{
+    auto it = m_services.find(name);
+    if (it == m_services.end()) {
+        it = m_services.insert(name, CameraInfo());
+        it->name = name;
+    }
+    m_dirtyServices.insert(name);
+    return *it;
+}
+
+void DiscoveryParser::setServiceTarget(const QString &name, CameraInfo &info, QStringView host, int port)
+{
+    info.port = port;
+    info.hostname = host.toString();
+    // Remove trailing dot from hostname
+    if (info.hostname.endsWith('.')) {
+        info.hostname.chop(1);
+    }
+    m_servicesByHost.insert(info.hostname.toLower(), name);
+}
+
+void DiscoveryParser::addService(const CameraInfo &info)
+{
+    CameraInfo &entry = service(info.name);
+    entry = info;
+    if (!info.hostname.isEmpty()) {
+        m_servicesByHost.insert(info.hostname.toLower(), info.name);
+    }
+}
+
+void DiscoveryParser::addHostAddress(QString host, const QString &ip)
+{
+    if (QHostAddress(ip).protocol() != QAbstractSocket::IPv4Protocol) {
+        return;
+    }
+    if (host.endsWith('.')) {
+        host.chop(1);
+    }
+    host = host.toLower();
+    m_hostAddresses.insert(host, ip);
+
+    // Services on this host may now be complete
+    for (auto it = m_servicesByHost.constFind(host); it != m_servicesByHost.cend() && it.key() == host; ++it) {
+        m_dirtyServices.insert(it.value());
+    }
+}
+
+QList<CameraInfo> DiscoveryParser::takeResolved(bool requireTxt)
+{
+    // Only services touched since the last call can have become complete,
+    // except at the end when those still lacking TXT are accepted too
+    const QList<QString> candidates = requireTxt ? m_dirtyServices.values() : m_services.keys();
+    m_dirtyServices.clear();
+
+    QList<CameraInfo> resolved;
+    for (const QString &name : candidates) {
+        if (m_takenServices.contains(name)) {
+            continue;
+        }
+        auto it = m_services.find(name);
+        if (it == m_services.end()) {
+            continue;
+        }
+
+        CameraInfo &info = it.value();
+        if (info.ip.isEmpty() && !info.hostname.isEmpty()) {
+            info.ip = m_hostAddresses.value(info.hostname.toLower());
+        }
+        if (info.ip.isEmpty() || info.port <= 0 || (requireTxt && !m_servicesWithTxt.contains(name))) {
+            continue;
+        }
+
+        resolved.append(info);
+        m_takenServices.insert(name);
+    }
+    return resolved;
+}
+
+QStringList DiscoveryParser::unresolvedHosts() const
+{
+    QSet<QString> hosts;
+    for (const CameraInfo &info : m_services) {
+        const QString host = info.hostname.toLower();
+        if (info.ip.isEmpty() && info.port > 0 && !host.isEmpty() && !m_hostAddresses.contains(host)) {
+            hosts.insert(host);
+        }
+    }
+    return hosts.values();
+}
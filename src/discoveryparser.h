@@ -0,0 +1,78 @@
+#ifndef DISCOVERYPARSER_H
+#define DISCOVERYPARSER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+// Structure to hold discovered camera info
+struct CameraInfo {
+    QString name;
+    QString instanceFqdn;
+    QString hostname;
+    QString ip;
+    int port = 0;           // Stream port from service
+    int controlPort = 50051; // gRPC control port
+    QString protocol;       // udp, tcp
+    QString encoding;       // h264, h265
+};
+
+// Incremental parser for the system browse tools MdnsManager falls back to:
+// - avahi-browse -rpt (Linux): one ';'-separated line per service event
+// - dns-sd -Z (macOS): zone file lines, PTR/SRV/TXT/A in any order
+//
+// Each record is filed under its instance or host name as it arrives, so a
+// service is complete as soon as its last record shows up and the cost stays
+// linear in the output. Qt Core only, so tests/ and bench/ use it directly.
+class DiscoveryParser
+{
+public:
+    // serviceType without the domain, e.g. "_f1sh-camera._tcp"
+    explicit DiscoveryParser(const QString &serviceType);
+
+    void clear();
+    // Parses every complete line; a trailing partial line waits for more
+    void feed(const QByteArray &chunk);
+    // The tool is gone, so an unterminated last line is all there is
+    void finish();
+    void parseLine(const QString &line);
+
+    // A service found by other means (Windows DNS API) still lacking an address
+    void addService(const CameraInfo &info);
+    // Only IPv4 is kept; it is usable for the stream and control connections
+    void addHostAddress(QString host, const QString &ip);
+
+    // Services that became complete since the last call, each returned once.
+    // Complete means address and port, plus a TXT record if requireTxt.
+    QList<CameraInfo> takeResolved(bool requireTxt);
+    // Lower-case hosts of services that have a port but no address yet
+    QStringList unresolvedHosts() const;
+    int serviceCount() const { return m_services.size(); }
+
+    // Both tools escape with \DDD (decimal byte) or \c
+    static QString unescapeDnsName(QStringView text);
+    // protocol=udp encoding=h264 control_port=50051, optionally quoted
+    static void parseTxtRecord(QStringView txt, CameraInfo &info);
+
+private:
+    void parseAvahiLine(const QString &line);
+    void parseDnsSdLine(const QString &line);
+    QString instanceName(QStringView fqdn) const;
+    CameraInfo &service(const QString &name);
+    void setServiceTarget(const QString &name, CameraInfo &info, QStringView host, int port);
+
+    QString m_serviceType;
+    QByteArray m_buffer;                            // Incomplete trailing line
+    QHash<QString, CameraInfo> m_services;          // By instance name
+    QSet<QString> m_servicesWithTxt;
+    QSet<QString> m_dirtyServices;                  // Changed since the last takeResolved()
+    QSet<QString> m_takenServices;                  // Already returned
+    QHash<QString, QString> m_hostAddresses;        // Lower-case hostname -> IPv4
+    QMultiHash<QString, QString> m_servicesByHost;  // Lower-case hostname -> instance names
+};
+
+#endif // DISCOVERYPARSER_H
@@ -0,0 +1,118 @@
+#include "flightrecorder.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = { 'F', '1', 'S', 'H', 'F', 'L', 'T', '1' };
+
+template <typename T>
+void put(uchar *dst, T value)
+{
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+} // namespace
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+bool FlightRecorder::open(const QString &path, const QString &previousPath)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_map) {
+        return true;
+    }
+
+    if (QFile::exists(path)) {
+        QFile::remove(previousPath);
+        QFile::rename(path, previousPath);
+    }
+
+    const qint64 fileSize = qint64(HEADER_SIZE) + qint64(BLOCK_SIZE) * BLOCK_COUNT;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+    // A freshly sized file reads as zeros, so every block starts out empty
+    if (!m_file.resize(fileSize)) {
+        m_file.close();
+        return false;
+    }
+    m_map = m_file.map(0, fileSize);
+    if (!m_map) {
+        m_file.close();
+        return false;
+    }
+
+    uchar *header = m_map;
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    put<quint32>(header + 8, VERSION);
+    put<quint32>(header + 12, HEADER_SIZE);
+    put<quint32>(header + 16, BLOCK_SIZE);
+    put<quint32>(header + 20, BLOCK_COUNT);
+    put<qint64>(header + 24, QDateTime::currentMSecsSinceEpoch());
+    put<quint32>(header + 32, quint32(QCoreApplication::applicationPid()));
+
+    m_block = 0;
+    m_offset = 0;
+    m_sequence = 0;
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+bool FlightRecorder::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_map != nullptr;
+}
+
+void FlightRecorder::enterBlock(quint32 block)
+{
+    m_block = block % BLOCK_COUNT;
+    m_offset = 0;
+    std::memset(m_map + HEADER_SIZE + qint64(m_block) * BLOCK_SIZE, 0, BLOCK_SIZE);
+}
+
+void FlightRecorder::append(RecordType type, int level, int category, const QByteArray &payload)
+{
+    const quint32 payloadSize = quint32(qMin<qint64>(payload.size(), BLOCK_SIZE - RECORD_HEADER_SIZE));
+    const quint32 recordSize = (RECORD_HEADER_SIZE + payloadSize + 7) & ~7u;
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_map) {
+        return;
+    }
+
+    if (m_offset + recordSize > BLOCK_SIZE) {
+        enterBlock(m_block + 1);
+    }
+
+    uchar *record = m_map + HEADER_SIZE + qint64(m_block) * BLOCK_SIZE + m_offset;
+    put<quint16>(record + 4, quint16(type));
+    record[6] = quint8(level);
+    record[7] = quint8(category);
+    put<quint64>(record + 8, m_sequence++);
+    put<qint64>(record + 16, timestamp);
+    std::memcpy(record + RECORD_HEADER_SIZE, payload.constData(), payloadSize);
+
+    // The length goes in last: a record cut short by a crash reads as the end of the block
+    std::atomic_signal_fence(std::memory_order_release);
+    put<quint32>(record, RECORD_HEADER_SIZE + payloadSize);
+
+    m_offset += recordSize;
+}
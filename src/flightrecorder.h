@@ -0,0 +1,63 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+// Crash-safe binary ring of recent log records and metric snapshots.
+//
+// The file is memory-mapped and written in place: a record is complete as
+// soon as its length field is stored, and the kernel keeps the mapped pages
+// when the process dies, so the last few minutes survive a crash without any
+// fsync. The data area is split into fixed-size blocks; records never cross
+// a block boundary and a block is zeroed when the writer enters it, so a
+// reader can walk every block from its start and order records by sequence
+// number. scripts/decode_flight_recorder.py turns a file back into text.
+//
+// File layout (little-endian):
+//   header, HEADER_SIZE bytes: magic "F1SHFLT1", u32 version, u32 header size,
+//     u32 block size, u32 block count, i64 creation time (ms since epoch), u32 pid
+//   blocks: records of { u32 length (incl. header, 0 ends the block), u16 type,
+//     u8 level, u8 category, u64 sequence, i64 timestamp (ms since epoch),
+//     UTF-8 payload }, each padded to 8 bytes
+class FlightRecorder
+{
+public:
+    enum RecordType : quint16 {
+        SessionRecord = 1,   // Payload: free-form session description
+        LogRecord = 2,       // Payload: message text; level/category as in LogManager
+        MetricsRecord = 3    // Payload: "name{labels} value" lines
+    };
+
+    FlightRecorder() = default;
+    ~FlightRecorder();
+
+    // Creates a fresh recorder file. An existing file at path is kept as
+    // previousPath so the context of a crashed session can still be decoded.
+    bool open(const QString &path, const QString &previousPath);
+    void close();
+    bool isOpen() const;
+
+    // Thread-safe; payloads longer than a block are truncated
+    void append(RecordType type, int level, int category, const QByteArray &payload);
+
+    static const quint32 VERSION = 1;
+    static const quint32 HEADER_SIZE = 4096;
+    static const quint32 BLOCK_SIZE = 16 * 1024;
+    static const quint32 BLOCK_COUNT = 256;        // 4 MB of records
+    static const quint32 RECORD_HEADER_SIZE = 24;
+
+private:
+    void enterBlock(quint32 block);
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    quint32 m_block = 0;
+    quint32 m_offset = 0;
+    quint64 m_sequence = 0;
+};
+
+#endif // FLIGHTRECORDER_H
@@ -1,11 +1,46 @@
 #include "grpcmanager.h"
 #include "logmanager.h"
+#include "metrics.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <grpcpp/grpcpp.h>
 #include "f1sh_camera.grpc.pb.h"
 
+// ============ gRPC Metrics ============
+
+namespace {
+
+// Latency histogram and error counter for one RPC method
+struct RpcMetrics {
+    explicit RpcMetrics(const char *labels)
+        : latency("f1sh_grpc_request_duration_seconds", "gRPC request round-trip time",
+                  {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0}, labels)
+        , errors("f1sh_grpc_errors_total", "gRPC requests that returned a non-OK status", labels)
+    {
+    }
+
+    void record(const QElapsedTimer &timer, const grpc::Status &status)
+    {
+        latency.observeMs(timer.elapsed());
+        if (!status.ok()) {
+            errors.inc();
+        }
+    }
+
+    Metrics::Histogram latency;
+    Metrics::Counter errors;
+};
+
+RpcMetrics s_rpcHealth("method=\"Health\"");
+RpcMetrics s_rpcGetConfig("method=\"GetConfig\"");
+RpcMetrics s_rpcUpdateConfig("method=\"UpdateConfig\"");
+RpcMetrics s_rpcUpdateHost("method=\"UpdateHost\"");
+RpcMetrics s_rpcSwapResolution("method=\"SwapResolution\"");
+
+} // namespace
+
 // ============ GrpcWorker Implementation ============
 
 GrpcWorker::GrpcWorker(QObject *parent)
@@ -24,7 +59,8 @@ std::shared_ptr<grpc::Channel> GrpcWorker::createChannel(const QString &serverAd
 
 void GrpcWorker::doHealthCheck(const QString &serverAddress)
 {
-    LogManager::log(QString("gRPC: Health check to %1").arg(serverAddress));
+    TRACE_SCOPE("grpc", "Health");
+    LOG_INFO(Grpc, QString("gRPC: Health check to %1").arg(serverAddress));
 
     auto channel = createChannel(serverAddress);
     auto stub = f1sh_camera::F1shCameraService::NewStub(channel);
@@ -36,22 +72,26 @@ void GrpcWorker::doHealthCheck(const QString &serverAddress)
     // Set deadline for the RPC
     context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
 
+    QElapsedTimer rpcTimer;
+    rpcTimer.start();
     grpc::Status status = stub->Health(&context, request, &response);
+    s_rpcHealth.record(rpcTimer, status);
 
     if (status.ok()) {
         QString statusStr = QString::fromStdString(response.status());
-        LogManager::log(QString("gRPC: Health check successful: %1").arg(statusStr));
+        LOG_INFO(Grpc, QString("gRPC: Health check successful: %1").arg(statusStr));
         emit healthCheckFinished(statusStr == "healthy", statusStr);
     } else {
         QString errorMsg = QString::fromStdString(status.error_message());
-        LogManager::log(QString("gRPC: Health check failed: %1").arg(errorMsg));
+        LOG_WARNING(Grpc, QString("gRPC: Health check failed: %1").arg(errorMsg));
         emit healthCheckFinished(false, errorMsg);
     }
 }
 
 void GrpcWorker::doGetConfig(const QString &serverAddress)
 {
-    LogManager::log(QString("gRPC: Getting config from %1").arg(serverAddress));
+    TRACE_SCOPE("grpc", "GetConfig");
+    LOG_INFO(Grpc, QString("gRPC: Getting config from %1").arg(serverAddress));
 
     auto channel = createChannel(serverAddress);
     auto stub = f1sh_camera::F1shCameraService::NewStub(channel);
@@ -62,7 +102,10 @@ void GrpcWorker::doGetConfig(const QString &serverAddress)
 
     context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
 
+    QElapsedTimer rpcTimer;
+    rpcTimer.start();
     grpc::Status status = stub->GetConfig(&context, request, &response);
+    s_rpcGetConfig.record(rpcTimer, status);
 
     if (status.ok()) {
         const auto& config = response.config();
@@ -74,13 +117,13 @@ void GrpcWorker::doGetConfig(const QString &serverAddress)
         int height = config.height();
         int framerate = config.framerate();
 
-        LogManager::log(QString("gRPC: Config received - host=%1, port=%2, %3x%4@%5fps")
+        LOG_INFO(Grpc, QString("gRPC: Config received - host=%1, port=%2, %3x%4@%5fps")
                         .arg(host).arg(port).arg(width).arg(height).arg(framerate));
 
         emit getConfigFinished(true, host, port, cameraName, encoderType, width, height, framerate);
     } else {
         QString errorMsg = QString::fromStdString(status.error_message());
-        LogManager::log(QString("gRPC: GetConfig failed: %1").arg(errorMsg));
+        LOG_WARNING(Grpc, QString("gRPC: GetConfig failed: %1").arg(errorMsg));
         emit getConfigFinished(false, QString(), 0, QString(), QString(), 0, 0, 0);
     }
 }
@@ -88,7 +131,8 @@ void GrpcWorker::doGetConfig(const QString &serverAddress)
 void GrpcWorker::doUpdateConfig(const QString &serverAddress, const QString &host, int port,
                                  int width, int height, int framerate)
 {
-    LogManager::log(QString("gRPC: Updating config on %1").arg(serverAddress));
+    TRACE_SCOPE("grpc", "UpdateConfig");
+    LOG_INFO(Grpc, QString("gRPC: Updating config on %1").arg(serverAddress));
 
     auto channel = createChannel(serverAddress);
     auto stub = f1sh_camera::F1shCameraService::NewStub(channel);
@@ -116,13 +160,16 @@ void GrpcWorker::doUpdateConfig(const QString &serverAddress, const QString &hos
         request.set_framerate(framerate);
     }
 
+    QElapsedTimer rpcTimer;
+    rpcTimer.start();
     grpc::Status status = stub->UpdateConfig(&context, request, &response);
+    s_rpcUpdateConfig.record(rpcTimer, status);
 
     if (status.ok()) {
         QString message = QString::fromStdString(response.message());
         const auto& config = response.config();
 
-        LogManager::log(QString("gRPC: UpdateConfig result: success=%1, message=%2")
+        LOG_INFO(Grpc, QString("gRPC: UpdateConfig result: success=%1, message=%2")
                         .arg(response.success()).arg(message));
 
         emit updateConfigFinished(response.success(), message,
@@ -130,14 +177,15 @@ void GrpcWorker::doUpdateConfig(const QString &serverAddress, const QString &hos
                                   config.port(), config.width(), config.height(), config.framerate());
     } else {
         QString errorMsg = QString::fromStdString(status.error_message());
-        LogManager::log(QString("gRPC: UpdateConfig failed: %1").arg(errorMsg));
+        LOG_WARNING(Grpc, QString("gRPC: UpdateConfig failed: %1").arg(errorMsg));
         emit updateConfigFinished(false, errorMsg, QString(), 0, 0, 0, 0);
     }
 }
 
 void GrpcWorker::doUpdateHost(const QString &serverAddress, const QString &host)
 {
-    LogManager::log(QString("gRPC: Updating host to %1 on %2").arg(host, serverAddress));
+    TRACE_SCOPE("grpc", "UpdateHost");
+    LOG_INFO(Grpc, QString("gRPC: Updating host to %1 on %2").arg(host, serverAddress));
 
     auto channel = createChannel(serverAddress);
     auto stub = f1sh_camera::F1shCameraService::NewStub(channel);
@@ -150,23 +198,27 @@ void GrpcWorker::doUpdateHost(const QString &serverAddress, const QString &host)
 
     request.set_host(host.toStdString());
 
+    QElapsedTimer rpcTimer;
+    rpcTimer.start();
     grpc::Status status = stub->UpdateHost(&context, request, &response);
+    s_rpcUpdateHost.record(rpcTimer, status);
 
     if (status.ok()) {
         QString message = QString::fromStdString(response.message());
-        LogManager::log(QString("gRPC: UpdateHost result: success=%1, message=%2")
+        LOG_INFO(Grpc, QString("gRPC: UpdateHost result: success=%1, message=%2")
                         .arg(response.success()).arg(message));
         emit updateHostFinished(response.success(), message);
     } else {
         QString errorMsg = QString::fromStdString(status.error_message());
-        LogManager::log(QString("gRPC: UpdateHost failed: %1").arg(errorMsg));
+        LOG_WARNING(Grpc, QString("gRPC: UpdateHost failed: %1").arg(errorMsg));
         emit updateHostFinished(false, errorMsg);
     }
 }
 
 void GrpcWorker::doSwapResolution(const QString &serverAddress, int swap)
 {
-    LogManager::log(QString("gRPC: SwapResolution (swap=%1) on %2").arg(swap).arg(serverAddress));
+    TRACE_SCOPE("grpc", "SwapResolution");
+    LOG_INFO(Grpc, QString("gRPC: SwapResolution (swap=%1) on %2").arg(swap).arg(serverAddress));
 
     auto channel = createChannel(serverAddress);
     auto stub = f1sh_camera::F1shCameraService::NewStub(channel);
@@ -179,19 +231,22 @@ void GrpcWorker::doSwapResolution(const QString &serverAddress, int swap)
 
     request.set_swap(swap);
 
+    QElapsedTimer rpcTimer;
+    rpcTimer.start();
     grpc::Status status = stub->SwapResolution(&context, request, &response);
+    s_rpcSwapResolution.record(rpcTimer, status);
 
     if (status.ok()) {
         QString message = QString::fromStdString(response.message());
         const auto& config = response.config();
 
-        LogManager::log(QString("gRPC: SwapResolution result: success=%1, message=%2, new size=%3x%4")
+        LOG_INFO(Grpc, QString("gRPC: SwapResolution result: success=%1, message=%2, new size=%3x%4")
                         .arg(response.success()).arg(message).arg(config.width()).arg(config.height()));
 
         emit swapResolutionFinished(response.success(), message, config.width(), config.height());
     } else {
         QString errorMsg = QString::fromStdString(status.error_message());
-        LogManager::log(QString("gRPC: SwapResolution failed: %1").arg(errorMsg));
+        LOG_WARNING(Grpc, QString("gRPC: SwapResolution failed: %1").arg(errorMsg));
         emit swapResolutionFinished(false, errorMsg, 0, 0);
     }
 }
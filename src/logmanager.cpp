@@ -1,15 +1,154 @@
 #include "logmanager.h"
+#include "metrics.h"
 #include <QDateTime>
 #include <QDebug>
+#include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QSet>
+#include <QSettings>
 #include <QStandardPaths>
-#include <QTextStream>
+#include <QThread>
+#include <QTimer>
 #include <cstdarg>
 #include <cstdio>
 
+static const char kSuppressedName[] = "f1sh_log_messages_suppressed_total";
+static const char kSuppressedHelp[] = "Log messages not written, by reason";
+static Metrics::Counter s_suppressedRate(kSuppressedName, kSuppressedHelp, "reason=\"rate_limit\"");
+static Metrics::Counter s_suppressedRepeat(kSuppressedName, kSuppressedHelp, "reason=\"repeat\"");
+
+// Call sites with drops not yet reported; a site stays here until its count is flushed
+static QMutex s_rateLimitedMutex;
+static QSet<LogRateLimiter*> s_rateLimited;
+
+// ============ LogWriter ============
+
+LogWriter::LogWriter(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+{
+}
+
+void LogWriter::enqueue(QString line, bool urgent)
+{
+    // Bounded so a stalled disk cannot grow the queue without limit
+    if (m_pending.load(std::memory_order_relaxed) >= MAX_PENDING_LINES) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_queue.push(std::move(line));
+
+    if (urgent && !m_wakePending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &LogWriter::drain, Qt::QueuedConnection);
+    }
+}
+
+void LogWriter::start()
+{
+    if (!m_filePath.isEmpty() && !openFile()) {
+        m_filePath.clear();
+    }
+
+    m_flushTimer = new QTimer(this);
+    connect(m_flushTimer, &QTimer::timeout, this, &LogWriter::drain);
+    m_flushTimer->start(FLUSH_INTERVAL_MS);
+}
+
+void LogWriter::drain()
+{
+    m_wakePending.store(false, std::memory_order_release);
+
+    QByteArray batch;
+    QString line;
+    int count = 0;
+    while (m_queue.pop(line)) {
+        // Console output happens here too, off the caller's thread
+        qDebug().noquote() << line.trimmed();
+        batch += line.toUtf8();
+        count++;
+    }
+    if (count > 0) {
+        m_pending.fetch_sub(count, std::memory_order_relaxed);
+    }
+
+    int dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        batch += QString("[log] %1 lines dropped, writer fell behind\n").arg(dropped).toUtf8();
+    }
+
+    if (batch.isEmpty() || m_filePath.isEmpty()) {
+        return;
+    }
+
+    if (!m_file.isOpen() && !openFile()) {
+        return;
+    }
+
+    if (m_fileSize > 0 && m_fileSize + batch.size() > MAX_LOG_FILE_SIZE) {
+        rotate();
+        if (!m_file.isOpen()) {
+            return;
+        }
+    }
+
+    qint64 written = m_file.write(batch);
+    if (written > 0) {
+        m_fileSize += written;
+    }
+    m_file.flush();
+}
+
+void LogWriter::stop()
+{
+    if (m_flushTimer) {
+        m_flushTimer->stop();
+    }
+    drain();
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool LogWriter::openFile()
+{
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+    m_fileSize = m_file.size();
+    return true;
+}
+
+void LogWriter::rotate()
+{
+    m_file.close();
+    QString rotatedPath = m_filePath + ".1";
+    QFile::remove(rotatedPath);
+    QFile::rename(m_filePath, rotatedPath);
+    openFile();
+}
+
+// ============ LogManager ============
+
 LogManager* LogManager::s_instance = nullptr;
 
+std::atomic<int> LogManager::s_levels[int(Category::Count)] = {
+    int(Level::Info), int(Level::Info), int(Level::Info), int(Level::Info),
+    int(Level::Info), int(Level::Info), int(Level::Info)
+};
+
+// Indexed by Category / Level
+static const char *const kCategoryNames[] = {
+    "general", "stream", "grpc", "mdns", "serial", "wifi", "config"
+};
+static const char *const kLevelNames[] = {
+    "debug", "info", "warning", "error"
+};
+static_assert(sizeof(kCategoryNames) / sizeof(kCategoryNames[0]) == int(LogManager::Category::Count),
+              "kCategoryNames must match LogManager::Category");
+
 LogManager* LogManager::instance()
 {
     return s_instance;
@@ -22,51 +161,217 @@ LogManager::LogManager(QObject *parent)
         s_instance = this;
     }
 
+    loadLevels();
+
+    m_model = new LogModel(MAX_LOG_ENTRIES, this);
+
+    m_publishTimer = new QTimer(this);
+    m_publishTimer->setSingleShot(true);
+    m_publishTimer->setInterval(PUBLISH_INTERVAL_MS);
+    connect(m_publishTimer, &QTimer::timeout, this, &LogManager::publishPending);
+
+    m_repeatClock.start();
+    m_repeatTimer = new QTimer(this);
+    m_repeatTimer->setSingleShot(true);
+    m_repeatTimer->setInterval(REPEAT_FLUSH_MS);
+    connect(m_repeatTimer, &QTimer::timeout, this, &LogManager::flushRepeats);
+
     initFileLogging();
 
     // Add startup log
-    addLogEntry("Application started");
+    addLogEntry(Category::General, Level::Info, "Application started");
 }
 
 LogManager::~LogManager()
 {
-    if (m_logFile.isOpen()) {
-        m_logFile.close();
-    }
-
     if (s_instance == this) {
         s_instance = nullptr;
     }
+
+    // Write out whatever is still queued before the thread goes away
+    QMetaObject::invokeMethod(m_writer, &LogWriter::stop, Qt::BlockingQueuedConnection);
+    m_writerThread->quit();
+    m_writerThread->wait();
 }
 
 QString LogManager::logText() const
+{
+    return m_model->text();
+}
+
+int LogManager::logCount() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_logs.join("");
+    return m_logCount;
 }
 
 void LogManager::log(const QString &message)
+{
+    log(Category::General, Level::Info, message);
+}
+
+void LogManager::log(Category category, Level level, const QString &message, int suppressed)
 {
     if (s_instance) {
-        s_instance->appendLog(message);
+        if (suppressed > 0) {
+            s_suppressedRate.inc(suppressed);
+            s_instance->addLogEntry(category, level,
+                                    QString("%1 (%2 similar messages suppressed)").arg(message).arg(suppressed));
+        } else {
+            s_instance->addLogEntry(category, level, message);
+        }
     } else {
         // Fallback to qDebug if no instance
         qDebug() << message;
     }
 }
 
+void LogManager::rateLimited(LogRateLimiter *limiter)
+{
+    {
+        QMutexLocker locker(&s_rateLimitedMutex);
+        s_rateLimited.insert(limiter);
+    }
+    if (LogManager *self = s_instance) {
+        QMetaObject::invokeMethod(self, [self]() {
+            if (!self->m_repeatTimer->isActive()) {
+                self->m_repeatTimer->start();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
 void LogManager::appendLog(const QString &message)
 {
-    addLogEntry(message);
+    addLogEntry(Category::General, Level::Info, message);
+}
+
+// ============ Levels ============
+
+QStringList LogManager::categoryNames() const
+{
+    QStringList names;
+    for (const char *name : kCategoryNames) {
+        names.append(QString::fromLatin1(name));
+    }
+    return names;
+}
+
+QStringList LogManager::levelNames() const
+{
+    QStringList names;
+    for (const char *name : kLevelNames) {
+        names.append(QString::fromLatin1(name));
+    }
+    return names;
+}
+
+int LogManager::categoryIndex(const QString &name)
+{
+    for (int i = 0; i < int(Category::Count); ++i) {
+        if (name.compare(QLatin1String(kCategoryNames[i]), Qt::CaseInsensitive) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int LogManager::levelIndex(const QString &name)
+{
+    for (int i = 0; i <= int(Level::Error); ++i) {
+        if (name.compare(QLatin1String(kLevelNames[i]), Qt::CaseInsensitive) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int LogManager::categoryLevel(const QString &category) const
+{
+    int index = categoryIndex(category);
+    if (index < 0) {
+        return -1;
+    }
+    return s_levels[index].load(std::memory_order_relaxed);
+}
+
+void LogManager::setCategoryLevel(const QString &category, int level)
+{
+    int index = categoryIndex(category);
+    if (index < 0 || level < int(Level::Debug) || level > int(Level::Error)) {
+        return;
+    }
+    if (s_levels[index].exchange(level, std::memory_order_relaxed) == level) {
+        return;
+    }
+
+    QSettings settings("F1sh", "CameraRX");
+    settings.setValue(QString("log/level/%1").arg(QLatin1String(kCategoryNames[index])),
+                      QString::fromLatin1(kLevelNames[level]));
+
+    addLogEntry(Category::General, Level::Info, QString("Log level for %1 set to %2")
+                .arg(QLatin1String(kCategoryNames[index]), QLatin1String(kLevelNames[level])));
+    emit levelsChanged();
+}
+
+bool LogManager::applyLevelSpec(const QString &spec)
+{
+    bool ok = true;
+    const QStringList entries = spec.split(',', Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        QString categoryName;
+        QString levelName = entry.trimmed();
+        int eq = levelName.indexOf('=');
+        if (eq >= 0) {
+            categoryName = levelName.left(eq).trimmed();
+            levelName = levelName.mid(eq + 1).trimmed();
+        }
+
+        int level = levelIndex(levelName);
+        if (level < 0) {
+            ok = false;
+            continue;
+        }
+
+        if (categoryName.isEmpty()) {
+            // Bare level: applies to every category, later entries can refine it
+            for (auto &categoryLevel : s_levels) {
+                categoryLevel.store(level, std::memory_order_relaxed);
+            }
+        } else {
+            int index = categoryIndex(categoryName);
+            if (index < 0) {
+                ok = false;
+                continue;
+            }
+            s_levels[index].store(level, std::memory_order_relaxed);
+        }
+    }
+
+    emit levelsChanged();
+    return ok;
+}
+
+void LogManager::loadLevels()
+{
+    QSettings settings("F1sh", "CameraRX");
+    for (int i = 0; i < int(Category::Count); ++i) {
+        QString value = settings.value(QString("log/level/%1").arg(QLatin1String(kCategoryNames[i]))).toString();
+        int level = levelIndex(value);
+        if (level >= 0) {
+            s_levels[i].store(level, std::memory_order_relaxed);
+        }
+    }
 }
 
 void LogManager::clear()
 {
     {
         QMutexLocker locker(&m_mutex);
-        m_logs.clear();
+        m_pending.clear();
         m_logCount = 0;
     }
+    m_model->clear();
     emit logTextChanged();
     emit logCountChanged();
 }
@@ -115,82 +420,236 @@ QString LogManager::wrapText(const QString &text, int width)
 
 void LogManager::initFileLogging()
 {
+    // An empty path keeps console output but skips the file
+    QString logFilePath;
     QString baseDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
-    if (baseDir.isEmpty()) {
-        return;
+    if (!baseDir.isEmpty()) {
+        QDir dir(baseDir + "/logs");
+        if (dir.exists() || dir.mkpath(".")) {
+            logFilePath = dir.filePath("app.log");
+        }
     }
 
-    QDir dir(baseDir + "/logs");
-    if (!dir.exists() && !dir.mkpath(".")) {
-        return;
+    // Binary flight recorder next to the text log; the previous session's
+    // file is kept so a crash can be investigated after a restart
+    if (!logFilePath.isEmpty()) {
+        QDir dir = QFileInfo(logFilePath).dir();
+        if (m_flightRecorder.open(dir.filePath("flight.bin"), dir.filePath("flight.prev.bin"))) {
+            m_flightRecorder.append(FlightRecorder::SessionRecord, 0, 0,
+                                    QString("%1 %2 started, pid %3")
+                                        .arg(QCoreApplication::applicationName(),
+                                             QCoreApplication::applicationVersion())
+                                        .arg(QCoreApplication::applicationPid()).toUtf8());
+
+            m_metricsSnapshotTimer = new QTimer(this);
+            connect(m_metricsSnapshotTimer, &QTimer::timeout, this, &LogManager::recordMetricsSnapshot);
+            m_metricsSnapshotTimer->start(METRICS_SNAPSHOT_MS);
+        }
     }
 
-    m_logFilePath = dir.filePath("app.log");
-    m_logFile.setFileName(m_logFilePath);
-    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        m_logFilePath.clear();
+    m_writerThread = new QThread(this);
+    m_writer = new LogWriter(logFilePath);
+    m_writer->moveToThread(m_writerThread);
+    connect(m_writerThread, &QThread::started, m_writer, &LogWriter::start);
+    connect(m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_writerThread->start();
+}
+
+void LogManager::addLogEntry(Category category, Level level, const QString &message)
+{
+    int repeats = 0;
+    Category lastCategory = Category::General;
+    Level lastLevel = Level::Info;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (category == m_lastCategory && level == m_lastLevel && message == m_lastMessage) {
+            // The first repeat arms a timer so the count is reported even if
+            // nothing follows; the timer re-arms itself while repeats keep coming
+            m_lastRepeatMs = m_repeatClock.elapsed();
+            if (m_repeatCount++ == 0) {
+                QMetaObject::invokeMethod(this, [this]() {
+                    if (!m_repeatTimer->isActive()) {
+                        m_repeatTimer->start();
+                    }
+                }, Qt::QueuedConnection);
+            }
+            s_suppressedRepeat.inc();
+            return;
+        }
+
+        repeats = m_repeatCount;
+        lastCategory = m_lastCategory;
+        lastLevel = m_lastLevel;
+        m_lastCategory = category;
+        m_lastLevel = level;
+        m_lastMessage = message;
+        m_repeatCount = 0;
     }
+
+    if (repeats > 0) {
+        appendLine(lastCategory, lastLevel, QString("Last message repeated %1 times").arg(repeats));
+    }
+    appendLine(category, level, message);
 }
 
-void LogManager::writeLogToFile(const QString &line)
+void LogManager::flushRepeats()
 {
-    if (m_logFilePath.isEmpty()) {
-        return;
+    const qint64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    // Sites still dropping messages report with their next message instead
+    qint64 waitMs = flushRateLimited(nowNs);
+
+    int repeats = 0;
+    Category category = Category::General;
+    Level level = Level::Info;
+    {
+        QMutexLocker locker(&m_mutex);
+        const qint64 quietMs = m_repeatClock.elapsed() - m_lastRepeatMs;
+        if (m_repeatCount > 0 && quietMs < REPEAT_FLUSH_MS) {
+            // Still repeating: report once the run has been quiet long enough
+            waitMs = waitMs > 0 ? qMin(waitMs, REPEAT_FLUSH_MS - quietMs) : REPEAT_FLUSH_MS - quietMs;
+        } else {
+            repeats = m_repeatCount;
+            category = m_lastCategory;
+            level = m_lastLevel;
+            m_repeatCount = 0;
+        }
     }
 
-    if (!m_logFile.isOpen()) {
-        m_logFile.setFileName(m_logFilePath);
-        if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            return;
+    if (repeats > 0) {
+        appendLine(category, level, QString("Last message repeated %1 times").arg(repeats));
+    }
+    if (waitMs > 0) {
+        m_repeatTimer->start(int(waitMs));
+    }
+}
+
+int LogManager::flushRateLimited(qint64 nowNs)
+{
+    // Returns how long until the next still-active site could be flushed, 0 if none
+    const qint64 quietNs = qint64(REPEAT_FLUSH_MS) * 1000000;
+    QList<LogRateLimiter*> quiet;
+    qint64 waitMs = 0;
+    {
+        QMutexLocker locker(&s_rateLimitedMutex);
+        for (auto it = s_rateLimited.begin(); it != s_rateLimited.end();) {
+            LogRateLimiter *limiter = *it;
+            const qint64 sinceNs = nowNs - limiter->m_lastSuppressedNs.load(std::memory_order_relaxed);
+            if (sinceNs >= quietNs) {
+                quiet.append(limiter);
+                it = s_rateLimited.erase(it);
+            } else {
+                const qint64 remainingMs = (quietNs - sinceNs) / 1000000 + 1;
+                waitMs = waitMs > 0 ? qMin(waitMs, remainingMs) : remainingMs;
+                ++it;
+            }
         }
     }
 
-    QFileInfo fileInfo(m_logFile);
-    if (fileInfo.exists() && fileInfo.size() > MAX_LOG_FILE_SIZE) {
-        m_logFile.close();
-        QString rotatedPath = m_logFilePath + ".1";
-        QFile::remove(rotatedPath);
-        QFile::rename(m_logFilePath, rotatedPath);
-        if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-            return;
+    for (LogRateLimiter *limiter : quiet) {
+        // Zero if a message got through since and already reported the count
+        const int suppressed = limiter->m_suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) {
+            s_suppressedRate.inc(suppressed);
+            const QString site = QFileInfo(QString::fromUtf8(limiter->m_site)).fileName();
+            addLogEntry(limiter->m_category, limiter->m_level,
+                        QString("%1 messages from %2 suppressed").arg(suppressed).arg(site));
         }
     }
+    return int(waitMs);
+}
 
-    QTextStream stream(&m_logFile);
-    stream << line;
-    stream.flush();
+void LogManager::recordMetricsSnapshot()
+{
+    // Counters, gauges and histogram sums/counts; HELP/TYPE lines and
+    // histogram buckets would only take space in the ring
+    const QByteArray text = Metrics::renderPrometheus();
+    QByteArray snapshot;
+    for (const QByteArray &line : text.split('\n')) {
+        if (line.isEmpty() || line.startsWith('#') || line.contains("_bucket")) {
+            continue;
+        }
+        // Split into records that fit a block
+        if (snapshot.size() + line.size() + 1 > int(FlightRecorder::BLOCK_SIZE / 2)) {
+            m_flightRecorder.append(FlightRecorder::MetricsRecord, 0, 0, snapshot);
+            snapshot.clear();
+        }
+        snapshot += line;
+        snapshot += '\n';
+    }
+    if (!snapshot.isEmpty()) {
+        m_flightRecorder.append(FlightRecorder::MetricsRecord, 0, 0, snapshot);
+    }
 }
 
-void LogManager::addLogEntry(const QString &message)
+void LogManager::appendLine(Category category, Level level, const QString &message)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("[hh:mm:ss] ");
+    QString prefix = QDateTime::currentDateTime().toString("[hh:mm:ss] ");
+    if (category != Category::General) {
+        prefix += QString("[%1] ").arg(QLatin1String(kCategoryNames[int(category)]));
+    }
+    switch (level) {
+    case Level::Debug:   prefix += "debug: "; break;
+    case Level::Warning: prefix += "Warning: "; break;
+    case Level::Error:   prefix += "Error: "; break;
+    default: break;
+    }
+
     QString wrapped = wrapText(message, 100);
 
     // Ensure message ends with newline
-    QString logLine = timestamp + wrapped;
+    QString logLine = prefix + wrapped;
     if (!logLine.endsWith('\n')) {
         logLine.append('\n');
     }
 
+    // Unwrapped and untimestamped: the record carries its own time, level and category
+    m_flightRecorder.append(FlightRecorder::LogRecord, int(level), int(category), message.toUtf8());
+
+    bool schedule = false;
     {
         QMutexLocker locker(&m_mutex);
-        m_logs.append(logLine);
+        schedule = m_pending.isEmpty();
+        m_pending.append(logLine);
         m_logCount++;
 
-        // Trim old entries if exceeding max
-        while (m_logs.size() > MAX_LOG_ENTRIES) {
-            m_logs.removeFirst();
+        // Anything beyond the model's capacity would be evicted on arrival
+        if (m_pending.size() > MAX_LOG_ENTRIES) {
+            m_pending.removeFirst();
         }
+    }
 
-        writeLogToFile(logLine);
+    // File and console output happen on the writer thread
+    // Errors are written and flushed immediately so they survive a crash
+    m_writer->enqueue(logLine, level >= Level::Error);
+
+    // The first pending line arms the publish timer; later ones ride along
+    if (schedule) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_publishTimer->isActive()) {
+                m_publishTimer->start();
+            }
+        }, Qt::QueuedConnection);
     }
 
     emit newLogEntry(logLine);
+}
+
+void LogManager::publishPending()
+{
+    QStringList lines;
+    {
+        QMutexLocker locker(&m_mutex);
+        lines.swap(m_pending);
+    }
+
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    m_model->append(lines);
     emit logTextChanged();
     emit logCountChanged();
-
-    // Also output to debug console
-    qDebug().noquote() << logLine.trimmed();
 }
 
 // C-compatible logging functions
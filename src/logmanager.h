@@ -6,25 +6,118 @@
 #include <QString>
 #include <QStringList>
 #include <QMutex>
+#include <QElapsedTimer>
 #include <QFile>
+#include <atomic>
+#include <chrono>
+#include "mpscqueue.h"
+#include "logmodel.h"
+#include "flightrecorder.h"
+
+class QThread;
+class QTimer;
+class LogRateLimiter;
+
+// Writes log lines to disk on its own thread. Producers hand lines over
+// through a lock-free queue; the writer drains it in batches on a timer, or
+// right away for urgent lines, so no caller ever waits on file I/O.
+class LogWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LogWriter(const QString &filePath, QObject *parent = nullptr);
+
+    // Callable from any thread, never blocks
+    void enqueue(QString line, bool urgent);
+
+public slots:
+    void start();
+    void drain();
+    void stop();
+
+private:
+    bool openFile();
+    void rotate();
+
+    MpscQueue<QString> m_queue;
+    std::atomic<int> m_pending{0};
+    std::atomic<int> m_dropped{0};
+    std::atomic<bool> m_wakePending{false};
+
+    QString m_filePath;
+    QFile m_file;
+    qint64 m_fileSize = 0;   // Tracked from writes; the file is only stat'ed on open
+    QTimer *m_flushTimer = nullptr;
+
+    static const int FLUSH_INTERVAL_MS = 250;
+    static const int MAX_PENDING_LINES = 10000;
+    static const qint64 MAX_LOG_FILE_SIZE = 1024 * 1024;
+};
 
 class LogManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QString logText READ logText NOTIFY logTextChanged)
     Q_PROPERTY(int logCount READ logCount NOTIFY logCountChanged)
+    Q_PROPERTY(LogModel* model READ model CONSTANT)
+    Q_PROPERTY(QStringList categoryNames READ categoryNames CONSTANT)
+    Q_PROPERTY(QStringList levelNames READ levelNames CONSTANT)
 
 public:
+    enum class Level {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+    Q_ENUM(Level)
+
+    enum class Category {
+        General,
+        Stream,
+        Grpc,
+        Mdns,
+        Serial,
+        Wifi,
+        Config,
+        Count
+    };
+    Q_ENUM(Category)
+
     static LogManager* instance();
     
     explicit LogManager(QObject *parent = nullptr);
     ~LogManager();
 
     QString logText() const;
-    int logCount() const { return m_logCount; }
+    int logCount() const;
+    LogModel *model() const { return m_model; }
     
-    // Static log function that can be called from anywhere
+    // Static log functions that can be called from anywhere. Prefer the
+    // LOG_* macros, which skip building the message for disabled levels.
     static void log(const QString &message);
+    // suppressed: messages the call site's rate limiter dropped before this one
+    static void log(Category category, Level level, const QString &message, int suppressed = 0);
+    // Called by a LogRateLimiter when it starts dropping messages, from any thread
+    static void rateLimited(LogRateLimiter *limiter);
+
+    // Lock-free, cheap enough to guard every call site
+    static bool isEnabled(Category category, Level level)
+    {
+        return int(level) >= s_levels[int(category)].load(std::memory_order_relaxed);
+    }
+
+    QStringList categoryNames() const;
+    QStringList levelNames() const;
+
+    // Index into levelNames, -1 for an unknown category
+    Q_INVOKABLE int categoryLevel(const QString &category) const;
+    // Sets and persists the minimum level for one category
+    Q_INVOKABLE void setCategoryLevel(const QString &category, int level);
+
+    // Applies a command line spec such as "debug" or "info,mdns=debug,serial=debug"
+    // for this run only. Returns false if any entry was not understood.
+    bool applyLevelSpec(const QString &spec);
     
     Q_INVOKABLE void clear();
     Q_INVOKABLE void appendLog(const QString &message);
@@ -36,27 +129,133 @@ signals:
     void logTextChanged();
     void logCountChanged();
     void newLogEntry(const QString &message);
+    void levelsChanged();
 
 private:
-    void addLogEntry(const QString &message);
+    void addLogEntry(Category category, Level level, const QString &message);
+    void appendLine(Category category, Level level, const QString &message);
+    void flushRepeats();
+    int flushRateLimited(qint64 nowNs);
+    void recordMetricsSnapshot();
+    static int categoryIndex(const QString &name);
+    static int levelIndex(const QString &name);
+    void loadLevels();
     QString wrapText(const QString &text, int width);
     void initFileLogging();
-    void writeLogToFile(const QString &line);
+    void publishPending();
 
-    QStringList m_logs;
+    LogModel *m_model = nullptr;
+    QStringList m_pending;        // Lines not yet handed to the model, guarded by m_mutex
     int m_logCount = 0;
     mutable QMutex m_mutex;
-    QFile m_logFile;
-    QString m_logFilePath;
+    QTimer *m_publishTimer = nullptr;
+
+    // Collapses identical consecutive messages, guarded by m_mutex
+    Category m_lastCategory = Category::General;
+    Level m_lastLevel = Level::Info;
+    QString m_lastMessage;
+    int m_repeatCount = 0;
+    qint64 m_lastRepeatMs = 0;    // m_repeatClock time of the latest repeat
+    QElapsedTimer m_repeatClock;
+    // Reports pending repeats and rate-limited counts once their source goes quiet
+    QTimer *m_repeatTimer = nullptr;
+    QThread *m_writerThread = nullptr;
+    LogWriter *m_writer = nullptr;
+    FlightRecorder m_flightRecorder;
+    QTimer *m_metricsSnapshotTimer = nullptr;
 
     static const int MAX_LOG_ENTRIES = 1000;
-    static const qint64 MAX_LOG_FILE_SIZE = 1024 * 1024;
+    static const int PUBLISH_INTERVAL_MS = 16;   // One model update per frame at most
+    static const int REPEAT_FLUSH_MS = 5000;     // Report pending repeats and drops after this much quiet
+    static const int METRICS_SNAPSHOT_MS = 10000;
     static LogManager* s_instance;
+    static std::atomic<int> s_levels[int(Category::Count)];
+};
+
+// Token bucket for one logging call site (GCRA form: a single atomic
+// "theoretical arrival time"). Allows `burst` messages at once and `perSecond`
+// on average; messages over budget are counted and reported with the next
+// one that gets through, or by LogManager once the site has been quiet for a
+// while. constexpr so a function-local static needs no guard.
+class LogRateLimiter
+{
+public:
+    constexpr LogRateLimiter(double perSecond, int burst, LogManager::Category category,
+                             LogManager::Level level, const char *site)
+        : m_interval(qint64(1e9 / perSecond))
+        , m_tolerance(qint64(1e9 / perSecond) * (burst - 1))
+        , m_category(category)
+        , m_level(level)
+        , m_site(site)
+    {}
+
+    // On success *suppressed receives the number of messages dropped since the last one
+    bool allow(int *suppressed)
+    {
+        const qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        qint64 tat = m_tat.load(std::memory_order_relaxed);
+        for (;;) {
+            const qint64 base = tat > now ? tat : now;
+            if (base - now > m_tolerance) {
+                m_lastSuppressedNs.store(now, std::memory_order_relaxed);
+                // Only the first drop of a run registers, so a flood costs one atomic add
+                if (m_suppressed.fetch_add(1, std::memory_order_relaxed) == 0) {
+                    LogManager::rateLimited(this);
+                }
+                return false;
+            }
+            if (m_tat.compare_exchange_weak(tat, base + m_interval, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        *suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    friend class LogManager;
+
+    const qint64 m_interval;
+    const qint64 m_tolerance;
+    const LogManager::Category m_category;
+    const LogManager::Level m_level;
+    const char *const m_site;                   // "file:line" of the call site
+    std::atomic<qint64> m_tat{0};
+    std::atomic<int> m_suppressed{0};
+    std::atomic<qint64> m_lastSuppressedNs{0};
 };
 
 // Convenience macro for logging (C++)
 #define APP_LOG(msg) LogManager::log(msg)
 
+// Leveled, categorised logging. The message expression is only evaluated
+// when the level is enabled for the category and the call site is within its
+// rate budget, e.g.
+//   LOG_DEBUG(Serial, QString("Raw bytes: %1").arg(hexDump));
+// LOG_AT_RATE sets an explicit budget for periodic or flood-prone sites;
+// every other site gets the default one.
+#define LOG_DEFAULT_RATE 10.0
+#define LOG_DEFAULT_BURST 50
+
+#define LOG_AT_RATE(category, level, perSecond, burst, msg) \
+    do { \
+        if (LogManager::isEnabled(LogManager::Category::category, LogManager::Level::level)) { \
+            static LogRateLimiter logRateLimiter_(perSecond, burst, LogManager::Category::category, \
+                                                  LogManager::Level::level, __FILE__ ":" QT_STRINGIFY(__LINE__)); \
+            int logSuppressed_ = 0; \
+            if (logRateLimiter_.allow(&logSuppressed_)) \
+                LogManager::log(LogManager::Category::category, LogManager::Level::level, (msg), logSuppressed_); \
+        } \
+    } while (0)
+
+#define LOG_AT(category, level, msg) LOG_AT_RATE(category, level, LOG_DEFAULT_RATE, LOG_DEFAULT_BURST, msg)
+
+#define LOG_DEBUG(category, msg) LOG_AT(category, Debug, msg)
+#define LOG_INFO(category, msg) LOG_AT(category, Info, msg)
+#define LOG_WARNING(category, msg) LOG_AT(category, Warning, msg)
+#define LOG_ERROR(category, msg) LOG_AT(category, Error, msg)
+
 extern "C" {
 #endif
 
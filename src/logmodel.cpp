@@ -0,0 +1,85 @@
+#include "logmodel.h"
+
+LogModel::LogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_lines(qMax(1, capacity))
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_count) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case MessageRole:
+        return lineAt(index.row());
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> LogModel::roleNames() const
+{
+    return {
+        { Qt::DisplayRole, "display" },
+        { MessageRole, "message" }
+    };
+}
+
+void LogModel::append(const QStringList &lines)
+{
+    const int capacity = m_lines.size();
+
+    // Lines that would be evicted within this same batch are never shown
+    int first = qMax(0, int(lines.size()) - capacity);
+    int incoming = int(lines.size()) - first;
+    if (incoming <= 0) {
+        return;
+    }
+
+    int evict = qMax(0, m_count + incoming - capacity);
+    if (evict > 0) {
+        beginRemoveRows(QModelIndex(), 0, evict - 1);
+        for (int i = 0; i < evict; ++i) {
+            m_lines[(m_head + i) % capacity].clear();
+        }
+        m_head = (m_head + evict) % capacity;
+        m_count -= evict;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + incoming - 1);
+    for (int i = first; i < lines.size(); ++i) {
+        m_lines[(m_head + m_count) % capacity] = lines.at(i);
+        m_count++;
+    }
+    endInsertRows();
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    for (QString &line : m_lines) {
+        line.clear();
+    }
+    m_head = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+QString LogModel::text() const
+{
+    QString result;
+    for (int row = 0; row < m_count; ++row) {
+        result += lineAt(row);
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QVector>
+
+// List model over the most recent log lines, kept in a fixed-capacity ring.
+// Rows are only ever appended at the end and evicted from the front, and each
+// append() announces just the rows that changed, so views lay out new lines
+// instead of the whole log. GUI thread only; LogManager batches lines from
+// other threads and hands them over once per frame.
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        MessageRole = Qt::UserRole + 1
+    };
+
+    explicit LogModel(int capacity, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void append(const QStringList &lines);
+    void clear();
+
+    // All rows joined, oldest first
+    QString text() const;
+
+private:
+    const QString &lineAt(int row) const { return m_lines[(m_head + row) % m_lines.size()]; }
+
+    QVector<QString> m_lines;   // Circular, m_count rows starting at m_head
+    int m_head = 0;
+    int m_count = 0;
+};
+
+#endif // LOGMODEL_H
@@ -2,6 +2,8 @@
 #include <QQmlApplicationEngine>
 #include <QQuickStyle>
 #include <QQmlContext>
+#include <QQuickWindow>
+#include <QCommandLineParser>
 #include <QDebug>
 #include <QFileInfo>
 #include <iostream>
@@ -15,6 +17,9 @@
 #include "streammanager.h"
 #include "grpcmanager.h"
 #include "mdnsmanager.h"
+#include "metricsmanager.h"
+#include "sessionmanager.h"
+#include "tracemanager.h"
 
 #ifdef __APPLE__
 static void appendEnvPath(const char *name, const QString &path)
@@ -74,6 +79,33 @@ int main(int argc, char *argv[])
     std::cerr << "Starting F1sh Camera RX..." << std::endl;
     
     QApplication app(argc, argv);
+
+    // Command line options
+    QCommandLineParser parser;
+    parser.setApplicationDescription("F1sh Camera RX");
+    parser.addHelpOption();
+    QCommandLineOption metricsOption("metrics",
+        "Serve Prometheus metrics over HTTP (default http://127.0.0.1:9464/metrics).");
+    QCommandLineOption metricsPortOption("metrics-port",
+        "Port for the metrics endpoint (implies --metrics).", "port");
+    QCommandLineOption metricsBindOption("metrics-bind",
+        "Address to bind the metrics endpoint to (default 127.0.0.1).", "address");
+    QCommandLineOption logLevelOption("log-level",
+        "Minimum log level for this run: a level (debug, info, warning, error) and/or "
+        "category=level pairs, e.g. \"info,mdns=debug,serial=debug\". "
+        "Categories: general, stream, grpc, mdns, serial, wifi, config.", "spec");
+    parser.addOption(metricsOption);
+    parser.addOption(metricsPortOption);
+    parser.addOption(metricsBindOption);
+    QCommandLineOption traceOption("trace",
+        "Record a performance trace from startup (save it from the Log view).");
+    QCommandLineOption traceFileOption("trace-file",
+        "Record a performance trace and write it as Chrome trace JSON to this file on exit "
+        "(implies --trace).", "path");
+    parser.addOption(logLevelOption);
+    parser.addOption(traceOption);
+    parser.addOption(traceFileOption);
+    parser.process(app);
     
     // Set the Quick Controls 2 style (optional)
     QQuickStyle::setStyle("Basic");
@@ -83,6 +115,10 @@ int main(int argc, char *argv[])
     // Create and register LogManager first (so other managers can use it)
     LogManager logManager;
     engine.rootContext()->setContextProperty("logManager", &logManager);
+    if (parser.isSet(logLevelOption) && !logManager.applyLevelSpec(parser.value(logLevelOption))) {
+        LOG_WARNING(General, QString("Ignoring unknown entries in --log-level '%1'")
+                    .arg(parser.value(logLevelOption)));
+    }
     
     // Create and register SerialPortManager
     SerialPortManager serialManager;
@@ -108,8 +144,33 @@ int main(int argc, char *argv[])
     MdnsManager mdnsManager;
     engine.rootContext()->setContextProperty("mdnsManager", &mdnsManager);
 
+    // Create and register MetricsManager (HTTP endpoint is opt-in)
+    MetricsManager metricsManager;
+    engine.rootContext()->setContextProperty("metricsManager", &metricsManager);
+    if (parser.isSet(metricsBindOption)) {
+        metricsManager.setBindAddress(parser.value(metricsBindOption));
+    }
+    if (parser.isSet(metricsPortOption)) {
+        metricsManager.setPort(parser.value(metricsPortOption).toInt());
+    }
+    if (parser.isSet(metricsOption) || parser.isSet(metricsPortOption)) {
+        metricsManager.start();
+    }
+
+    // Create and register TraceManager (recording is opt-in)
+    TraceManager traceManager;
+    engine.rootContext()->setContextProperty("traceManager", &traceManager);
+    if (parser.isSet(traceOption) || parser.isSet(traceFileOption)) {
+        traceManager.setEnabled(true);
+    }
+
     // Register image provider for video frames
     engine.addImageProvider("videoframe", streamManager.imageProvider());
+
+    // Create and register SessionManager for multi-camera sessions
+    // (each session registers its own image://sessionN provider)
+    SessionManager sessionManager(&engine, &configManager);
+    engine.rootContext()->setContextProperty("sessionManager", &sessionManager);
     
     // Connect SerialPortManager to WifiManager - update serial port when camera connects
     QObject::connect(&serialManager, &SerialPortManager::connectedPortChanged, [&]() {
@@ -118,9 +179,9 @@ int main(int argc, char *argv[])
 
         // Log camera connection status
         if (serialManager.cameraConnected()) {
-            LogManager::log(QString("Camera connected via COM port: %1").arg(serialManager.connectedPort()));
+            LOG_INFO(General, QString("Camera connected via COM port: %1").arg(serialManager.connectedPort()));
         } else {
-            LogManager::log("No camera connected via COM port");
+            LOG_INFO(General, "No camera connected via COM port");
         }
     });
 
@@ -142,12 +203,13 @@ int main(int argc, char *argv[])
     const QUrl url(QStringLiteral("qrc:/qml/main.qml"));
     
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
-                     &app, [url](QObject *obj, const QUrl &objUrl) {
+                     &app, [url, &traceManager](QObject *obj, const QUrl &objUrl) {
         if (!obj && url == objUrl) {
             std::cerr << "Failed to load QML!" << std::endl;
             QCoreApplication::exit(-1);
         } else {
             std::cerr << "QML loaded successfully" << std::endl;
+            traceManager.attachWindow(qobject_cast<QQuickWindow *>(obj));
         }
     }, Qt::QueuedConnection);
     
@@ -155,5 +217,11 @@ int main(int argc, char *argv[])
     
     std::cerr << "Entering event loop..." << std::endl;
     
-    return app.exec();
+    int result = app.exec();
+
+    if (parser.isSet(traceFileOption)) {
+        traceManager.saveTrace(parser.value(traceFileOption));
+    }
+
+    return result;
 }
@@ -1,7 +1,8 @@
 #include "mdnsmanager.h"
 #include "logmanager.h"
+#include "metrics.h"
+#include "trace.h"
 #include <QDebug>
-#include <QRegularExpression>
 #include <QHostInfo>
 #ifdef Q_OS_WIN
 #include <winsock2.h>
@@ -200,19 +201,37 @@ DNS_STATUS runMdnsQuery(const QString& query, WORD type, DNS_RECORD** outRecords
 
 const QString MdnsManager::kServiceType = "_f1sh-camera._tcp";
 
+static Metrics::Histogram s_discoveryDuration("f1sh_mdns_discovery_duration_seconds",
+                                              "Time from starting mDNS discovery to final results",
+                                              {0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 3.0, 5.0, 10.0});
+static Metrics::Gauge s_camerasDiscovered("f1sh_mdns_cameras_discovered",
+                                          "Cameras found by the last mDNS discovery run");
+
 MdnsManager::MdnsManager(QObject *parent)
     : QObject(parent)
     , m_process(new QProcess(this))
+    , m_querier(new MdnsQuerier(this))
     , m_timeoutTimer(new QTimer(this))
+    , m_settleTimer(new QTimer(this))
+    , m_parser(kServiceType)
 {
     connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &MdnsManager::onProcessFinished);
     connect(m_process, &QProcess::errorOccurred,
             this, &MdnsManager::onProcessError);
+    connect(m_process, &QProcess::readyReadStandardOutput,
+            this, &MdnsManager::onProcessOutput);
     connect(m_timeoutTimer, &QTimer::timeout,
             this, &MdnsManager::onDiscoveryTimeout);
+    connect(m_querier, &MdnsQuerier::instanceResolved,
+            this, &MdnsManager::onInstanceResolved);
+    connect(m_querier, &MdnsQuerier::instanceRemoved,
+            this, &MdnsManager::onInstanceRemoved);
+    connect(m_settleTimer, &QTimer::timeout,
+            this, &MdnsManager::onSettleTimeout);
 
     m_timeoutTimer->setSingleShot(true);
+    m_settleTimer->setSingleShot(true);
 
     // Start discovery automatically on construction
     QTimer::singleShot(500, this, &MdnsManager::startDiscovery);
@@ -231,28 +250,41 @@ void MdnsManager::startDiscovery()
 
     // Clear previous results
     m_cameras.clear();
+    m_parser.clear();
     updateDiscoveredCamerasList();
 
+    m_finishing = false;
     setIsDiscovering(true);
     setCameraFound(false);
-    LogManager::log("Starting mDNS discovery for _f1sh-camera._tcp...");
+    m_discoveryElapsed.start();
+    Trace::asyncBegin("mdns", "discovery", quintptr(this));
+    LOG_INFO(Mdns, "Starting mDNS discovery for _f1sh-camera._tcp...");
 
     // Use platform-specific mDNS browse command
 #ifdef Q_OS_WIN
     if (discoverWindowsNative()) {
-        setIsDiscovering(false);
-        finalizeDiscoveryResults();
+        finishDiscovery();
         return;
     }
     setIsDiscovering(false);
+    recordDiscoveryDuration();
     emit discoveryFinished(false, QString(), 0);
     return;
-#elif defined(Q_OS_MACOS)
+#else
+    // In-process browser first; it answers in milliseconds and needs no daemon tools
+    if (m_querier->start(kServiceType + ".local")) {
+        m_timeoutTimer->start(5000);
+        return;
+    }
+    LOG_INFO(Mdns, "Native mDNS browser unavailable, falling back to the system browse tool");
+
+#if defined(Q_OS_MACOS)
     // macOS: use dns-sd -Z to get full zone info including TXT records
     m_process->start("dns-sd", QStringList() << "-Z" << "_f1sh-camera._tcp" << "local");
 #else
     // Linux: use avahi-browse with TXT records
     m_process->start("avahi-browse", QStringList() << "-rpt" << "_f1sh-camera._tcp");
+#endif
 #endif
 
     // Set timeout for discovery (5 seconds)
@@ -262,15 +294,53 @@ void MdnsManager::startDiscovery()
 void MdnsManager::stopDiscovery()
 {
     m_timeoutTimer->stop();
+    m_settleTimer->stop();
+    m_querier->stop();
+    abortHostLookups();
 
+    // Cleared first so the finished() emitted while waiting is ignored
+    m_finishing = false;
+    setIsDiscovering(false);
+    stopBrowseProcess();
+}
+
+void MdnsManager::stopBrowseProcess()
+{
     if (m_process->state() != QProcess::NotRunning) {
         m_process->terminate();
         if (!m_process->waitForFinished(1000)) {
             m_process->kill();
         }
     }
+}
+
+void MdnsManager::finishDiscovery()
+{
+    if (m_finishing) {
+        return;
+    }
+    // Set first so the finished() emitted while stopping the tool is ignored
+    m_finishing = true;
 
+    m_timeoutTimer->stop();
+    m_settleTimer->stop();
+    m_querier->stop();
+    consumeProcessOutput(true);
+    stopBrowseProcess();
+
+    // Services still waiting for their TXT record go in with defaults
+    promoteResolvedServices(false);
+
+    if (startHostLookups() == 0) {
+        completeDiscovery();
+    }
+}
+
+void MdnsManager::completeDiscovery()
+{
+    m_finishing = false;
     setIsDiscovering(false);
+    finalizeDiscoveryResults();
 }
 
 void MdnsManager::refresh()
@@ -282,13 +352,13 @@ void MdnsManager::refresh()
 void MdnsManager::selectCamera(int index)
 {
     if (index < 0 || index >= m_cameras.size()) {
-        LogManager::log(QString("Invalid camera index: %1").arg(index));
+        LOG_WARNING(Mdns, QString("Invalid camera index: %1").arg(index));
         return;
     }
 
     const CameraInfo &camera = m_cameras.at(index);
     applyCamera(camera);
-    LogManager::log(QString("Selected camera: %1 (%2)").arg(camera.name, camera.ip));
+    LOG_INFO(Mdns, QString("Selected camera: %1 (%2)").arg(camera.name, camera.ip));
 }
 
 void MdnsManager::applyCamera(const CameraInfo &camera)
@@ -302,30 +372,40 @@ void MdnsManager::applyCamera(const CameraInfo &camera)
     setCameraFound(true);
 }
 
+void MdnsManager::onProcessOutput()
+{
+    consumeProcessOutput(false);
+
+    // Report as soon as a camera is fully resolved; others get the settle window
+    if (m_isDiscovering && !m_finishing && promoteResolvedServices(true) > 0 && !m_settleTimer->isActive()) {
+        m_settleTimer->start(SETTLE_MS);
+    }
+}
+
 void MdnsManager::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     Q_UNUSED(exitCode);
     Q_UNUSED(exitStatus);
+    if (!m_isDiscovering || m_finishing) {
+        return;
+    }
+    Trace::instant("mdns", "browseExited");
 
-    QString output = QString::fromUtf8(m_process->readAllStandardOutput());
     QString errorOutput = QString::fromUtf8(m_process->readAllStandardError());
-
-    if (!output.isEmpty()) {
-        LogManager::log(QString("mDNS output:\n%1").arg(output.left(1000)));
-    }
     if (!errorOutput.isEmpty()) {
-        LogManager::log(QString("mDNS error: %1").arg(errorOutput.left(200)));
+        LOG_WARNING(Mdns, QString("mDNS error: %1").arg(errorOutput.left(200)));
     }
 
-    parseDiscoveryOutput(output);
-
-    m_timeoutTimer->stop();
-    setIsDiscovering(false);
-    finalizeDiscoveryResults();
+    finishDiscovery();
 }
 
 void MdnsManager::onProcessError(QProcess::ProcessError error)
 {
+    // Stopping the tool ourselves reports a crash; that is not a failure
+    if (!m_isDiscovering || m_finishing) {
+        return;
+    }
+
     QString errorStr;
     switch (error) {
         case QProcess::FailedToStart:
@@ -342,50 +422,107 @@ void MdnsManager::onProcessError(QProcess::ProcessError error)
             break;
     }
 
-    LogManager::log(errorStr);
+    LOG_WARNING(Mdns, errorStr);
     m_timeoutTimer->stop();
     setIsDiscovering(false);
+    recordDiscoveryDuration();
     emit discoveryFinished(false, QString(), 0);
 }
 
 void MdnsManager::onDiscoveryTimeout()
 {
-    LogManager::log("mDNS discovery timeout - reading current results...");
+    LOG_WARNING(Mdns, "mDNS discovery timeout - using current results...");
+    Trace::instant("mdns", "timeout");
+    finishDiscovery();
+}
 
-    // Read any output we have
-    QString output = QString::fromUtf8(m_process->readAllStandardOutput());
-    if (!output.isEmpty()) {
-        LogManager::log(QString("mDNS output on timeout:\n%1").arg(output.left(1000)));
-        parseDiscoveryOutput(output);
+void MdnsManager::onInstanceResolved(const MdnsServiceInstance &instance)
+{
+    if (!m_isDiscovering || m_finishing) {
+        return;
     }
 
-    stopDiscovery();
-    finalizeDiscoveryResults();
+    CameraInfo info;
+    info.name = instance.name;
+    info.instanceFqdn = instance.instanceFqdn;
+    info.hostname = instance.hostname;
+    info.port = instance.port;
+    DiscoveryParser::parseTxtRecord(instance.txt.join(' '), info);
+
+    // Prefer IPv4; a link-local IPv6 address is unusable without its scope
+    for (const QHostAddress &addr : instance.addresses) {
+        if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
+            info.ip = addr.toString();
+            break;
+        }
+    }
+    if (info.ip.isEmpty()) {
+        for (const QHostAddress &addr : instance.addresses) {
+            if (!addr.isLinkLocal()) {
+                info.ip = addr.toString();
+                break;
+            }
+        }
+    }
+    if (info.ip.isEmpty()) {
+        return;
+    }
+
+    bool replaced = false;
+    for (CameraInfo &camera : m_cameras) {
+        if (camera.instanceFqdn.compare(info.instanceFqdn, Qt::CaseInsensitive) == 0) {
+            camera = info;
+            replaced = true;
+            break;
+        }
+    }
+    if (replaced) {
+        LOG_DEBUG(Mdns, QString("Camera service updated: %1 (%2:%3)").arg(info.name, info.ip).arg(info.port));
+    } else {
+        m_cameras.append(info);
+        LOG_INFO(Mdns, QString("Found camera service: %1 (%2:%3)").arg(info.name, info.ip).arg(info.port));
+    }
+    updateDiscoveredCamerasList();
+
+    // Other cameras answer the same query within a few hundred milliseconds
+    if (!m_settleTimer->isActive()) {
+        m_settleTimer->start(SETTLE_MS);
+    }
 }
 
-void MdnsManager::parseTxtRecord(const QString &txt, CameraInfo &info)
+void MdnsManager::onInstanceRemoved(const QString &instanceFqdn)
 {
-    // Parse TXT record entries like: protocol=udp encoding=h264 control_port=50051
-    QRegularExpression entryRegex(R"((\w+)=(\S+))");
-    QRegularExpressionMatchIterator it = entryRegex.globalMatch(txt);
+    for (int i = 0; i < m_cameras.size(); ++i) {
+        if (m_cameras.at(i).instanceFqdn.compare(instanceFqdn, Qt::CaseInsensitive) == 0) {
+            LOG_INFO(Mdns, QString("Camera service gone: %1").arg(m_cameras.at(i).name));
+            m_cameras.removeAt(i);
+            updateDiscoveredCamerasList();
+            return;
+        }
+    }
+}
 
-    while (it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
-        QString key = match.captured(1).toLower();
-        QString value = match.captured(2);
+void MdnsManager::onSettleTimeout()
+{
+    finishDiscovery();
+}
 
-        if (key == "protocol") {
-            info.protocol = value;
-        } else if (key == "encoding") {
-            info.encoding = value;
-        } else if (key == "control_port") {
-            info.controlPort = value.toInt();
-        }
+void MdnsManager::recordDiscoveryDuration()
+{
+    if (!m_discoveryElapsed.isValid()) {
+        return;
     }
+
+    s_discoveryDuration.observeMs(m_discoveryElapsed.elapsed());
+    s_camerasDiscovered.set(m_cameras.size());
+    m_discoveryElapsed.invalidate();
+    Trace::asyncEnd("mdns", "discovery", quintptr(this));
 }
 
 void MdnsManager::finalizeDiscoveryResults()
 {
+    recordDiscoveryDuration();
+
     if (m_cameras.size() == 1) {
         applyCamera(m_cameras.first());
         emit discoveryFinished(true, m_cameraIp, m_cameraPort);
@@ -393,20 +530,21 @@ void MdnsManager::finalizeDiscoveryResults()
     }
 
     if (m_cameras.size() > 1) {
-        LogManager::log(QString("Found %1 cameras - user selection required").arg(m_cameras.size()));
+        LOG_INFO(Mdns, QString("Found %1 cameras - user selection required").arg(m_cameras.size()));
         emit multipleCamerasFound();
         emit discoveryFinished(true, QString(), 0);
         return;
     }
 
-    LogManager::log("No camera found via mDNS");
+    LOG_WARNING(Mdns, "No camera found via mDNS");
     emit discoveryFinished(false, QString(), 0);
 }
 
 #ifdef Q_OS_WIN
 bool MdnsManager::discoverWindowsNative()
 {
-    LogManager::log("Windows mDNS: PTR browse start for _f1sh-camera._tcp.local");
+    TRACE_SCOPE("mdns", "windowsNative");
+    LOG_DEBUG(Mdns, "Windows mDNS: PTR browse start for _f1sh-camera._tcp.local");
 
     DWORD queryOptions = DNS_QUERY_MULTICAST_ONLY;
 
@@ -420,12 +558,12 @@ bool MdnsManager::discoverWindowsNative()
         nullptr);
 
     if (browseStatus == ERROR_BAD_ARGUMENTS || browseStatus == DNS_ERROR_RCODE_NAME_ERROR) {
-        LogManager::log("Windows mDNS: DnsQuery path unavailable, retrying with DnsStartMulticastQuery");
+        LOG_INFO(Mdns, "Windows mDNS: DnsQuery path unavailable, retrying with DnsStartMulticastQuery");
         browseStatus = runMdnsQuery("_f1sh-camera._tcp.local", DNS_TYPE_PTR, &browseResults);
     }
 
     if (browseStatus != ERROR_SUCCESS) {
-        LogManager::log(QString("Windows mDNS browse failed: code=%1").arg(static_cast<int>(browseStatus)));
+        LOG_WARNING(Mdns, QString("Windows mDNS browse failed: code=%1").arg(static_cast<int>(browseStatus)));
         return false;
     }
 
@@ -455,7 +593,7 @@ bool MdnsManager::discoverWindowsNative()
         info.name = name;
         info.instanceFqdn = fullInstance;
         cameraMap[name] = info;
-        LogManager::log(QString("Found camera service: %1 (%2)").arg(name, fullInstance));
+        LOG_INFO(Mdns, QString("Found camera service: %1 (%2)").arg(name, fullInstance));
     }
 
     // Enrich camera data directly from the browse response records
@@ -468,7 +606,7 @@ bool MdnsManager::discoverWindowsNative()
                     it->port = static_cast<int>(rec->Data.SRV.wPort);
                     it->hostname = QString::fromLatin1(rec->Data.SRV.pNameTarget);
                     if (it->hostname.endsWith('.')) it->hostname.chop(1);
-                    LogManager::log(QString("Windows mDNS: BROWSE SRV %1 -> host=%2 port=%3")
+                    LOG_DEBUG(Mdns, QString("Windows mDNS: BROWSE SRV %1 -> host=%2 port=%3")
                         .arg(it->instanceFqdn, it->hostname)
                         .arg(it->port));
                     break;
@@ -486,8 +624,8 @@ bool MdnsManager::discoverWindowsNative()
                         }
                     }
                     if (!txtEntries.isEmpty()) {
-                        parseTxtRecord(txtEntries.join(' '), *it);
-                        LogManager::log(QString("Windows mDNS: BROWSE TXT %1 -> protocol=%2 encoding=%3 control_port=%4")
+                        DiscoveryParser::parseTxtRecord(txtEntries.join(' '), *it);
+                        LOG_DEBUG(Mdns, QString("Windows mDNS: BROWSE TXT %1 -> protocol=%2 encoding=%3 control_port=%4")
                             .arg(it->instanceFqdn, it->protocol, it->encoding)
                             .arg(it->controlPort));
                     }
@@ -513,14 +651,14 @@ bool MdnsManager::discoverWindowsNative()
                 QString ip = QString::fromLatin1(inet_ntoa(addr));
                 if (!ip.isEmpty()) {
                     it->ip = ip;
-                    LogManager::log(QString("Windows mDNS: BROWSE A %1 -> %2").arg(it->hostname, it->ip));
+                    LOG_DEBUG(Mdns, QString("Windows mDNS: BROWSE A %1 -> %2").arg(it->hostname, it->ip));
                 }
                 break;
             }
         }
     }
 
-    LogManager::log(QString("Windows mDNS: PTR browse found %1 service instance(s)").arg(cameraMap.size()));
+    LOG_INFO(Mdns, QString("Windows mDNS: PTR browse found %1 service instance(s)").arg(cameraMap.size()));
     DnsRecordListFree(browseResults, DnsFreeRecordList);
 
     for (auto it = cameraMap.begin(); it != cameraMap.end(); ++it) {
@@ -530,6 +668,7 @@ bool MdnsManager::discoverWindowsNative()
         }
 
         if (it->hostname.isEmpty() || it->port <= 0 || it->ip.isEmpty()) {
+            TRACE_SCOPE("mdns", "resolve", it.key());
             DNS_SERVICE_INSTANCE* resolvedInstance = nullptr;
             DNS_STATUS resolveStatus = runDnsServiceResolve(instanceFqdn, &resolvedInstance, 2500);
             if (resolveStatus == ERROR_SUCCESS && resolvedInstance) {
@@ -551,10 +690,10 @@ bool MdnsManager::discoverWindowsNative()
                     }
                 }
                 if (!txtEntries.isEmpty()) {
-                    parseTxtRecord(txtEntries.join(' '), *it);
+                    DiscoveryParser::parseTxtRecord(txtEntries.join(' '), *it);
                 }
 
-                LogManager::log(QString("Windows mDNS: RESOLVE %1 -> host=%2 port=%3 protocol=%4 encoding=%5 control_port=%6")
+                LOG_DEBUG(Mdns, QString("Windows mDNS: RESOLVE %1 -> host=%2 port=%3 protocol=%4 encoding=%5 control_port=%6")
                     .arg(instanceFqdn, it->hostname)
                     .arg(it->port)
                     .arg(it->protocol, it->encoding)
@@ -566,13 +705,13 @@ bool MdnsManager::discoverWindowsNative()
                     QString ip = QString::fromLatin1(inet_ntoa(addr));
                     if (!ip.isEmpty()) {
                         it->ip = ip;
-                        LogManager::log(QString("Windows mDNS: RESOLVE IPv4 %1 -> %2").arg(it->hostname, it->ip));
+                        LOG_DEBUG(Mdns, QString("Windows mDNS: RESOLVE IPv4 %1 -> %2").arg(it->hostname, it->ip));
                     }
                 }
 
                 DnsServiceFreeInstance(resolvedInstance);
             } else {
-                LogManager::log(QString("Windows mDNS: RESOLVE failed for %1 code=%2")
+                LOG_WARNING(Mdns, QString("Windows mDNS: RESOLVE failed for %1 code=%2")
                     .arg(instanceFqdn)
                     .arg(static_cast<int>(resolveStatus)));
             }
@@ -601,159 +740,139 @@ bool MdnsManager::discoverWindowsNative()
                         QString ip = QString::fromLatin1(inet_ntoa(addr));
                         if (!ip.isEmpty()) {
                             it->ip = ip;
-                            LogManager::log(QString("Windows mDNS: A %1 -> %2").arg(it->hostname, it->ip));
+                            LOG_DEBUG(Mdns, QString("Windows mDNS: A %1 -> %2").arg(it->hostname, it->ip));
                             break;
                         }
                     }
                 }
                 DnsRecordListFree(hostResults, DnsFreeRecordList);
             } else {
-                LogManager::log(QString("Windows mDNS: A query failed for %1 code=%2")
+                LOG_WARNING(Mdns, QString("Windows mDNS: A query failed for %1 code=%2")
                     .arg(it->hostname)
                     .arg(static_cast<int>(hostStatus)));
             }
         }
-
-        if (it->ip.isEmpty() && !it->hostname.isEmpty()) {
-            QHostInfo hostInfo = QHostInfo::fromName(it->hostname);
-            if (hostInfo.error() == QHostInfo::NoError && !hostInfo.addresses().isEmpty()) {
-                for (const QHostAddress &addr : hostInfo.addresses()) {
-                    if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                        it->ip = addr.toString();
-                        LogManager::log(QString("Windows mDNS: QHostInfo fallback %1 -> %2").arg(it->hostname, it->ip));
-                        break;
-                    }
-                }
-            } else {
-                LogManager::log(QString("Windows mDNS: QHostInfo fallback failed for %1")
-                    .arg(it->hostname));
-            }
-        }
     }
 
     m_cameras.clear();
     for (const CameraInfo &info : cameraMap) {
         if (!info.ip.isEmpty() && info.port > 0) {
             m_cameras.append(info);
+        } else if (!info.hostname.isEmpty() && info.port > 0) {
+            // Left for the asynchronous hostname lookups in finishDiscovery()
+            m_parser.addService(info);
         } else {
-            LogManager::log(QString("Windows mDNS: skipping incomplete service name=%1 instance=%2 host=%3 ip=%4 port=%5")
+            LOG_DEBUG(Mdns, QString("Windows mDNS: skipping incomplete service name=%1 instance=%2 host=%3 ip=%4 port=%5")
                 .arg(info.name, info.instanceFqdn, info.hostname, info.ip)
                 .arg(info.port));
         }
     }
 
-    LogManager::log(QString("Windows mDNS: finalized %1 camera candidate(s)").arg(m_cameras.size()));
+    LOG_INFO(Mdns, QString("Windows mDNS: finalized %1 camera candidate(s)").arg(m_cameras.size()));
     updateDiscoveredCamerasList();
     return true;
 }
 #endif
 
-void MdnsManager::parseDiscoveryOutput(const QString &output)
+void MdnsManager::consumeProcessOutput(bool final)
 {
-    // Parse dns-sd -Z output format on macOS:
-    // _f1sh-camera._tcp                               PTR     F1sh Camera TX._f1sh-camera._tcp
-    // F1sh Camera TX._f1sh-camera._tcp                SRV     0 0 8888 s4v-cam2-1.local.
-    // F1sh Camera TX._f1sh-camera._tcp                TXT     "protocol=udp" "encoding=h264" "control_port=50051"
-    // s4v-cam2-1.local.                               A       192.168.3.132
-    // s4v-cam2-1.local.                               AAAA    fe80::fdc7:793:e4c1:e78e
-
-    QStringList lines = output.split('\n');
+    const QByteArray chunk = m_process->readAllStandardOutput();
+    if (!chunk.isEmpty()) {
+        LOG_AT_RATE(Mdns, Debug, 0.1, 1, QString("mDNS output:\n%1").arg(QString::fromUtf8(chunk.left(1000))));
+    }
 
-    // First pass: find all PTR records (camera names)
-    QMap<QString, CameraInfo> cameraMap;
+    TRACE_SCOPE("mdns", "parse");
+    m_parser.feed(chunk);
+    if (final) {
+        m_parser.finish();
+    }
+}
 
-    for (const QString &line : lines) {
-        // Match PTR record: servicetype PTR instancename.servicetype
-        QRegularExpression ptrRegex(R"(_f1sh-camera\._tcp\s+PTR\s+(.+)\._f1sh-camera\._tcp)");
-        QRegularExpressionMatch ptrMatch = ptrRegex.match(line);
-        if (ptrMatch.hasMatch()) {
-            QString name = ptrMatch.captured(1).trimmed();
-            CameraInfo info;
-            info.name = name;
-            cameraMap[name] = info;
-            LogManager::log(QString("Found camera service: %1").arg(name));
-        }
+int MdnsManager::promoteResolvedServices(bool requireTxt)
+{
+    const QList<CameraInfo> resolved = m_parser.takeResolved(requireTxt);
+    for (const CameraInfo &info : resolved) {
+        m_cameras.append(info);
+        LOG_INFO(Mdns, QString("Found camera service: %1 (%2:%3)").arg(info.name, info.ip).arg(info.port));
+        LOG_DEBUG(Mdns, QString("  TXT: protocol=%1, encoding=%2, control_port=%3")
+            .arg(info.protocol, info.encoding).arg(info.controlPort));
     }
 
-    // Second pass: find SRV records (hostname and port)
-    for (const QString &line : lines) {
-        for (auto it = cameraMap.begin(); it != cameraMap.end(); ++it) {
-            QString name = it.key();
-            // Match SRV record: instancename.servicetype SRV priority weight port target
-            QString pattern = QString(R"(%1\._f1sh-camera\._tcp\s+SRV\s+\d+\s+\d+\s+(\d+)\s+(\S+))").arg(QRegularExpression::escape(name));
-            QRegularExpression srvRegex(pattern);
-            QRegularExpressionMatch srvMatch = srvRegex.match(line);
-            if (srvMatch.hasMatch()) {
-                it->port = srvMatch.captured(1).toInt();
-                it->hostname = srvMatch.captured(2);
-                // Remove trailing dot from hostname
-                if (it->hostname.endsWith('.')) {
-                    it->hostname.chop(1);
-                }
-                LogManager::log(QString("  Service %1: port %2, host %3").arg(name).arg(it->port).arg(it->hostname));
-            }
-        }
+    if (!resolved.isEmpty()) {
+        updateDiscoveredCamerasList();
     }
+    return resolved.size();
+}
 
-    // Third pass: find TXT records
-    for (const QString &line : lines) {
-        for (auto it = cameraMap.begin(); it != cameraMap.end(); ++it) {
-            QString name = it.key();
-            QString pattern = QString(R"(%1\._f1sh-camera\._tcp\s+TXT\s+(.+))").arg(QRegularExpression::escape(name));
-            QRegularExpression txtRegex(pattern);
-            QRegularExpressionMatch txtMatch = txtRegex.match(line);
-            if (txtMatch.hasMatch()) {
-                QString txtData = txtMatch.captured(1);
-                // Remove quotes and parse
-                txtData.replace("\"", " ");
-                parseTxtRecord(txtData, *it);
-                LogManager::log(QString("  TXT: protocol=%1, encoding=%2, control_port=%3")
-                    .arg(it->protocol, it->encoding).arg(it->controlPort));
+int MdnsManager::startHostLookups()
+{
+    // Services whose host had no A record in the browse results
+    const QStringList hosts = m_parser.unresolvedHosts();
+
+    // All run in parallel on Qt's resolver threads, each with its own deadline
+    for (const QString &host : hosts) {
+        LOG_DEBUG(Mdns, QString("Resolving hostname: %1").arg(host));
+        const int id = QHostInfo::lookupHost(host, this, &MdnsManager::onHostLookedUp);
+        m_hostLookups.insert(id, host);
+        Trace::asyncBegin("mdns", "lookupHost", quint64(id), host.toUtf8().constData());
+
+        QTimer::singleShot(HOST_LOOKUP_TIMEOUT_MS, this, [this, id]() {
+            const QString timedOut = m_hostLookups.take(id);
+            if (timedOut.isEmpty()) {
+                return;
             }
-        }
+            QHostInfo::abortHostLookup(id);
+            Trace::asyncEnd("mdns", "lookupHost", quint64(id), "timeout");
+            LOG_WARNING(Mdns, QString("Resolving hostname %1 timed out").arg(timedOut));
+            hostLookupFinished();
+        });
     }
+    return m_hostLookups.size();
+}
 
-    // Fourth pass: find A records (IP addresses)
-    for (const QString &line : lines) {
-        for (auto it = cameraMap.begin(); it != cameraMap.end(); ++it) {
-            if (it->hostname.isEmpty()) continue;
-
-            // Match A record: hostname A ipaddress
-            QString pattern = QString(R"(%1\.?\s+A\s+(\d+\.\d+\.\d+\.\d+))").arg(QRegularExpression::escape(it->hostname));
-            QRegularExpression aRegex(pattern);
-            QRegularExpressionMatch aMatch = aRegex.match(line);
-            if (aMatch.hasMatch()) {
-                it->ip = aMatch.captured(1);
-                LogManager::log(QString("  IP for %1: %2").arg(it->hostname, it->ip));
-            }
-        }
+void MdnsManager::onHostLookedUp(const QHostInfo &hostInfo)
+{
+    const QString host = m_hostLookups.take(hostInfo.lookupId());
+    if (host.isEmpty()) {
+        // Aborted, timed out or from an earlier discovery run
+        return;
     }
+    Trace::asyncEnd("mdns", "lookupHost", quint64(hostInfo.lookupId()));
 
-    // If we didn't find A records, try to resolve hostnames
-    for (auto it = cameraMap.begin(); it != cameraMap.end(); ++it) {
-        if (it->ip.isEmpty() && !it->hostname.isEmpty()) {
-            LogManager::log(QString("Resolving hostname: %1").arg(it->hostname));
-            QHostInfo hostInfo = QHostInfo::fromName(it->hostname);
-            if (hostInfo.error() == QHostInfo::NoError && !hostInfo.addresses().isEmpty()) {
-                for (const QHostAddress &addr : hostInfo.addresses()) {
-                    if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                        it->ip = addr.toString();
-                        LogManager::log(QString("  Resolved to: %1").arg(it->ip));
-                        break;
-                    }
-                }
+    bool resolved = false;
+    if (hostInfo.error() == QHostInfo::NoError) {
+        for (const QHostAddress &addr : hostInfo.addresses()) {
+            if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
+                m_parser.addHostAddress(host, addr.toString());
+                LOG_DEBUG(Mdns, QString("  Resolved %1 to: %2").arg(host, addr.toString()));
+                resolved = true;
+                break;
             }
         }
     }
+    if (!resolved) {
+        LOG_WARNING(Mdns, QString("Resolving hostname %1 failed: %2").arg(host, hostInfo.errorString()));
+    }
 
-    // Add valid cameras to the list
-    for (const CameraInfo &info : cameraMap) {
-        if (!info.ip.isEmpty() && info.port > 0) {
-            m_cameras.append(info);
-        }
+    // Merge as results come in rather than after the slowest lookup
+    promoteResolvedServices(false);
+    hostLookupFinished();
+}
+
+void MdnsManager::hostLookupFinished()
+{
+    if (m_hostLookups.isEmpty() && m_finishing) {
+        completeDiscovery();
     }
+}
 
-    updateDiscoveredCamerasList();
+void MdnsManager::abortHostLookups()
+{
+    for (auto it = m_hostLookups.cbegin(); it != m_hostLookups.cend(); ++it) {
+        QHostInfo::abortHostLookup(it.key());
+        Trace::asyncEnd("mdns", "lookupHost", quint64(it.key()), "aborted");
+    }
+    m_hostLookups.clear();
 }
 
 void MdnsManager::updateDiscoveredCamerasList()
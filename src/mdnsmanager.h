@@ -6,20 +6,14 @@
 #include <QStringList>
 #include <QProcess>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QVariantList>
 #include <QVariantMap>
-
-// Structure to hold discovered camera info
-struct CameraInfo {
-    QString name;
-    QString instanceFqdn;
-    QString hostname;
-    QString ip;
-    int port = 0;           // Stream port from service
-    int controlPort = 50051; // gRPC control port
-    QString protocol;       // udp, tcp
-    QString encoding;       // h264, h265
-};
+#include <QHostInfo>
+#include <QHash>
+#include <QSet>
+#include "discoveryparser.h"
+#include "mdnsquerier.h"
 
 class MdnsManager : public QObject
 {
@@ -70,14 +64,26 @@ signals:
     void multipleCamerasFound();  // Emitted when more than one camera found
 
 private slots:
+    void onProcessOutput();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessError(QProcess::ProcessError error);
     void onDiscoveryTimeout();
+    void onInstanceResolved(const MdnsServiceInstance &instance);
+    void onInstanceRemoved(const QString &instanceFqdn);
+    void onSettleTimeout();
+    void onHostLookedUp(const QHostInfo &hostInfo);
 
 private:
-    void parseDiscoveryOutput(const QString &output);
-    void parseTxtRecord(const QString &txt, CameraInfo &info);
+    void consumeProcessOutput(bool final);
+    int promoteResolvedServices(bool requireTxt);
+    void stopBrowseProcess();
+    void finishDiscovery();
+    void completeDiscovery();
+    int startHostLookups();
+    void hostLookupFinished();
+    void abortHostLookups();
     void finalizeDiscoveryResults();
+    void recordDiscoveryDuration();
 #ifdef Q_OS_WIN
     bool discoverWindowsNative();
 #endif
@@ -93,7 +99,10 @@ private:
     void applyCamera(const CameraInfo &camera);
 
     QProcess *m_process = nullptr;
+    MdnsQuerier *m_querier = nullptr;
     QTimer *m_timeoutTimer = nullptr;
+    QTimer *m_settleTimer = nullptr;
+    QElapsedTimer m_discoveryElapsed;
     QString m_cameraIp;
     QString m_cameraHostname;
     int m_cameraPort = 0;
@@ -106,7 +115,17 @@ private:
     QList<CameraInfo> m_cameras;
     QVariantList m_discoveredCameras;
 
+    // Browse tool output is parsed line by line as it arrives
+    DiscoveryParser m_parser;
+
+    // Fallback lookups for hosts without an A record, by QHostInfo lookup id
+    QHash<int, QString> m_hostLookups;
+    bool m_finishing = false;   // Browse stopped, waiting for m_hostLookups
+
     static const QString kServiceType;
+    // How long the native browser keeps listening for more cameras after the first answer
+    static const int SETTLE_MS = 500;
+    static const int HOST_LOOKUP_TIMEOUT_MS = 2000;
 };
 
 #endif // MDNSMANAGER_H
@@ -0,0 +1,631 @@
+#include "mdnsquerier.h"
+#include "logmanager.h"
+#include "metrics.h"
+#include "trace.h"
+#include <QNetworkDatagram>
+#include <QNetworkInterface>
+#include <QUdpSocket>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+const quint16 kMdnsPort = 5353;
+const char kGroup4[] = "224.0.0.251";
+const char kGroup6[] = "ff02::fb";
+
+const quint16 kTypeA = 1;
+const quint16 kTypePtr = 12;
+const quint16 kTypeTxt = 16;
+const quint16 kTypeAaaa = 28;
+const quint16 kTypeSrv = 33;
+const quint16 kClassIn = 1;
+const quint16 kCacheFlushBit = 0x8000;
+
+const int kFirstQueryIntervalMs = 1000;
+const int kMaxQueryIntervalMs = 60000;
+const int kFollowUpDelayMs = 20;
+
+QList<QNetworkInterface> multicastInterfaces()
+{
+    QList<QNetworkInterface> result;
+    for (const QNetworkInterface &iface : QNetworkInterface::allInterfaces()) {
+        const auto flags = iface.flags();
+        if ((flags & QNetworkInterface::IsUp) && (flags & QNetworkInterface::IsRunning)
+            && (flags & QNetworkInterface::CanMulticast)) {
+            result.append(iface);
+        }
+    }
+    return result;
+}
+
+QString escapeLabel(QString label)
+{
+    label.replace("\\", "\\\\");
+    label.replace(".", "\\.");
+    return label;
+}
+
+// Splits a dotted name into raw labels, honouring backslash escapes
+QStringList splitName(const QString &name)
+{
+    QStringList labels;
+    QString label;
+    for (int i = 0; i < name.size(); ++i) {
+        const QChar c = name.at(i);
+        if (c == '\\' && i + 1 < name.size()) {
+            label += name.at(++i);
+        } else if (c == '.') {
+            labels.append(label);
+            label.clear();
+        } else {
+            label += c;
+        }
+    }
+    if (!label.isEmpty()) {
+        labels.append(label);
+    }
+    return labels;
+}
+
+void appendName(QByteArray &out, const QString &name)
+{
+    for (const QString &label : splitName(name)) {
+        const QByteArray bytes = label.toUtf8().left(63);
+        out += char(bytes.size());
+        out += bytes;
+    }
+    out += char(0);
+}
+
+void appendU16(QByteArray &out, quint16 value)
+{
+    out += char(value >> 8);
+    out += char(value & 0xff);
+}
+
+// Reads a possibly compressed name at pos and advances pos past it
+bool readName(const QByteArray &packet, int &pos, QString *name)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(packet.constData());
+    QStringList labels;
+    int p = pos;
+    int jumps = 0;
+    bool jumped = false;
+
+    while (true) {
+        if (p >= packet.size()) {
+            return false;
+        }
+        const int len = data[p];
+        if (len == 0) {
+            ++p;
+            break;
+        }
+        if ((len & 0xC0) == 0xC0) {
+            if (p + 1 >= packet.size() || ++jumps > 16) {
+                return false;
+            }
+            if (!jumped) {
+                pos = p + 2;
+                jumped = true;
+            }
+            p = ((len & 0x3F) << 8) | data[p + 1];
+            continue;
+        }
+        if ((len & 0xC0) != 0 || p + 1 + len > packet.size()) {
+            return false;
+        }
+        labels.append(escapeLabel(QString::fromUtf8(packet.constData() + p + 1, len)));
+        p += 1 + len;
+    }
+
+    if (!jumped) {
+        pos = p;
+    }
+    *name = labels.join('.');
+    return true;
+}
+
+bool sameInstance(const MdnsServiceInstance &a, const MdnsServiceInstance &b)
+{
+    return a.hostname == b.hostname && a.port == b.port && a.txt == b.txt && a.addresses == b.addresses;
+}
+
+} // namespace
+
+static Metrics::Counter s_packetsReceived("f1sh_mdns_packets_received_total",
+                                          "mDNS responses received by the in-process browser");
+static Metrics::Counter s_queriesSent("f1sh_mdns_queries_sent_total",
+                                      "mDNS query packets sent by the in-process browser");
+
+MdnsQuerier::MdnsQuerier(QObject *parent)
+    : QObject(parent)
+    , m_queryTimer(new QTimer(this))
+    , m_followUpTimer(new QTimer(this))
+{
+    m_clock.start();
+
+    // Continuous querying per RFC 6762 5.2: the interval doubles after each query
+    m_queryTimer->setSingleShot(true);
+    connect(m_queryTimer, &QTimer::timeout, this, [this]() {
+        sendQueries(true);
+        m_queryIntervalMs = qMin(m_queryIntervalMs * 2, kMaxQueryIntervalMs);
+        m_queryTimer->start(m_queryIntervalMs);
+    });
+
+    m_followUpTimer->setSingleShot(true);
+    connect(m_followUpTimer, &QTimer::timeout, this, [this]() { sendQueries(false); });
+}
+
+MdnsQuerier::~MdnsQuerier()
+{
+    stop();
+}
+
+bool MdnsQuerier::start(const QString &serviceType)
+{
+    if (isRunning()) {
+        return true;
+    }
+
+    m_serviceType = serviceType;
+    m_socket4 = openSocket(QHostAddress::AnyIPv4, QHostAddress(kGroup4));
+    m_socket6 = openSocket(QHostAddress::AnyIPv6, QHostAddress(kGroup6));
+    if (!isRunning()) {
+        return false;
+    }
+
+    LOG_DEBUG(Mdns, QString("Native mDNS: browsing %1 (IPv4 %2, IPv6 %3)")
+        .arg(m_serviceType, m_socket4 ? "on" : "off", m_socket6 ? "on" : "off"));
+
+    // Report still-valid cached instances right away, then refresh them
+    m_published.clear();
+    expireRecords();
+    publishChanges();
+
+    sendQueries(true);
+    m_queryIntervalMs = kFirstQueryIntervalMs;
+    m_queryTimer->start(m_queryIntervalMs);
+    return true;
+}
+
+void MdnsQuerier::stop()
+{
+    m_queryTimer->stop();
+    m_followUpTimer->stop();
+
+    for (QUdpSocket *socket : {m_socket4, m_socket6}) {
+        if (socket) {
+            socket->close();
+            socket->deleteLater();
+        }
+    }
+    m_socket4 = nullptr;
+    m_socket6 = nullptr;
+}
+
+QUdpSocket *MdnsQuerier::openSocket(const QHostAddress &bindAddress, const QHostAddress &group)
+{
+    auto *socket = new QUdpSocket(this);
+    // Shared with the system responder (avahi-daemon, mDNSResponder) if there is one
+    if (!socket->bind(bindAddress, kMdnsPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        LOG_DEBUG(Mdns, QString("Native mDNS: cannot bind %1 port %2: %3")
+            .arg(bindAddress.toString()).arg(kMdnsPort).arg(socket->errorString()));
+        delete socket;
+        return nullptr;
+    }
+
+    socket->setSocketOption(QAbstractSocket::MulticastTtlOption, 255);
+    socket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+
+    bool joined = false;
+    for (const QNetworkInterface &iface : multicastInterfaces()) {
+        if (socket->joinMulticastGroup(group, iface)) {
+            joined = true;
+        }
+    }
+    if (!joined && !socket->joinMulticastGroup(group)) {
+        LOG_DEBUG(Mdns, QString("Native mDNS: cannot join %1: %2").arg(group.toString(), socket->errorString()));
+        delete socket;
+        return nullptr;
+    }
+
+    connect(socket, &QUdpSocket::readyRead, this, &MdnsQuerier::readPendingDatagrams);
+    return socket;
+}
+
+void MdnsQuerier::sendPacket(const QByteArray &packet)
+{
+    const QList<QNetworkInterface> interfaces = multicastInterfaces();
+    const auto sendOn = [&](QUdpSocket *socket, const QHostAddress &group) {
+        if (!socket) {
+            return;
+        }
+        bool sent = false;
+        for (const QNetworkInterface &iface : interfaces) {
+            socket->setMulticastInterface(iface);
+            if (socket->writeDatagram(packet, group, kMdnsPort) >= 0) {
+                sent = true;
+            }
+        }
+        if (!sent) {
+            socket->writeDatagram(packet, group, kMdnsPort);
+        }
+    };
+
+    sendOn(m_socket4, QHostAddress(kGroup4));
+    sendOn(m_socket6, QHostAddress(kGroup6));
+    s_queriesSent.inc();
+}
+
+void MdnsQuerier::sendQueries(bool browse)
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    expireRecords();
+    publishChanges();
+
+    // Browse on the RFC 6762 5.2 schedule only; ask for whatever the known
+    // instances are still missing
+    QList<QPair<QString, quint16>> questions;
+    if (browse) {
+        questions.append({m_serviceType, kTypePtr});
+    }
+    for (const Record &ptr : records(m_serviceType, kTypePtr)) {
+        const QList<Record> srv = records(ptr.target, kTypeSrv);
+        if (srv.isEmpty()) {
+            questions.append({ptr.target, kTypeSrv});
+        }
+        if (records(ptr.target, kTypeTxt).isEmpty()) {
+            questions.append({ptr.target, kTypeTxt});
+        }
+        if (!srv.isEmpty() && records(srv.first().target, kTypeA).isEmpty()
+            && records(srv.first().target, kTypeAaaa).isEmpty()) {
+            questions.append({srv.first().target, kTypeA});
+            questions.append({srv.first().target, kTypeAaaa});
+        }
+    }
+
+    if (questions.isEmpty()) {
+        return;
+    }
+
+    QByteArray packet;
+    appendU16(packet, 0);                       // ID
+    appendU16(packet, 0);                       // Flags: standard query
+    appendU16(packet, quint16(questions.size()));
+    appendU16(packet, 0);
+    appendU16(packet, 0);
+    appendU16(packet, 0);
+    for (const auto &question : questions) {
+        appendName(packet, question.first);
+        appendU16(packet, question.second);
+        appendU16(packet, kClassIn);
+    }
+    sendPacket(packet);
+}
+
+void MdnsQuerier::readPendingDatagrams()
+{
+    auto *socket = qobject_cast<QUdpSocket *>(sender());
+    if (!socket) {
+        return;
+    }
+
+    bool changed = false;
+    while (socket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = socket->receiveDatagram();
+        if (processPacket(datagram.data())) {
+            changed = true;
+        }
+    }
+
+    if (changed && isRunning()) {
+        publishChanges();
+        // New instances usually mean new questions; batch them briefly
+        if (!m_followUpTimer->isActive()) {
+            m_followUpTimer->start(kFollowUpDelayMs);
+        }
+    }
+}
+
+bool MdnsQuerier::processPacket(const QByteArray &packet)
+{
+    if (packet.size() < 12) {
+        return false;
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(packet.constData());
+    const quint16 flags = qFromBigEndian<quint16>(data + 2);
+    // Only error-free responses; queries from other hosts are not interesting
+    if (!(flags & 0x8000) || (flags & 0x000F) != 0) {
+        return false;
+    }
+
+    TRACE_SCOPE("mdns", "packet");
+    s_packetsReceived.inc();
+
+    const int questionCount = qFromBigEndian<quint16>(data + 4);
+    const int recordCount = qFromBigEndian<quint16>(data + 6) + qFromBigEndian<quint16>(data + 8)
+                            + qFromBigEndian<quint16>(data + 10);
+    int pos = 12;
+    QString name;
+
+    for (int i = 0; i < questionCount; ++i) {
+        if (!readName(packet, pos, &name) || pos + 4 > packet.size()) {
+            return false;
+        }
+        pos += 4;
+    }
+
+    // Addresses are kept only for hosts our instances point at, and the SRV
+    // naming a host may come after its A record, so they wait for the end
+    struct PendingAddress {
+        QString host;
+        Record record;
+        quint32 ttl;
+        bool cacheFlush;
+    };
+    QList<PendingAddress> addresses;
+    QSet<QString> flushed;
+    bool changed = false;
+    for (int i = 0; i < recordCount; ++i) {
+        if (!readName(packet, pos, &name) || pos + 10 > packet.size()) {
+            break;
+        }
+        const quint16 type = qFromBigEndian<quint16>(data + pos);
+        const quint16 rrClass = qFromBigEndian<quint16>(data + pos + 2);
+        const quint32 ttl = qFromBigEndian<quint32>(data + pos + 4);
+        const int rdataEnd = pos + 10 + qFromBigEndian<quint16>(data + pos + 8);
+        pos += 10;
+        if (rdataEnd > packet.size()) {
+            break;
+        }
+
+        Record record;
+        record.type = type;
+        bool valid = (rrClass & ~kCacheFlushBit) == kClassIn;
+        if (valid) {
+            switch (type) {
+            case kTypePtr: {
+                int p = pos;
+                valid = readName(packet, p, &record.target);
+                break;
+            }
+            case kTypeSrv: {
+                int p = pos + 6;
+                valid = rdataEnd - pos > 6 && readName(packet, p, &record.target);
+                record.port = valid ? qFromBigEndian<quint16>(data + pos + 4) : 0;
+                break;
+            }
+            case kTypeTxt:
+                for (int p = pos; p < rdataEnd;) {
+                    const int len = data[p++];
+                    if (p + len > rdataEnd) {
+                        valid = false;
+                        break;
+                    }
+                    if (len > 0) {
+                        record.txt.append(QString::fromUtf8(packet.constData() + p, len));
+                    }
+                    p += len;
+                }
+                break;
+            case kTypeA:
+                valid = rdataEnd - pos == 4;
+                if (valid) {
+                    record.address = QHostAddress(qFromBigEndian<quint32>(data + pos));
+                }
+                break;
+            case kTypeAaaa:
+                valid = rdataEnd - pos == 16;
+                if (valid) {
+                    record.address = QHostAddress(data + pos);
+                }
+                break;
+            default:
+                valid = false;
+                break;
+            }
+        }
+        pos = rdataEnd;
+
+        // Everything else on the link (other services, printers' goodbyes)
+        // is neither cached nor a reason to query again
+        if (!valid) {
+            continue;
+        }
+        if (type == kTypeA || type == kTypeAaaa) {
+            addresses.append({name, record, ttl, bool(rrClass & kCacheFlushBit)});
+        } else if (isServiceName(type == kTypePtr ? record.target : name)
+                   && (type != kTypePtr || name.compare(m_serviceType, Qt::CaseInsensitive) == 0)) {
+            if (cacheRecord(name, record, ttl, rrClass & kCacheFlushBit, &flushed)) {
+                changed = true;
+            }
+        }
+    }
+
+    if (!addresses.isEmpty()) {
+        const QSet<QString> hosts = serviceHosts();
+        for (const PendingAddress &address : std::as_const(addresses)) {
+            if (hosts.contains(address.host.toLower())
+                && cacheRecord(address.host, address.record, address.ttl, address.cacheFlush, &flushed)) {
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+bool MdnsQuerier::isServiceName(const QString &name) const
+{
+    // "<instance>.<service type>"
+    return name.size() > m_serviceType.size() + 1
+           && name.endsWith(m_serviceType, Qt::CaseInsensitive)
+           && name.at(name.size() - m_serviceType.size() - 1) == '.';
+}
+
+QSet<QString> MdnsQuerier::serviceHosts() const
+{
+    // Only our instances' SRV records are cached, so every target is one of ours
+    QSet<QString> hosts;
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_cache.cbegin(); it != m_cache.cend(); ++it) {
+        for (const Record &record : it.value()) {
+            if (record.type == kTypeSrv && record.expiresMs > now) {
+                hosts.insert(record.target.toLower());
+            }
+        }
+    }
+    return hosts;
+}
+
+bool MdnsQuerier::sameData(const Record &a, const Record &b)
+{
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+    case kTypePtr:
+        return a.target.compare(b.target, Qt::CaseInsensitive) == 0;
+    case kTypeSrv:
+        return a.port == b.port && a.target.compare(b.target, Qt::CaseInsensitive) == 0;
+    case kTypeTxt:
+        return a.txt == b.txt;
+    default:
+        return a.address == b.address;
+    }
+}
+
+bool MdnsQuerier::cacheRecord(const QString &name, const Record &record, quint32 ttl, bool cacheFlush,
+                              QSet<QString> *flushed)
+{
+    const QString key = name.toLower();
+    const qint64 now = m_clock.elapsed();
+    QList<Record> &list = m_cache[key];
+
+    // A cache-flush record replaces what we had for this name and type; the
+    // old data gets one second of grace (RFC 6762 10.2) since the rest of
+    // the new set may be in the same or the next packet
+    if (cacheFlush) {
+        const QString flushKey = key + '/' + QString::number(record.type);
+        if (!flushed->contains(flushKey)) {
+            flushed->insert(flushKey);
+            for (Record &existing : list) {
+                if (existing.type == record.type) {
+                    existing.expiresMs = qMin(existing.expiresMs, now + 1000);
+                }
+            }
+        }
+    }
+
+    for (Record &existing : list) {
+        if (sameData(existing, record)) {
+            const bool wasLive = existing.expiresMs > now;
+            // TTL 0 is a goodbye: the record is gone now
+            existing.expiresMs = now + qint64(ttl) * 1000;
+            return ttl == 0 || !wasLive;
+        }
+    }
+
+    if (ttl == 0) {
+        return false;
+    }
+    Record added = record;
+    added.expiresMs = now + qint64(ttl) * 1000;
+    list.append(added);
+    return true;
+}
+
+void MdnsQuerier::expireRecords()
+{
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        QList<Record> &list = it.value();
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [now](const Record &record) { return record.expiresMs <= now; }),
+                   list.end());
+        if (list.isEmpty()) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QList<MdnsQuerier::Record> MdnsQuerier::records(const QString &name, quint16 type) const
+{
+    QList<Record> result;
+    const qint64 now = m_clock.elapsed();
+    const auto it = m_cache.constFind(name.toLower());
+    if (it != m_cache.constEnd()) {
+        for (const Record &record : it.value()) {
+            if (record.type == type && record.expiresMs > now) {
+                result.append(record);
+            }
+        }
+    }
+    return result;
+}
+
+MdnsServiceInstance MdnsQuerier::buildInstance(const QString &instanceFqdn) const
+{
+    MdnsServiceInstance instance;
+    instance.instanceFqdn = instanceFqdn;
+    const QStringList labels = splitName(instanceFqdn.left(instanceFqdn.size() - m_serviceType.size() - 1));
+    instance.name = labels.join('.');
+
+    const QList<Record> srv = records(instanceFqdn, kTypeSrv);
+    if (!srv.isEmpty()) {
+        instance.hostname = srv.first().target;
+        instance.port = srv.first().port;
+    }
+
+    const QList<Record> txt = records(instanceFqdn, kTypeTxt);
+    if (!txt.isEmpty()) {
+        instance.txt = txt.first().txt;
+    }
+
+    if (!instance.hostname.isEmpty()) {
+        for (quint16 type : {kTypeA, kTypeAaaa}) {
+            for (const Record &record : records(instance.hostname, type)) {
+                instance.addresses.append(record.address);
+            }
+        }
+    }
+    return instance;
+}
+
+void MdnsQuerier::publishChanges()
+{
+    const QString suffix = "." + m_serviceType;
+    QHash<QString, MdnsServiceInstance> current;
+    for (const Record &ptr : records(m_serviceType, kTypePtr)) {
+        if (!ptr.target.endsWith(suffix, Qt::CaseInsensitive) || ptr.target.size() == suffix.size()) {
+            continue;
+        }
+        MdnsServiceInstance instance = buildInstance(ptr.target);
+        if (instance.port > 0 && !instance.addresses.isEmpty()) {
+            current.insert(ptr.target.toLower(), instance);
+        }
+    }
+
+    // Take the new state before emitting, receivers may call back into us
+    const QHash<QString, MdnsServiceInstance> previous = m_published;
+    m_published = current;
+
+    for (auto it = current.cbegin(); it != current.cend(); ++it) {
+        const auto old = previous.constFind(it.key());
+        if (old == previous.cend() || !sameInstance(*old, *it)) {
+            emit instanceResolved(*it);
+        }
+    }
+    for (auto it = previous.cbegin(); it != previous.cend(); ++it) {
+        if (!current.contains(it.key())) {
+            emit instanceRemoved(it->instanceFqdn);
+        }
+    }
+}
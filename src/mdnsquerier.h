@@ -0,0 +1,99 @@
+#ifndef MDNSQUERIER_H
+#define MDNSQUERIER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QUdpSocket;
+
+// A DNS-SD service instance assembled from PTR, SRV, TXT and A/AAAA records
+struct MdnsServiceInstance {
+    QString instanceFqdn;           // "F1sh Camera TX._f1sh-camera._tcp.local"
+    QString name;                   // "F1sh Camera TX"
+    QString hostname;               // SRV target, without the trailing dot
+    int port = 0;
+    QStringList txt;                // "key=value" entries
+    QList<QHostAddress> addresses;
+};
+
+// In-process mDNS / DNS-SD browser (RFC 6762, RFC 6763).
+//
+// Joins 224.0.0.251 and ff02::fb on port 5353 (shared with any system
+// responder), sends PTR queries for one service type and follows up with
+// SRV/TXT and A/AAAA questions for whatever is still missing. Records for
+// the service's instances and the hosts they point at go into a TTL-aware
+// cache that outlives stop(), so a later start() reports still-valid
+// instances immediately; the rest of the link's traffic is ignored.
+//
+// Names are dotted strings without the trailing dot; dots and backslashes
+// inside a label are escaped with a backslash.
+class MdnsQuerier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MdnsQuerier(QObject *parent = nullptr);
+    ~MdnsQuerier();
+
+    // serviceType is e.g. "_f1sh-camera._tcp.local". Returns false if neither
+    // an IPv4 nor an IPv6 socket could join the mDNS group.
+    bool start(const QString &serviceType);
+    void stop();
+    bool isRunning() const { return m_socket4 || m_socket6; }
+
+signals:
+    // Emitted once an instance has SRV data and an address, and again
+    // whenever any of its records change while running
+    void instanceResolved(const MdnsServiceInstance &instance);
+    // The instance said goodbye (TTL 0) or its records expired
+    void instanceRemoved(const QString &instanceFqdn);
+
+private slots:
+    void readPendingDatagrams();
+
+private:
+    struct Record {
+        quint16 type = 0;
+        QString target;             // PTR / SRV target
+        int port = 0;               // SRV
+        QStringList txt;            // TXT
+        QHostAddress address;       // A / AAAA
+        qint64 expiresMs = 0;
+    };
+
+    static bool sameData(const Record &a, const Record &b);
+    QUdpSocket *openSocket(const QHostAddress &bindAddress, const QHostAddress &group);
+    void sendPacket(const QByteArray &packet);
+    // browse adds the service PTR question; follow-ups only ask for what
+    // known instances are missing and send nothing if that is nothing
+    void sendQueries(bool browse);
+    bool isServiceName(const QString &name) const;
+    QSet<QString> serviceHosts() const;
+    bool processPacket(const QByteArray &packet);
+    bool cacheRecord(const QString &name, const Record &record, quint32 ttl, bool cacheFlush,
+                     QSet<QString> *flushed);
+    void expireRecords();
+    QList<Record> records(const QString &name, quint16 type) const;
+    MdnsServiceInstance buildInstance(const QString &instanceFqdn) const;
+    void publishChanges();
+
+    QUdpSocket *m_socket4 = nullptr;
+    QUdpSocket *m_socket6 = nullptr;
+    QTimer *m_queryTimer = nullptr;
+    QTimer *m_followUpTimer = nullptr;
+    QElapsedTimer m_clock;
+    QString m_serviceType;
+    int m_queryIntervalMs = 0;
+
+    QHash<QString, QList<Record>> m_cache;               // Keyed by lower-case owner name
+    QHash<QString, MdnsServiceInstance> m_published;     // Keyed by lower-case instance name
+};
+
+#endif // MDNSQUERIER_H
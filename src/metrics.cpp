@@ -0,0 +1,148 @@
+#include "metrics.h"
+#include <QList>
+#include <QMap>
+#include <cmath>
+
+namespace Metrics {
+
+// Registry list head. Metrics are pushed at static-initialisation time, so a
+// plain CAS loop is enough and no lock is ever taken.
+static std::atomic<Metric*> s_head{nullptr};
+
+Metric::Metric(Type type, const char *name, const char *help, const char *labels)
+    : m_type(type)
+    , m_name(name)
+    , m_help(help)
+    , m_labels(labels ? labels : "")
+{
+    Metric *head = s_head.load(std::memory_order_relaxed);
+    do {
+        m_next = head;
+    } while (!s_head.compare_exchange_weak(head, this,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+QByteArray Metric::sampleName(const char *suffix, const QByteArray &extraLabel) const
+{
+    QByteArray result(m_name);
+    result += suffix;
+
+    QByteArray labels(m_labels);
+    if (!extraLabel.isEmpty()) {
+        if (!labels.isEmpty()) {
+            labels += ',';
+        }
+        labels += extraLabel;
+    }
+
+    if (!labels.isEmpty()) {
+        result += '{' + labels + '}';
+    }
+    return result;
+}
+
+static QByteArray formatDouble(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    return QByteArray::number(value, 'g', 10);
+}
+
+void Counter::render(QByteArray &out) const
+{
+    out += sampleName("") + ' ' + QByteArray::number(value()) + '\n';
+}
+
+void Gauge::render(QByteArray &out) const
+{
+    out += sampleName("") + ' ' + formatDouble(value()) + '\n';
+}
+
+Histogram::Histogram(const char *name, const char *help, std::initializer_list<double> bounds,
+                     const char *labels)
+    : Metric(Type::Histogram, name, help, labels)
+{
+    for (double bound : bounds) {
+        if (m_boundCount >= MAX_BUCKETS) {
+            break;
+        }
+        m_bounds[m_boundCount++] = bound;
+    }
+
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double seconds)
+{
+    int index = 0;
+    while (index < m_boundCount && seconds > m_bounds[index]) {
+        index++;
+    }
+
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    if (seconds > 0) {
+        m_sumMicros.fetch_add(static_cast<quint64>(seconds * 1e6), std::memory_order_relaxed);
+    }
+}
+
+void Histogram::render(QByteArray &out) const
+{
+    // Buckets are stored non-cumulatively; Prometheus expects cumulative counts
+    quint64 cumulative = 0;
+    for (int i = 0; i < m_boundCount; ++i) {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        out += sampleName("_bucket", "le=\"" + formatDouble(m_bounds[i]) + '"')
+             + ' ' + QByteArray::number(cumulative) + '\n';
+    }
+    cumulative += m_buckets[m_boundCount].load(std::memory_order_relaxed);
+    out += sampleName("_bucket", "le=\"+Inf\"") + ' ' + QByteArray::number(cumulative) + '\n';
+
+    out += sampleName("_sum") + ' '
+         + formatDouble(m_sumMicros.load(std::memory_order_relaxed) / 1e6) + '\n';
+    out += sampleName("_count") + ' ' + QByteArray::number(cumulative) + '\n';
+}
+
+Metric *first()
+{
+    return s_head.load(std::memory_order_acquire);
+}
+
+QByteArray renderPrometheus()
+{
+    // Group label variants of the same family so HELP/TYPE are emitted once
+    QMap<QByteArray, QList<const Metric*>> families;
+    for (const Metric *metric = first(); metric; metric = metric->next()) {
+        families[QByteArray(metric->name())].prepend(metric);
+    }
+
+    QByteArray out;
+    out.reserve(8192);
+
+    for (auto it = families.cbegin(); it != families.cend(); ++it) {
+        const Metric *head = it.value().first();
+
+        const char *type = "untyped";
+        switch (head->type()) {
+            case Metric::Type::Counter: type = "counter"; break;
+            case Metric::Type::Gauge: type = "gauge"; break;
+            case Metric::Type::Histogram: type = "histogram"; break;
+        }
+
+        out += "# HELP " + it.key() + ' ' + head->help() + '\n';
+        out += "# TYPE " + it.key() + ' ' + type + '\n';
+        for (const Metric *metric : it.value()) {
+            metric->render(out);
+        }
+    }
+
+    return out;
+}
+
+} // namespace Metrics
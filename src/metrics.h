@@ -0,0 +1,110 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <atomic>
+#include <initializer_list>
+
+// Lock-free metric primitives shared by all managers.
+//
+// Metrics are defined as static objects next to the code that updates them and
+// link themselves into a global list at construction. Updates are single relaxed
+// atomic operations, so they are safe to call from the GStreamer streaming
+// thread and worker threads without any locking. Only renderPrometheus() walks
+// the list, and it never blocks writers.
+namespace Metrics {
+
+class Metric
+{
+public:
+    enum class Type { Counter, Gauge, Histogram };
+
+    Metric(Type type, const char *name, const char *help, const char *labels);
+    virtual ~Metric() = default;
+
+    Metric(const Metric &) = delete;
+    Metric &operator=(const Metric &) = delete;
+
+    Type type() const { return m_type; }
+    const char *name() const { return m_name; }
+    const char *help() const { return m_help; }
+    const char *labels() const { return m_labels; }
+    Metric *next() const { return m_next; }
+
+    // Append sample lines (without HELP/TYPE) in Prometheus text format
+    virtual void render(QByteArray &out) const = 0;
+
+protected:
+    QByteArray sampleName(const char *suffix, const QByteArray &extraLabel = QByteArray()) const;
+
+private:
+    Type m_type;
+    const char *m_name;
+    const char *m_help;
+    const char *m_labels;  // e.g. "method=\"Health\"", may be empty
+    Metric *m_next = nullptr;
+};
+
+// Monotonically increasing 64-bit counter
+class Counter : public Metric
+{
+public:
+    Counter(const char *name, const char *help, const char *labels = "")
+        : Metric(Type::Counter, name, help, labels) {}
+
+    void inc(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void render(QByteArray &out) const override;
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// Last-value gauge
+class Gauge : public Metric
+{
+public:
+    Gauge(const char *name, const char *help, const char *labels = "")
+        : Metric(Type::Gauge, name, help, labels) {}
+
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void render(QByteArray &out) const override;
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+// Fixed-bucket histogram; observations are in seconds
+class Histogram : public Metric
+{
+public:
+    static constexpr int MAX_BUCKETS = 16;
+
+    Histogram(const char *name, const char *help, std::initializer_list<double> bounds,
+              const char *labels = "");
+
+    void observe(double seconds);
+    void observeMs(qint64 milliseconds) { observe(milliseconds / 1000.0); }
+
+    void render(QByteArray &out) const override;
+
+private:
+    double m_bounds[MAX_BUCKETS];
+    int m_boundCount = 0;
+    std::atomic<quint64> m_buckets[MAX_BUCKETS + 1];  // Last slot is +Inf; their sum is the count
+    std::atomic<quint64> m_sumMicros{0};
+};
+
+// Head of the registry list (for iteration by the exporter)
+Metric *first();
+
+// Render every registered metric in Prometheus text exposition format 0.0.4
+QByteArray renderPrometheus();
+
+} // namespace Metrics
+
+#endif // METRICS_H
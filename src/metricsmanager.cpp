@@ -0,0 +1,153 @@
+#include "metricsmanager.h"
+#include "metrics.h"
+#include "trace.h"
+#include "logmanager.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+
+MetricsManager::MetricsManager(QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsManager::onNewConnection);
+}
+
+MetricsManager::~MetricsManager()
+{
+    stop();
+}
+
+bool MetricsManager::isRunning() const
+{
+    return m_server->isListening();
+}
+
+void MetricsManager::setPort(int port)
+{
+    if (m_port != port) {
+        m_port = port;
+        emit portChanged();
+
+        if (isRunning()) {
+            stop();
+            start();
+        }
+    }
+}
+
+void MetricsManager::setBindAddress(const QString &address)
+{
+    QHostAddress parsed(address);
+    if (parsed.isNull()) {
+        LOG_WARNING(General, QString("Metrics: invalid bind address '%1', keeping %2")
+                        .arg(address, m_bindAddress.toString()));
+        return;
+    }
+
+    if (m_bindAddress != parsed) {
+        m_bindAddress = parsed;
+        emit bindAddressChanged();
+
+        if (isRunning()) {
+            stop();
+            start();
+        }
+    }
+}
+
+bool MetricsManager::start()
+{
+    if (isRunning()) {
+        return true;
+    }
+
+    if (!m_server->listen(m_bindAddress, static_cast<quint16>(m_port))) {
+        LOG_ERROR(General, QString("Metrics: failed to listen on %1:%2: %3")
+                        .arg(m_bindAddress.toString()).arg(m_port).arg(m_server->errorString()));
+        return false;
+    }
+
+    LOG_INFO(General, QString("Metrics endpoint listening on http://%1:%2/metrics")
+                    .arg(m_bindAddress.toString()).arg(m_port));
+    emit isRunningChanged();
+    return true;
+}
+
+void MetricsManager::stop()
+{
+    if (!m_server->isListening()) {
+        return;
+    }
+
+    m_server->close();
+    LOG_INFO(General, "Metrics endpoint stopped");
+    emit isRunningChanged();
+}
+
+void MetricsManager::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handleRequest(socket);
+        });
+    }
+}
+
+void MetricsManager::handleRequest(QTcpSocket *socket)
+{
+    // Wait until the full request header has arrived
+    const QByteArray pending = socket->peek(MAX_REQUEST_SIZE);
+    if (!pending.contains("\r\n\r\n") && !pending.contains("\n\n")) {
+        if (pending.size() >= MAX_REQUEST_SIZE) {
+            sendResponse(socket, "431 Request Header Fields Too Large", "text/plain", "Request too large\n");
+        }
+        return;
+    }
+
+    const QByteArray request = socket->readAll();
+    const QByteArray requestLine = request.left(request.indexOf('\n')).trimmed();
+    const QList<QByteArray> parts = requestLine.split(' ');
+
+    if (parts.size() < 2 || (parts[0] != "GET" && parts[0] != "HEAD")) {
+        sendResponse(socket, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+        return;
+    }
+
+    QByteArray path = parts[1];
+    int query = path.indexOf('?');
+    if (query >= 0) {
+        path.truncate(query);
+    }
+
+    // HEAD gets the same headers, including the GET Content-Length, without the body
+    const bool headOnly = parts[0] == "HEAD";
+    if (path == "/metrics") {
+        sendResponse(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                     Metrics::renderPrometheus(), headOnly);
+    } else if (path == "/trace") {
+        // Current trace ring as Chrome trace JSON (empty unless tracing is on)
+        sendResponse(socket, "200 OK", "application/json", Trace::toChromeJson(), headOnly);
+    } else if (path == "/") {
+        sendResponse(socket, "200 OK", "text/plain", "F1sh Camera RX metrics: see /metrics (and /trace)\n",
+                     headOnly);
+    } else {
+        sendResponse(socket, "404 Not Found", "text/plain", "Not found\n", headOnly);
+    }
+}
+
+void MetricsManager::sendResponse(QTcpSocket *socket, const QByteArray &status,
+                                  const QByteArray &contentType, const QByteArray &body, bool headOnly)
+{
+    QByteArray response;
+    response += "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    if (!headOnly) {
+        response += body;
+    }
+
+    socket->write(response);
+    socket->disconnectFromHost();
+}
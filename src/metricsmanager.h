@@ -0,0 +1,54 @@
+#ifndef METRICSMANAGER_H
+#define METRICSMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QHostAddress>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Optional embedded HTTP endpoint serving Prometheus text format on /metrics.
+// Counters themselves live in metrics.h; this class only renders them on demand.
+class MetricsManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool isRunning READ isRunning NOTIFY isRunningChanged)
+    Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
+    Q_PROPERTY(QString bindAddress READ bindAddress WRITE setBindAddress NOTIFY bindAddressChanged)
+
+public:
+    explicit MetricsManager(QObject *parent = nullptr);
+    ~MetricsManager();
+
+    bool isRunning() const;
+    int port() const { return m_port; }
+    QString bindAddress() const { return m_bindAddress.toString(); }
+
+    void setPort(int port);
+    void setBindAddress(const QString &address);
+
+    Q_INVOKABLE bool start();
+    Q_INVOKABLE void stop();
+
+signals:
+    void isRunningChanged();
+    void portChanged();
+    void bindAddressChanged();
+
+private slots:
+    void onNewConnection();
+
+private:
+    void handleRequest(QTcpSocket *socket);
+    void sendResponse(QTcpSocket *socket, const QByteArray &status,
+                      const QByteArray &contentType, const QByteArray &body, bool headOnly = false);
+
+    QTcpServer *m_server = nullptr;
+    QHostAddress m_bindAddress = QHostAddress(QHostAddress::LocalHost);
+    int m_port = 9464;
+
+    static const int MAX_REQUEST_SIZE = 8192;
+};
+
+#endif // METRICSMANAGER_H
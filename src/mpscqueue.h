@@ -0,0 +1,69 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov).
+//
+// push() may be called from any number of threads concurrently and never
+// blocks: it is one allocation and one atomic exchange. pop() must only be
+// called from a single consumer thread. A push that is still in progress can
+// make pop() report empty for a moment; the element is returned by a later
+// pop(), so consumers should drain periodically rather than rely on a wakeup
+// for each element. T must be default-constructible.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    {
+        Node *stub = new Node;
+        m_head.store(stub, std::memory_order_relaxed);
+        m_tail = stub;
+    }
+
+    ~MpscQueue()
+    {
+        T discard;
+        while (pop(discard)) {}
+        delete m_tail;
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value)
+    {
+        Node *node = new Node;
+        node->value = std::move(value);
+        Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only
+    bool pop(T &out)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        // next becomes the new stub; its value is moved out
+        out = std::move(next->value);
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node*> m_head;   // Producers link new nodes here
+    Node *m_tail;                // Consumer side, always points at the stub
+};
+
+#endif // MPSCQUEUE_H
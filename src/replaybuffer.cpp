@@ -0,0 +1,426 @@
+#include "replaybuffer.h"
+#include <gst/app/gstappsrc.h>
+#include <cstring>
+
+static constexpr GstClockTime kExportTimeout = 30 * GST_SECOND;
+static constexpr GstClockTime kStitchGap = 33 * GST_MSECOND;  // Gap left at a timeline restart without durations
+
+// ============ EncodedRingBuffer Implementation ============
+
+EncodedRingBuffer::~EncodedRingBuffer()
+{
+    release();
+    gst_caps_replace(&m_caps, nullptr);
+}
+
+void EncodedRingBuffer::allocate(qint64 capacityBytes, int maxUnits)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // A snapshot still copying from the old arena holds its own reference
+    if (m_arena) {
+        gst_memory_unmap(m_arena, &m_arenaMap);
+        gst_memory_unref(m_arena);
+        m_arena = nullptr;
+        m_arenaMap = GST_MAP_INFO_INIT;
+    }
+    m_arenaSize = 0;
+    if (capacityBytes > 0) {
+        m_arena = gst_allocator_alloc(nullptr, gsize(capacityBytes), nullptr);
+        if (m_arena && gst_memory_map(m_arena, &m_arenaMap, GST_MAP_READWRITE)) {
+            // Zero-filled so the pages are committed now rather than on the streaming thread
+            memset(m_arenaMap.data, 0, m_arenaMap.size);
+            m_arenaSize = capacityBytes;
+        } else if (m_arena) {
+            gst_memory_unref(m_arena);
+            m_arena = nullptr;
+        }
+    }
+
+    m_units = m_arenaSize > 0 ? QVector<Unit>(qMax(1, maxUnits)) : QVector<Unit>();
+    m_firstSeq += quint64(m_count);
+    m_head = 0;
+    m_count = 0;
+    m_writePos = 0;
+    m_usedBytes = 0;
+    m_timeOffset = 0;
+    m_resync = false;
+}
+
+void EncodedRingBuffer::release()
+{
+    allocate(0, 0);
+}
+
+void EncodedRingBuffer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_firstSeq += quint64(m_count);
+    m_head = 0;
+    m_count = 0;
+    m_writePos = 0;
+    m_usedBytes = 0;
+    m_timeOffset = 0;
+    m_resync = false;
+}
+
+void EncodedRingBuffer::setRetention(GstClockTime retention)
+{
+    QMutexLocker locker(&m_mutex);
+    m_retention = retention;
+    trimToRetention();
+}
+
+void EncodedRingBuffer::setCaps(GstCaps *caps)
+{
+    QMutexLocker locker(&m_mutex);
+    gst_caps_replace(&m_caps, caps);
+}
+
+void EncodedRingBuffer::push(GstBuffer *buffer)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 capacity = m_arenaSize;
+    const qint64 size = qint64(gst_buffer_get_size(buffer));
+    // A unit this large would flush nearly all history; skip it instead
+    if (capacity == 0 || size == 0 || size > capacity / 4) {
+        return;
+    }
+
+    const bool keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (m_count == 0 && !keyframe) {
+        return;
+    }
+
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    GstClockTime dts = GST_BUFFER_DTS(buffer);
+    stitchTimeline(GST_CLOCK_TIME_IS_VALID(dts) ? dts : pts, keyframe);
+    if (m_resync) {
+        return;
+    }
+
+    if (m_count == m_units.size()) {
+        evictOldest();
+        evictToKeyframe();
+    }
+
+    // Units are laid out back to back; one that doesn't fit before the end of
+    // the arena goes to the start, abandoning the tail (which only holds
+    // units older than everything at the start)
+    qint64 pos = m_count > 0 ? m_writePos : 0;
+    if (pos + size > capacity) {
+        while (m_count > 0 && unitAt(0).offset >= pos) {
+            evictOldest();
+        }
+        pos = 0;
+    }
+    while (m_count > 0) {
+        const Unit &oldest = unitAt(0);
+        if (oldest.offset >= pos + size || pos >= oldest.offset + oldest.size) {
+            break;
+        }
+        evictOldest();
+    }
+    evictToKeyframe();
+
+    // Evicting may have emptied the buffer; history must restart at a keyframe
+    if (m_count == 0) {
+        pos = 0;
+        if (!keyframe) {
+            return;
+        }
+    }
+
+    gst_buffer_extract(buffer, 0, m_arenaMap.data + pos, size_t(size));
+
+    Unit &unit = m_units[(m_head + m_count) % m_units.size()];
+    unit.offset = pos;
+    unit.size = qint32(size);
+    unit.pts = GST_CLOCK_TIME_IS_VALID(pts) ? pts + m_timeOffset : pts;
+    unit.dts = GST_CLOCK_TIME_IS_VALID(dts) ? dts + m_timeOffset : dts;
+    unit.duration = GST_BUFFER_DURATION(buffer);
+    unit.keyframe = keyframe;
+
+    m_count++;
+    m_writePos = pos + size;
+    m_usedBytes += size;
+
+    trimToRetention();
+}
+
+GstBufferList *EncodedRingBuffer::snapshot(GstClockTime duration, GstCaps **caps) const
+{
+    // Only the index is read under the lock; payloads are copied unlocked so
+    // push() on the streaming thread never waits for a multi-megabyte copy
+    QVector<Unit> units;
+    GstMemory *arena = nullptr;
+    const guint8 *data = nullptr;
+    quint64 firstSeq = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (caps) {
+            *caps = m_caps ? gst_caps_ref(m_caps) : nullptr;
+        }
+        if (m_count == 0) {
+            return nullptr;
+        }
+
+        // Latest keyframe that still gives at least `duration` of video
+        int start = 0;
+        GstClockTime newest = unitTime(unitAt(m_count - 1));
+        if (duration > 0 && GST_CLOCK_TIME_IS_VALID(newest) && newest > duration) {
+            for (int i = 0; i < m_count; ++i) {
+                const Unit &unit = unitAt(i);
+                GstClockTime time = unitTime(unit);
+                if (!GST_CLOCK_TIME_IS_VALID(time) || time > newest - duration) {
+                    break;
+                }
+                if (unit.keyframe) {
+                    start = i;
+                }
+            }
+        }
+
+        units.reserve(m_count - start);
+        for (int i = start; i < m_count; ++i) {
+            units.append(unitAt(i));
+        }
+        // Keeps the storage alive if allocate() or release() replaces it meanwhile
+        arena = gst_memory_ref(m_arena);
+        data = m_arenaMap.data;
+        firstSeq = m_firstSeq + quint64(start);
+    }
+
+    QVector<GstBuffer*> copies(units.size());
+    for (int i = 0; i < units.size(); ++i) {
+        copies[i] = gst_buffer_new_memdup(data + units[i].offset, gsize(units[i].size));
+    }
+    gst_memory_unref(arena);
+
+    // push() only overwrites units it has evicted. Drop every unit evicted
+    // while copying, then anything before the next keyframe left after them.
+    int first = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_firstSeq > firstSeq) {
+            first = int(qMin<quint64>(m_firstSeq - firstSeq, quint64(units.size())));
+        }
+    }
+    while (first < units.size() && !units[first].keyframe) {
+        first++;
+    }
+    for (int i = 0; i < first; ++i) {
+        gst_buffer_unref(copies[i]);
+    }
+    if (first == units.size()) {
+        return nullptr;
+    }
+
+    GstClockTime base = unitTime(units[first]);
+    if (!GST_CLOCK_TIME_IS_VALID(base)) {
+        base = 0;
+    }
+
+    GstBufferList *list = gst_buffer_list_new_sized(guint(units.size() - first));
+    for (int i = first; i < units.size(); ++i) {
+        const Unit &unit = units[i];
+        GstBuffer *copy = copies[i];
+
+        if (GST_CLOCK_TIME_IS_VALID(unit.pts)) {
+            GST_BUFFER_PTS(copy) = unit.pts > base ? unit.pts - base : 0;
+        }
+        if (GST_CLOCK_TIME_IS_VALID(unit.dts)) {
+            GST_BUFFER_DTS(copy) = unit.dts > base ? unit.dts - base : 0;
+        }
+        GST_BUFFER_DURATION(copy) = unit.duration;
+        if (!unit.keyframe) {
+            GST_BUFFER_FLAG_SET(copy, GST_BUFFER_FLAG_DELTA_UNIT);
+        }
+        if (i == first) {
+            GST_BUFFER_FLAG_SET(copy, GST_BUFFER_FLAG_DISCONT);
+        }
+        gst_buffer_list_add(list, copy);
+    }
+    return list;
+}
+
+bool EncodedRingBuffer::isAllocated() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_arenaSize > 0;
+}
+
+qint64 EncodedRingBuffer::capacityBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_arenaSize + qint64(m_units.size()) * qint64(sizeof(Unit));
+}
+
+qint64 EncodedRingBuffer::usedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_usedBytes;
+}
+
+GstClockTime EncodedRingBuffer::bufferedDuration() const
+{
+    QMutexLocker locker(&m_mutex);
+    return durationLocked();
+}
+
+GstClockTime EncodedRingBuffer::unitTime(const Unit &unit)
+{
+    return GST_CLOCK_TIME_IS_VALID(unit.dts) ? unit.dts : unit.pts;
+}
+
+void EncodedRingBuffer::stitchTimeline(GstClockTime time, bool keyframe)
+{
+    if (!GST_CLOCK_TIME_IS_VALID(time) || m_count == 0) {
+        return;
+    }
+
+    // A rebuilt pipeline starts over near zero running time; continue after the
+    // stored units and wait for a keyframe, as the new decoder chain will
+    const Unit &last = unitAt(m_count - 1);
+    GstClockTime lastTime = unitTime(last);
+    if (GST_CLOCK_TIME_IS_VALID(lastTime) && time + m_timeOffset < lastTime) {
+        GstClockTime resume = lastTime + (GST_CLOCK_TIME_IS_VALID(last.duration) ? last.duration : kStitchGap);
+        m_timeOffset = resume - time;
+        m_resync = true;
+    }
+    if (m_resync && keyframe) {
+        m_resync = false;
+    }
+}
+
+void EncodedRingBuffer::evictOldest()
+{
+    m_usedBytes -= unitAt(0).size;
+    m_firstSeq++;
+    m_head = (m_head + 1) % m_units.size();
+    m_count--;
+}
+
+void EncodedRingBuffer::evictToKeyframe()
+{
+    while (m_count > 0 && !unitAt(0).keyframe) {
+        evictOldest();
+    }
+}
+
+void EncodedRingBuffer::trimToRetention()
+{
+    if (m_retention == 0 || m_count < 2) {
+        return;
+    }
+
+    GstClockTime newest = unitTime(unitAt(m_count - 1));
+    if (!GST_CLOCK_TIME_IS_VALID(newest)) {
+        return;
+    }
+
+    // Drop the oldest GOP while the rest still covers the retention window
+    while (true) {
+        int next = 1;
+        while (next < m_count && !unitAt(next).keyframe) {
+            next++;
+        }
+        if (next >= m_count) {
+            return;
+        }
+
+        GstClockTime nextTime = unitTime(unitAt(next));
+        if (!GST_CLOCK_TIME_IS_VALID(nextTime) || nextTime > newest || newest - nextTime < m_retention) {
+            return;
+        }
+        for (int i = 0; i < next; ++i) {
+            evictOldest();
+        }
+    }
+}
+
+GstClockTime EncodedRingBuffer::durationLocked() const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const Unit &last = unitAt(m_count - 1);
+    GstClockTime first = unitTime(unitAt(0));
+    GstClockTime newest = unitTime(last);
+    if (!GST_CLOCK_TIME_IS_VALID(first) || !GST_CLOCK_TIME_IS_VALID(newest) || newest < first) {
+        return 0;
+    }
+    return newest - first + (GST_CLOCK_TIME_IS_VALID(last.duration) ? last.duration : 0);
+}
+
+// ============ ReplayExporter Implementation ============
+
+void ReplayExporter::doExport(qint64 durationMs, const QString &path, const QString &muxer)
+{
+    GstCaps *caps = nullptr;
+    GstBufferList *units = m_buffer->snapshot(GstClockTime(qMax<qint64>(0, durationMs)) * GST_MSECOND, &caps);
+    if (!units) {
+        if (caps) gst_caps_unref(caps);
+        emit exportFinished(false, path, "Replay buffer is empty");
+        return;
+    }
+
+    const guint unitCount = gst_buffer_list_length(units);
+    const QString description =
+        QString("appsrc name=src format=time max-bytes=0 ! h264parse ! %1 ! filesink name=sink").arg(muxer);
+
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(description.toUtf8().constData(), &error);
+    if (!pipeline || error) {
+        QString message = error ? QString::fromUtf8(error->message) : QString("unknown error");
+        if (error) g_error_free(error);
+        if (pipeline) gst_object_unref(pipeline);
+        gst_buffer_list_unref(units);
+        if (caps) gst_caps_unref(caps);
+        emit exportFinished(false, path, QString("Failed to create export pipeline: %1").arg(message));
+        return;
+    }
+
+    GstElement *source = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    if (caps) {
+        g_object_set(source, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+    }
+    g_object_set(sink, "location", path.toUtf8().constData(), nullptr);
+    gst_object_unref(sink);
+
+    // Not live and no clock sync: the muxer runs through the snapshot as fast as it can
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    gst_app_src_push_buffer_list(GST_APP_SRC(source), units);
+    gst_app_src_end_of_stream(GST_APP_SRC(source));
+    gst_object_unref(source);
+
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *message = gst_bus_timed_pop_filtered(bus, kExportTimeout,
+                                                     GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    gst_object_unref(bus);
+
+    bool success = false;
+    QString result;
+    if (!message) {
+        result = "Export timed out";
+    } else if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR) {
+        GError *exportError = nullptr;
+        gst_message_parse_error(message, &exportError, nullptr);
+        result = exportError ? QString::fromUtf8(exportError->message) : QString("Unknown error");
+        if (exportError) g_error_free(exportError);
+    } else {
+        success = true;
+        result = QString("%1 access units written").arg(unitCount);
+    }
+    if (message) gst_message_unref(message);
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    emit exportFinished(success, path, result);
+}
@@ -0,0 +1,103 @@
+#ifndef REPLAYBUFFER_H
+#define REPLAYBUFFER_H
+
+#include <QObject>
+#include <QVector>
+#include <QMutex>
+#include <QString>
+#include <gst/gst.h>
+
+// Bounded in-memory history of encoded H.264 access units, fed from the
+// parser output. Storage is allocated once by allocate(): a byte arena for
+// the payloads and a fixed-size index. Old data is evicted a whole GOP at a
+// time, so the oldest retained unit is always a keyframe and any snapshot
+// decodes from its first buffer. When the timeline restarts (a pipeline
+// rebuild), new timestamps are shifted to continue after the stored ones, so
+// the history from just before a stall survives the restart.
+//
+// push() runs on the streaming thread; everything else may run on any thread.
+// snapshot() copies payloads without holding the lock, so it can take its
+// time on a worker thread without stalling push().
+class EncodedRingBuffer
+{
+public:
+    EncodedRingBuffer() = default;
+    ~EncodedRingBuffer();
+
+    // (Re)allocates storage and drops any buffered data. 0 frees it.
+    void allocate(qint64 capacityBytes, int maxUnits);
+    void release();
+    // Drops buffered data (e.g. on a timeline break) but keeps the storage
+    void clear();
+
+    // Units older than this are evicted even when memory is left, 0 = keep all that fits
+    void setRetention(GstClockTime retention);
+
+    void setCaps(GstCaps *caps);
+    void push(GstBuffer *buffer);
+
+    // Copies the newest `duration` (0 = everything), starting at a keyframe,
+    // into new buffers with timestamps rebased to zero. Units evicted by push()
+    // during the copy are left out. Returns nullptr if nothing is buffered.
+    // *caps receives a reference to the stream caps.
+    GstBufferList *snapshot(GstClockTime duration, GstCaps **caps) const;
+
+    bool isAllocated() const;
+    qint64 capacityBytes() const;
+    qint64 usedBytes() const;
+    GstClockTime bufferedDuration() const;
+
+private:
+    struct Unit {
+        qint64 offset = 0;
+        qint32 size = 0;
+        GstClockTime pts = GST_CLOCK_TIME_NONE;
+        GstClockTime dts = GST_CLOCK_TIME_NONE;
+        GstClockTime duration = GST_CLOCK_TIME_NONE;
+        bool keyframe = false;
+    };
+
+    const Unit &unitAt(int index) const { return m_units[(m_head + index) % m_units.size()]; }
+    static GstClockTime unitTime(const Unit &unit);
+    void stitchTimeline(GstClockTime time, bool keyframe);
+    void evictOldest();
+    void evictToKeyframe();
+    void trimToRetention();
+    GstClockTime durationLocked() const;
+
+    mutable QMutex m_mutex;
+    GstMemory *m_arena = nullptr;    // Payload storage, mapped for its whole lifetime
+    GstMapInfo m_arenaMap = GST_MAP_INFO_INIT;
+    qint64 m_arenaSize = 0;
+    QVector<Unit> m_units;   // Circular index, m_count entries starting at m_head
+    int m_head = 0;
+    int m_count = 0;
+    quint64 m_firstSeq = 0;          // Sequence number of unitAt(0); counts every eviction
+    qint64 m_writePos = 0;
+    qint64 m_usedBytes = 0;
+    GstClockTime m_retention = 0;
+    GstClockTime m_timeOffset = 0;   // Added to incoming timestamps after a timeline restart
+    bool m_resync = false;           // Timeline restarted: skip deltas until the next keyframe
+    GstCaps *m_caps = nullptr;
+};
+
+// Worker that muxes a snapshot of the ring buffer to a file on its own thread
+class ReplayExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplayExporter(const EncodedRingBuffer *buffer, QObject *parent = nullptr)
+        : QObject(parent), m_buffer(buffer) {}
+
+public slots:
+    // muxer is gst-launch syntax (e.g. "mp4mux"), fed by h264parse
+    void doExport(qint64 durationMs, const QString &path, const QString &muxer);
+
+signals:
+    void exportFinished(bool success, const QString &path, const QString &message);
+
+private:
+    const EncodedRingBuffer *m_buffer;
+};
+
+#endif // REPLAYBUFFER_H
@@ -1,6 +1,9 @@
 #include "serialportmanager.h"
 #include "logmanager.h"
+#include "metrics.h"
+#include "trace.h"
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QThread>
@@ -8,6 +11,13 @@
 static const QByteArray kProbeMessage = "{\"status\":1}\n";
 static const QByteArray kExpectedResponse = "{\"status\":1}";
 
+static Metrics::Histogram s_probeDuration("f1sh_serial_probe_duration_seconds",
+                                          "Time spent probing a single serial port for a camera",
+                                          {0.05, 0.1, 0.25, 0.5, 1.0, 1.5, 2.0, 3.0, 5.0});
+static Metrics::Histogram s_detectionDuration("f1sh_serial_detection_duration_seconds",
+                                              "Time spent on one full serial port detection cycle",
+                                              {0.01, 0.1, 0.5, 1.0, 2.0, 5.0, 10.0, 20.0});
+
 // ============ SerialPortWorker Implementation ============
 
 QStringList SerialPortWorker::listAvailablePorts()
@@ -53,7 +63,8 @@ QStringList SerialPortWorker::listAvailablePorts()
 
 bool SerialPortWorker::probePort(const QString &portName)
 {
-    LogManager::log(QString("Probing %1").arg(portName));
+    TRACE_SCOPE("serial", "probe", portName);
+    LOG_DEBUG(Serial, QString("Probing %1").arg(portName));
 
     QSerialPort serial;
     serial.setPortName(portName);
@@ -64,11 +75,11 @@ bool SerialPortWorker::probePort(const QString &portName)
     serial.setFlowControl(QSerialPort::NoFlowControl);
 
     if (!serial.open(QIODevice::ReadWrite)) {
-        LogManager::log(QString("  Failed to open %1: %2").arg(portName, serial.errorString()));
+        LOG_DEBUG(Serial, QString("  Failed to open %1: %2").arg(portName, serial.errorString()));
         return false;
     }
 
-    LogManager::log(QString("  Successfully opened %1").arg(portName));
+    LOG_DEBUG(Serial, QString("  Successfully opened %1").arg(portName));
 
     // Clear any pending data in the buffer
     serial.clear();
@@ -79,63 +90,59 @@ bool SerialPortWorker::probePort(const QString &portName)
     // Drain any existing data
     if (serial.bytesAvailable() > 0) {
         QByteArray garbage = serial.readAll();
-        LogManager::log(QString("  Cleared %1 bytes from buffer: %2")
+        LOG_DEBUG(Serial, QString("  Cleared %1 bytes from buffer: %2")
             .arg(garbage.size())
             .arg(QString::fromUtf8(garbage).trimmed().left(100)));
     }
 
     // Send probe message
-    LogManager::log(QString("  Sending probe: %1").arg(QString::fromUtf8(kProbeMessage).trimmed()));
+    LOG_DEBUG(Serial, QString("  Sending probe: %1").arg(QString::fromUtf8(kProbeMessage).trimmed()));
     qint64 written = serial.write(kProbeMessage);
 
     // Wait for write to complete
     if (!serial.waitForBytesWritten(1000)) {
-        LogManager::log(QString("  Failed to write to %1: %2").arg(portName, serial.errorString()));
+        LOG_DEBUG(Serial, QString("  Failed to write to %1: %2").arg(portName, serial.errorString()));
         serial.close();
         return false;
     }
 
-    LogManager::log(QString("  Sent %1 bytes, waiting for response...").arg(written));
+    LOG_DEBUG(Serial, QString("  Sent %1 bytes, waiting for response...").arg(written));
 
     // Wait for response with longer timeout (1.5 seconds)
     if (!serial.waitForReadyRead(1500)) {
-        LogManager::log(QString("  No response from %1 (timeout after 1500ms)").arg(portName));
+        LOG_DEBUG(Serial, QString("  No response from %1 (timeout after 1500ms)").arg(portName));
         serial.close();
         return false;
     }
 
     // Read response
     QByteArray response = serial.readAll();
-    LogManager::log(QString("  Initial read: %1 bytes").arg(response.size()));
+    LOG_DEBUG(Serial, QString("  Initial read: %1 bytes").arg(response.size()));
 
     // Continue reading if more data is available
     while (serial.waitForReadyRead(100)) {
         QByteArray more = serial.readAll();
         response.append(more);
-        LogManager::log(QString("  Additional read: %1 bytes").arg(more.size()));
+        LOG_DEBUG(Serial, QString("  Additional read: %1 bytes").arg(more.size()));
     }
 
     serial.close();
 
     if (response.isEmpty()) {
-        LogManager::log(QString("  No response from %1").arg(portName));
+        LOG_DEBUG(Serial, QString("  No response from %1").arg(portName));
         return false;
     }
 
     // Log raw bytes for debugging
-    QString hexDump;
-    for (int i = 0; i < qMin(response.size(), 64); i++) {
-        hexDump += QString("%1 ").arg((unsigned char)response[i], 2, 16, QChar('0'));
-    }
-    LogManager::log(QString("  Raw bytes: %1").arg(hexDump.trimmed()));
-    LogManager::log(QString("  Received %1 bytes: [%2]").arg(response.size()).arg(QString::fromUtf8(response).trimmed()));
+    LOG_DEBUG(Serial, QString("  Raw bytes: %1").arg(QString::fromLatin1(response.left(64).toHex(' '))));
+    LOG_DEBUG(Serial, QString("  Received %1 bytes: [%2]").arg(response.size()).arg(QString::fromUtf8(response).trimmed()));
 
     bool found = response.contains(kExpectedResponse);
 
     if (found) {
-        LogManager::log(QString("  CAMERA DETECTED on %1!").arg(portName));
+        LOG_INFO(Serial, QString("  CAMERA DETECTED on %1!").arg(portName));
     } else {
-        LogManager::log(QString("  Response doesn't match expected: %1").arg(QString::fromUtf8(kExpectedResponse)));
+        LOG_DEBUG(Serial, QString("  Response doesn't match expected: %1").arg(QString::fromUtf8(kExpectedResponse)));
     }
 
     return found;
@@ -145,15 +152,23 @@ void SerialPortWorker::doDetection()
 {
     QStringList cameras;
     QString foundPort;
+    QElapsedTimer detectionTimer;
+    detectionTimer.start();
 
     // Get list of available serial ports
     QStringList ports = listAvailablePorts();
-    LogManager::log(QString("Scanning %1 serial ports: %2").arg(ports.size()).arg(ports.join(", ")));
+    // Auto-detect runs every 2 s; one scan summary a minute is enough
+    LOG_AT_RATE(Serial, Info, 1.0 / 60, 1, QString("Scanning %1 serial ports: %2").arg(ports.size()).arg(ports.join(", ")));
 
     for (const QString &portName : ports) {
-        if (probePort(portName)) {
+        QElapsedTimer probeTimer;
+        probeTimer.start();
+        bool found = probePort(portName);
+        s_probeDuration.observeMs(probeTimer.elapsed());
+
+        if (found) {
             cameras.append(portName);
-            LogManager::log(QString("Camera found on %1").arg(portName));
+            LOG_INFO(Serial, QString("Camera found on %1").arg(portName));
             if (foundPort.isEmpty()) {
                 foundPort = portName;
             }
@@ -161,9 +176,10 @@ void SerialPortWorker::doDetection()
     }
 
     if (cameras.isEmpty()) {
-        LogManager::log("No camera found on any serial port");
+        LOG_AT_RATE(Serial, Info, 1.0 / 60, 1, "No camera found on any serial port");
     }
 
+    s_detectionDuration.observeMs(detectionTimer.elapsed());
     emit detectionFinished(!cameras.isEmpty(), foundPort, cameras);
 }
 
@@ -218,13 +234,13 @@ void SerialPortManager::stopAutoDetect()
 void SerialPortManager::pauseAutoDetect()
 {
     m_autoDetectPaused = true;
-    LogManager::log("Auto-detection paused");
+    LOG_INFO(Serial, "Auto-detection paused");
 }
 
 void SerialPortManager::resumeAutoDetect()
 {
     m_autoDetectPaused = false;
-    LogManager::log("Auto-detection resumed");
+    LOG_INFO(Serial, "Auto-detection resumed");
 }
 
 void SerialPortManager::triggerDetection()
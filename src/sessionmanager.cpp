@@ -0,0 +1,339 @@
+#include "sessionmanager.h"
+#include "streammanager.h"
+#include "grpcmanager.h"
+#include "configmanager.h"
+#include "logmanager.h"
+#include <QQmlEngine>
+#include <QThread>
+
+// ============ CameraSession Implementation ============
+
+CameraSession::CameraSession(const QVariantMap &camera, int port, const QString &providerId, QObject *parent)
+    : QObject(parent)
+    , m_name(camera.value("name").toString())
+    , m_ip(camera.value("ip").toString())
+    , m_port(port)
+    , m_controlPort(camera.value("controlPort", 50051).toInt())
+    , m_providerId(providerId)
+    , m_stream(new StreamManager(this))
+    , m_grpc(new GrpcManager(this))
+{
+    if (m_name.isEmpty()) {
+        m_name = m_ip;
+    }
+
+    m_stream->setPort(m_port);
+    m_stream->setHost(m_ip);
+    m_stream->setDiscoveredProtocol(camera.value("protocol", "udp").toString());
+    m_grpc->setServerAddress(QString("%1:%2").arg(m_ip).arg(m_controlPort));
+}
+
+QObject *CameraSession::stream() const
+{
+    return m_stream;
+}
+
+void CameraSession::setBudget(bool active, int frameRate)
+{
+    if (m_active != active || m_frameRateBudget != frameRate) {
+        m_active = active;
+        m_frameRateBudget = frameRate;
+        emit budgetChanged();
+    }
+}
+
+void CameraSession::setStatus(const QString &status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged();
+    }
+}
+
+// ============ SessionManager Implementation ============
+
+SessionManager::SessionManager(QQmlEngine *engine, ConfigManager *config, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_config(config)
+{
+}
+
+SessionManager::~SessionManager()
+{
+    clear();
+}
+
+QList<QObject*> SessionManager::sessions() const
+{
+    QList<QObject*> result;
+    for (CameraSession *session : m_sessions) {
+        result.append(session);
+    }
+    return result;
+}
+
+void SessionManager::setBasePort(int port)
+{
+    if (m_basePort != port) {
+        m_basePort = port;
+        emit basePortChanged();
+    }
+}
+
+void SessionManager::setActiveIndex(int index)
+{
+    if (m_activeIndex != index) {
+        m_activeIndex = index;
+        emit budgetsChanged();
+        applyBudgets();
+    }
+}
+
+void SessionManager::setInactiveFrameRate(int fps)
+{
+    fps = qMax(1, fps);
+    if (m_inactiveFrameRate != fps) {
+        m_inactiveFrameRate = fps;
+        emit budgetsChanged();
+        applyBudgets();
+    }
+}
+
+void SessionManager::setInactiveScale(double scale)
+{
+    scale = qBound(0.1, scale, 1.0);
+    if (!qFuzzyCompare(m_inactiveScale, scale)) {
+        m_inactiveScale = scale;
+        emit budgetsChanged();
+        applyBudgets();
+    }
+}
+
+void SessionManager::setTxBudgetEnabled(bool enabled)
+{
+    if (m_txBudgetEnabled != enabled) {
+        m_txBudgetEnabled = enabled;
+        emit budgetsChanged();
+        applyBudgets();
+    }
+}
+
+void SessionManager::setTileSize(int index, const QSize &size)
+{
+    if (index < 0 || index >= m_sessions.size() || m_sessions[index]->tileSize() == size) {
+        return;
+    }
+    m_sessions[index]->setTileSize(size);
+    applyBudgets();
+}
+
+void SessionManager::applyBudgets()
+{
+    int fullRate = m_config ? m_config->framerate() : 30;
+
+    for (int i = 0; i < m_sessions.size(); ++i) {
+        CameraSession *session = m_sessions[i];
+        StreamManager *stream = session->streamManager();
+        bool active = i == m_activeIndex || m_sessions.size() == 1;
+
+        // Resolution: the pipeline scales to the (shrunk) tile before conversion
+        QSize viewport = session->tileSize();
+        if (!active && !viewport.isEmpty()) {
+            viewport = QSize(qMax(2, int(viewport.width() * m_inactiveScale)),
+                             qMax(2, int(viewport.height() * m_inactiveScale)));
+        }
+        stream->setViewportSize(viewport);
+
+        // Frame rate: throttle delivery locally, and optionally at the encoder
+        int frameRate = active ? 0 : m_inactiveFrameRate;
+        stream->setMaxFrameRate(frameRate);
+        session->setBudget(active, frameRate);
+
+        int txRate = (m_txBudgetEnabled && !active) ? qMin(fullRate, m_inactiveFrameRate) : fullRate;
+        if (session->isConnected() && session->txFramerate() != txRate) {
+            sendCameraConfig(session, txRate);
+        }
+    }
+}
+
+int SessionManager::allocatePort() const
+{
+    // RTP convention: even ports, leaving port + 1 free for RTCP
+    for (int port = m_basePort; port < 65534; port += 2) {
+        bool used = false;
+        for (const CameraSession *session : m_sessions) {
+            if (session->port() == port) {
+                used = true;
+                break;
+            }
+        }
+        if (!used) {
+            return port;
+        }
+    }
+    return -1;
+}
+
+bool SessionManager::addCamera(const QVariantMap &camera)
+{
+    QString ip = camera.value("ip").toString();
+    if (ip.isEmpty()) {
+        LOG_INFO(Stream, "Session: camera has no address, not adding");
+        return false;
+    }
+
+    for (const CameraSession *session : m_sessions) {
+        if (session->ip() == ip) {
+            LOG_INFO(Stream, QString("Session: %1 is already in the session").arg(ip));
+            return false;
+        }
+    }
+
+    int port = allocatePort();
+    if (port < 0) {
+        LOG_WARNING(Stream, "Session: no free UDP port left");
+        return false;
+    }
+
+    QString providerId = QString("session%1").arg(m_nextProviderId++);
+    CameraSession *session = new CameraSession(camera, port, providerId, this);
+    m_sessions.append(session);
+
+    // The engine takes ownership of the provider; frames are served as image://sessionN/frame
+    if (m_engine) {
+        m_engine->addImageProvider(providerId, session->streamManager()->imageProvider());
+    }
+
+    LOG_INFO(Stream, QString("Session: added %1 (%2) on port %3 as image://%4")
+                    .arg(session->name(), ip).arg(port).arg(providerId));
+
+    rebalanceDecoderThreads();
+    applyBudgets();
+    emit sessionsChanged();
+    return true;
+}
+
+void SessionManager::removeCamera(int index)
+{
+    if (index < 0 || index >= m_sessions.size()) {
+        return;
+    }
+
+    CameraSession *session = m_sessions.takeAt(index);
+    LOG_INFO(Stream, QString("Session: removing %1").arg(session->name()));
+
+    // Stop first so no streaming thread touches the provider the engine deletes
+    session->streamManager()->stop();
+    if (m_engine) {
+        m_engine->removeImageProvider(session->providerId());
+    }
+    session->deleteLater();
+
+    rebalanceDecoderThreads();
+    applyBudgets();
+    emit sessionsChanged();
+}
+
+void SessionManager::clear()
+{
+    while (!m_sessions.isEmpty()) {
+        removeCamera(m_sessions.size() - 1);
+    }
+}
+
+void SessionManager::startAll()
+{
+    for (CameraSession *session : m_sessions) {
+        connectCamera(session);
+        session->streamManager()->start();
+    }
+}
+
+void SessionManager::stopAll()
+{
+    for (CameraSession *session : m_sessions) {
+        session->streamManager()->stop();
+        session->setStatus("Stopped");
+    }
+}
+
+void SessionManager::connectCamera(CameraSession *session)
+{
+    GrpcManager *grpc = session->grpcManager();
+
+    // Drop handlers left over from an earlier attempt that never got a reply
+    disconnect(grpc, nullptr, session, nullptr);
+
+    // Health check first, then point the camera at this RX and the session's own port
+    connect(grpc, &GrpcManager::healthCheckResult, session, [this, session, grpc](bool success) {
+        if (!success) {
+            session->setStatus("Camera unreachable");
+            LOG_WARNING(Stream, QString("Session: %1 health check failed").arg(session->name()));
+            return;
+        }
+
+        if (m_config && m_config->multicastEnabled()) {
+            // Sessions can share one group since each uses its own port
+            session->streamManager()->setMulticastInterface(m_config->multicastInterface());
+            session->streamManager()->setMulticastGroup(m_config->multicastGroup());
+        }
+
+        session->setStatus("Configuring camera...");
+        int framerate = m_config ? m_config->framerate() : 30;
+        if (m_txBudgetEnabled && session->frameRateBudget() > 0) {
+            framerate = qMin(framerate, session->frameRateBudget());
+        }
+        sendCameraConfig(session, framerate);
+    }, Qt::SingleShotConnection);
+
+    // Stays connected: budget changes send further UpdateConfig calls
+    connect(grpc, &GrpcManager::updateConfigResult, session, [this, session](bool success, const QString &message) {
+        session->setConnected(success);
+        session->setStatus(success ? QString("Streaming") : QString("Config failed: %1").arg(message));
+        LOG_INFO(Stream, QString("Session: %1 UpdateConfig %2 (%3)")
+                        .arg(session->name(), success ? "succeeded" : "failed", message));
+
+        // Budgets may have changed while the call was in flight
+        if (success) {
+            applyBudgets();
+        }
+    });
+
+    session->setStatus("Connecting...");
+    grpc->healthCheck();
+}
+
+void SessionManager::sendCameraConfig(CameraSession *session, int framerate)
+{
+    QString destination = m_config ? m_config->detectLocalIpForTarget(session->ip()) : QString();
+    if (m_config && m_config->multicastEnabled()) {
+        destination = m_config->multicastGroup();
+    }
+
+    int width = m_config ? m_config->width() : 1280;
+    int height = m_config ? m_config->height() : 720;
+
+    // GrpcManager ignores calls while busy; applyBudgets() retries after the reply
+    if (session->grpcManager()->isBusy()) {
+        return;
+    }
+
+    session->setTxFramerate(framerate);
+    LOG_INFO(Stream, QString("Session: %1 -> %2:%3 %4x%5@%6")
+                    .arg(session->name(), destination).arg(session->port())
+                    .arg(width).arg(height).arg(framerate));
+    session->grpcManager()->updateConfig(destination, session->port(), width, height, framerate);
+}
+
+void SessionManager::rebalanceDecoderThreads()
+{
+    // Share the cores between software decoders instead of every decoder
+    // spawning one thread per core; takes effect on the next pipeline build
+    int sessions = qMax(1, int(m_sessions.size()));
+    int threads = qMax(1, QThread::idealThreadCount() / sessions);
+
+    for (CameraSession *session : m_sessions) {
+        session->streamManager()->setDecoderThreads(m_sessions.size() > 1 ? threads : 0);
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QList>
+#include <QSize>
+
+class QQmlEngine;
+class StreamManager;
+class GrpcManager;
+class ConfigManager;
+
+// One camera in a multi-camera session: its own pipeline, frame provider,
+// RX port and gRPC control connection
+class CameraSession : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString name READ name CONSTANT)
+    Q_PROPERTY(QString ip READ ip CONSTANT)
+    Q_PROPERTY(int port READ port CONSTANT)
+    Q_PROPERTY(QString providerId READ providerId CONSTANT)
+    Q_PROPERTY(QObject* stream READ stream CONSTANT)
+    Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY budgetChanged)
+    Q_PROPERTY(int frameRateBudget READ frameRateBudget NOTIFY budgetChanged)
+
+public:
+    CameraSession(const QVariantMap &camera, int port, const QString &providerId, QObject *parent = nullptr);
+
+    QString name() const { return m_name; }
+    QString ip() const { return m_ip; }
+    int port() const { return m_port; }
+    int controlPort() const { return m_controlPort; }
+    QString providerId() const { return m_providerId; }
+    QObject *stream() const;
+    StreamManager *streamManager() const { return m_stream; }
+    GrpcManager *grpcManager() const { return m_grpc; }
+    QString status() const { return m_status; }
+    bool isActive() const { return m_active; }
+    int frameRateBudget() const { return m_frameRateBudget; }
+
+    void setStatus(const QString &status);
+
+    // Grid compositor bookkeeping
+    QSize tileSize() const { return m_tileSize; }
+    void setTileSize(const QSize &size) { m_tileSize = size; }
+    int txFramerate() const { return m_txFramerate; }
+    void setTxFramerate(int framerate) { m_txFramerate = framerate; }
+    bool isConnected() const { return m_connected; }
+    void setConnected(bool connected) { m_connected = connected; }
+
+    void setBudget(bool active, int frameRate);
+
+signals:
+    void statusChanged();
+    void budgetChanged();
+
+private:
+    QString m_name;
+    QString m_ip;
+    int m_port = 0;
+    int m_controlPort = 50051;
+    QString m_providerId;
+    QString m_status = "Idle";
+    bool m_active = false;
+    int m_frameRateBudget = 0;
+    QSize m_tileSize;               // Last tile size reported by the grid, device pixels
+    int m_txFramerate = 0;          // Framerate last sent to the camera (0 = not yet)
+    bool m_connected = false;       // UpdateConfig succeeded
+
+    StreamManager *m_stream = nullptr;
+    GrpcManager *m_grpc = nullptr;
+};
+
+// Runs one StreamManager pipeline per selected camera so a single RX
+// instance can serve a whole site
+class SessionManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QList<QObject*> sessions READ sessions NOTIFY sessionsChanged)
+    Q_PROPERTY(int sessionCount READ sessionCount NOTIFY sessionsChanged)
+    Q_PROPERTY(int basePort READ basePort WRITE setBasePort NOTIFY basePortChanged)
+
+    // Grid compositor budgets: the active tile gets full rate and resolution,
+    // the others are scaled by inactiveScale and throttled to inactiveFrameRate
+    Q_PROPERTY(int activeIndex READ activeIndex WRITE setActiveIndex NOTIFY budgetsChanged)
+    Q_PROPERTY(int inactiveFrameRate READ inactiveFrameRate WRITE setInactiveFrameRate NOTIFY budgetsChanged)
+    Q_PROPERTY(double inactiveScale READ inactiveScale WRITE setInactiveScale NOTIFY budgetsChanged)
+    // Also ask inactive cameras to encode at the budgeted rate via UpdateConfig
+    Q_PROPERTY(bool txBudgetEnabled READ txBudgetEnabled WRITE setTxBudgetEnabled NOTIFY budgetsChanged)
+
+public:
+    SessionManager(QQmlEngine *engine, ConfigManager *config, QObject *parent = nullptr);
+    ~SessionManager();
+
+    QList<QObject*> sessions() const;
+    int sessionCount() const { return m_sessions.size(); }
+    int basePort() const { return m_basePort; }
+    void setBasePort(int port);
+
+    int activeIndex() const { return m_activeIndex; }
+    void setActiveIndex(int index);
+    int inactiveFrameRate() const { return m_inactiveFrameRate; }
+    void setInactiveFrameRate(int fps);
+    double inactiveScale() const { return m_inactiveScale; }
+    void setInactiveScale(double scale);
+    bool txBudgetEnabled() const { return m_txBudgetEnabled; }
+    void setTxBudgetEnabled(bool enabled);
+
+    // Called by the grid whenever a tile is laid out
+    Q_INVOKABLE void setTileSize(int index, const QSize &size);
+
+    // camera is an entry of MdnsManager::discoveredCameras
+    Q_INVOKABLE bool addCamera(const QVariantMap &camera);
+    Q_INVOKABLE void removeCamera(int index);
+    Q_INVOKABLE void clear();
+    Q_INVOKABLE void startAll();
+    Q_INVOKABLE void stopAll();
+
+signals:
+    void sessionsChanged();
+    void basePortChanged();
+    void budgetsChanged();
+
+private:
+    int allocatePort() const;
+    void connectCamera(CameraSession *session);
+    void sendCameraConfig(CameraSession *session, int framerate);
+    void applyBudgets();
+    void rebalanceDecoderThreads();
+
+    QQmlEngine *m_engine = nullptr;
+    ConfigManager *m_config = nullptr;
+    QList<CameraSession*> m_sessions;
+    int m_basePort = 9000;        // Session ports are basePort, basePort + 2, ...
+    int m_nextProviderId = 1;
+
+    int m_activeIndex = 0;
+    int m_inactiveFrameRate = 5;
+    double m_inactiveScale = 0.5;
+    bool m_txBudgetEnabled = false;
+};
+
+#endif // SESSIONMANAGER_H
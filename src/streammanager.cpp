@@ -1,8 +1,170 @@
 #include "streammanager.h"
 #include "logmanager.h"
+#include "metrics.h"
+#include "colorconvert.h"
+#include "decodertuning.h"
+#include "trace.h"
+#include "transportsource.h"
 #include <QDebug>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QTransform>
+#include <cmath>
+#include <memory>
+#include <utility>
 #include <gst/video/video.h>
 #include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/base/gstbasesrc.h>
+
+// ============ Stream Metrics ============
+
+static Metrics::Counter s_framesDecoded("f1sh_stream_frames_decoded_total",
+                                        "Decoded video frames delivered to the application");
+static const char kFramesDroppedName[] = "f1sh_stream_frames_dropped_total";
+static const char kFramesDroppedHelp[] = "Video frames discarded before display, by cause";
+static Metrics::Counter s_framesDroppedQueue(kFramesDroppedName, kFramesDroppedHelp,
+                                             "cause=\"queue_leak\"");
+static Metrics::Counter s_framesDroppedAppsink(kFramesDroppedName, kFramesDroppedHelp,
+                                               "cause=\"appsink_drop\"");
+static Metrics::Counter s_framesDroppedSuperseded(kFramesDroppedName, kFramesDroppedHelp,
+                                                  "cause=\"superseded\"");
+static Metrics::Counter s_framesDroppedDecodeError(kFramesDroppedName, kFramesDroppedHelp,
+                                                   "cause=\"decode_error\"");
+static Metrics::Counter s_lowPowerSkipped("f1sh_stream_lowpower_skipped_total",
+                                          "Delta frames not decoded because low-power mode was active");
+static Metrics::Counter s_framesThrottled("f1sh_stream_frames_throttled_total",
+                                           "Decoded frames skipped to stay within a frame-rate budget");
+static Metrics::Gauge s_streamFps("f1sh_stream_fps",
+                                  "Decoded frames per second over the last second, summed over all streams");
+static Metrics::Histogram s_frameLatency("f1sh_stream_frame_latency_seconds",
+                                         "Time from packet arrival at udpsrc to decoded frame at appsink",
+                                         {0.005, 0.01, 0.02, 0.033, 0.05, 0.1, 0.2, 0.5, 1.0});
+static Metrics::Counter s_rtpPackets("f1sh_rtp_packets_received_total", "RTP packets received");
+static Metrics::Counter s_rtpLost("f1sh_rtp_packets_lost_total",
+                                  "RTP packets missing from the sequence number space");
+static Metrics::Gauge s_rtpJitter("f1sh_rtp_jitter_seconds", "RFC 3550 interarrival jitter estimate");
+
+static Metrics::Counter s_streamStalls("f1sh_stream_stalls_total",
+                                       "Times the watchdog found the stream stalled or failed");
+static Metrics::Counter s_pipelineRebuilds("f1sh_stream_pipeline_rebuilds_total",
+                                           "Pipeline rebuilds performed by the watchdog");
+static Metrics::Counter s_decoderFailovers("f1sh_stream_decoder_failovers_total",
+                                           "Mid-stream swaps from a failed hardware decoder to software");
+static Metrics::Histogram s_recoveryTime("f1sh_stream_recovery_seconds",
+                                         "Time from the last frame before a stall to the first frame after it",
+                                         {0.5, 1.0, 2.0, 5.0, 10.0, 30.0, 60.0, 120.0});
+static Metrics::Gauge s_profileLatency("f1sh_stream_decoder_profile",
+                                        "Active decoder tuning profile (1 = active)", "profile=\"latency\"");
+static Metrics::Counter s_recordedBytes("f1sh_recording_bytes_total",
+                                        "Encoded H.264 bytes passed to the recording muxer");
+static Metrics::Counter s_recordingDropped("f1sh_recording_dropped_buffers_total",
+                                           "Encoded access units left out of a recording because the disk "
+                                           "fell behind; whole GOPs are dropped");
+static Metrics::Gauge s_replayAllocated("f1sh_replay_buffer_bytes",
+                                        "Replay buffer memory across all streams", "kind=\"allocated\"");
+static Metrics::Gauge s_replayUsed("f1sh_replay_buffer_bytes",
+                                   "Replay buffer memory across all streams", "kind=\"used\"");
+static Metrics::Counter s_replayExports("f1sh_replay_exports_total", "Replay buffer exports written to disk");
+static Metrics::Counter s_snapshots("f1sh_snapshots_total", "Stills saved from the video stream");
+static Metrics::Histogram s_snapshotEncode("f1sh_snapshot_encode_seconds",
+                                           "Time to convert and encode a still on the snapshot pool",
+                                           {0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0});
+static Metrics::Gauge s_profileThroughput("f1sh_stream_decoder_profile",
+                                          "Active decoder tuning profile (1 = active)", "profile=\"throughput\"");
+
+static constexpr double kRtpClockRate = 90000.0;  // H.264 RTP clock
+// RFC 3550 appendix A.1 limits: packets this far behind are reordered, gaps
+// this large are a sender restart
+static constexpr guint16 kRtpMaxMisorder = 100;
+static constexpr guint16 kRtpMaxDropout = 3000;
+static constexpr int kAppSinkMaxBuffers = 3;
+static constexpr int kViewportDebounceMs = 200;  // Renegotiate once a resize settles
+static constexpr qint64 kThrottleResetMs = 1000;  // Longer than any frame-rate budget interval
+
+// Watchdog timing
+static constexpr int kWatchdogIntervalMs = 250;
+static constexpr int kStallTimeoutMs = 2000;        // No frames for this long = stalled
+static constexpr int kRecoveryStepMs = 1500;        // Time each cheap recovery step gets
+static constexpr int kRestartBackoffBaseMs = 500;   // First rebuild retry delay, doubled each time
+static constexpr int kRestartBackoffMaxMs = 30000;
+static constexpr int kFailoverGraceMs = 1000;       // Ignore knock-on errors after a decoder swap
+
+// Recording
+static constexpr quint64 kRecordQueueSeconds = 5;      // Disk may fall this far behind before GOPs are dropped
+static constexpr int kRecordFinalizeTimeoutMs = 5000;  // Give up waiting for the muxer to drain EOS
+
+// Replay buffer: the index is sized for this frame rate over the retention window
+static constexpr int kReplayMaxFps = 120;
+static std::atomic<qint64> s_replayAllocatedTotal{0};
+static std::atomic<qint64> s_replayUsedTotal{0};
+// Every StreamManager, and those with replay enabled; GUI thread only. The
+// replayMemoryLimit setting is one cap divided among the enabled ones.
+static QList<StreamManager*> s_streams;
+static QList<StreamManager*> s_replayStreams;
+
+// Sum of every stream's fps in thousandths, behind s_streamFps
+static std::atomic<qint64> s_streamFpsTotalMilli{0};
+
+// Snapshots: encoding threads per stream, and requests allowed in flight before new ones are refused
+static constexpr int kSnapshotThreads = 2;
+static constexpr int kMaxPendingSnapshots = 4;
+
+namespace {
+
+// ============ Transports ============
+
+struct TransportInfo {
+    const char *id;      // Matches the mDNS "protocol" TXT value where one exists
+    const char *label;
+};
+
+const TransportInfo kTransports[] = {
+    {"auto", "Auto (from discovery)"},
+    {"udp", "RTP over UDP"},
+    {"tcp", "RTP over TCP"},
+    {"rtsp", "RTSP"},
+    {"rtsp-tcp", "RTSP (interleaved TCP)"},
+    {"srt", "SRT"},
+};
+constexpr int kTransportCount = int(sizeof(kTransports) / sizeof(kTransports[0]));
+
+// ============ Recording Formats ============
+
+struct RecordingFormat {
+    const char *label;
+    const char *muxer;       // gst-launch syntax, fed by h264parse
+    const char *extension;
+};
+
+const RecordingFormat kRecordingFormats[] = {
+    // One fragment per second, written append-only: a crash loses at most the last second
+    {"MP4 (fragmented)", "mp4mux fragment-duration=1000 streamable=true", "mp4"},
+    // Matroska clusters stay playable when the file is cut short; cues are added on a clean stop
+    {"Matroska (MKV)", "matroskamux", "mkv"},
+};
+constexpr int kRecordingFormatCount = int(sizeof(kRecordingFormats) / sizeof(kRecordingFormats[0]));
+
+// ============ Snapshot Formats ============
+
+struct SnapshotFormat {
+    const char *label;
+    const char *format;      // QImageWriter format
+    const char *extension;
+    int quality;             // -1 = writer default
+};
+
+const SnapshotFormat kSnapshotFormats[] = {
+    {"PNG (lossless)", "PNG", "png", -1},
+    {"JPEG", "JPG", "jpg", 92},
+};
+constexpr int kSnapshotFormatCount = int(sizeof(kSnapshotFormats) / sizeof(kSnapshotFormats[0]));
+
+} // namespace
 
 // ============ VideoFrameProvider Implementation ============
 
@@ -27,13 +189,27 @@ QImage VideoFrameProvider::requestImage(const QString &id, QSize *size, const QS
     }
 
     if (size) *size = m_currentFrame.size();
+    m_frameConsumed = true;
+    return m_currentFrame;
+}
+
+QImage VideoFrameProvider::currentFrame()
+{
+    QMutexLocker locker(&m_mutex);
     return m_currentFrame;
 }
 
 void VideoFrameProvider::updateFrame(const QImage &frame)
 {
     QMutexLocker locker(&m_mutex);
+
+    // The previous frame was never requested by QML, so it was never shown
+    if (!m_frameConsumed && !m_currentFrame.isNull()) {
+        m_superseded.fetch_add(1, std::memory_order_relaxed);
+    }
+
     m_currentFrame = frame;
+    m_frameConsumed = false;
 }
 
 // ============ StreamManager Implementation ============
@@ -42,16 +218,60 @@ StreamManager::StreamManager(QObject *parent)
     : QObject(parent)
     , m_imageProvider(new VideoFrameProvider())
     , m_frameTimer(new QTimer(this))
+    , m_scaleTimer(new QTimer(this))
+    , m_watchdogTimer(new QTimer(this))
+    , m_statsTimer(new QTimer(this))
 {
     setStatus("Stopped");
 
     // Setup frame polling timer (as fallback for callback issues)
     connect(m_frameTimer, &QTimer::timeout, this, &StreamManager::pollForFrames);
+
+    // Window resizes arrive in bursts; only renegotiate caps once they stop
+    m_scaleTimer->setSingleShot(true);
+    m_scaleTimer->setInterval(kViewportDebounceMs);
+    connect(m_scaleTimer, &QTimer::timeout, this, &StreamManager::applyViewportScale);
+
+    // Detect stalls/pipeline failures and recover without user action
+    connect(m_watchdogTimer, &QTimer::timeout, this, &StreamManager::checkStreamHealth);
+
+    QSettings settings("F1sh", "CameraRX");
+    m_decoderProfile = qBound(0, settings.value("decoderProfile", DecoderTuning::LowLatency).toInt(), 1);
+    s_profileLatency.set(m_decoderProfile == DecoderTuning::LowLatency ? 1.0 : 0.0);
+    s_profileThroughput.set(m_decoderProfile == DecoderTuning::Throughput ? 1.0 : 0.0);
+    m_transportIndex = qBound(0, settings.value("transportIndex", 0).toInt(), kTransportCount - 1);
+    m_transportLatency = qMax(0, settings.value("transportLatency", m_transportLatency).toInt());
+    m_recordingFormat = qBound(0, settings.value("recordingFormat", 0).toInt(), kRecordingFormatCount - 1);
+    m_recordingDirectory = settings.value("recordingDirectory",
+                                          QStandardPaths::writableLocation(QStandardPaths::MoviesLocation)).toString();
+    m_replayEnabled = settings.value("replayEnabled", false).toBool();
+    m_replaySeconds = qBound(1, settings.value("replaySeconds", m_replaySeconds).toInt(), 600);
+    m_replayMemoryLimit = qBound(8, settings.value("replayMemoryLimit", m_replayMemoryLimit).toInt(), 1024);
+    s_streams.append(this);
+    applyReplayBuffer();
+    m_snapshotFormat = qBound(0, settings.value("snapshotFormat", 0).toInt(), kSnapshotFormatCount - 1);
+    m_snapshotFullResolution = settings.value("snapshotFullResolution", false).toBool();
+
+    // Still encoding (PNG can take tens of ms per frame) never runs on the GUI thread
+    m_snapshotPool = new QThreadPool(this);
+    m_snapshotPool->setMaxThreadCount(kSnapshotThreads);
+
+    // Refresh derived statistics (fps) once per second while streaming
+    connect(m_statsTimer, &QTimer::timeout, this, &StreamManager::updateStreamStats);
 }
 
 StreamManager::~StreamManager()
 {
     stop();
+    m_snapshotPool->waitForDone();
+    if (m_replayThread) {
+        m_replayThread->quit();
+        m_replayThread->wait();
+    }
+    // The other streams get this one's share of the replay memory
+    s_streams.removeOne(this);
+    m_replayEnabled = false;
+    applyReplayBuffer();
     // Note: m_imageProvider is owned by QML engine after registration
 }
 
@@ -62,13 +282,13 @@ void StreamManager::initGStreamer()
     GError *error = nullptr;
     if (!gst_init_check(nullptr, nullptr, &error)) {
         QString errorMsg = error ? QString::fromUtf8(error->message) : "Unknown error";
-        LogManager::log(QString("Failed to initialize GStreamer: %1").arg(errorMsg));
+        LOG_ERROR(Stream, QString("Failed to initialize GStreamer: %1").arg(errorMsg));
         if (error) g_error_free(error);
         return;
     }
 
     m_gstInitialized = true;
-    LogManager::log(QString("GStreamer initialized: %1").arg(gst_version_string()));
+    LOG_INFO(Stream, QString("GStreamer initialized: %1").arg(gst_version_string()));
 }
 
 void StreamManager::detectDecoders()
@@ -136,7 +356,7 @@ void StreamManager::detectDecoders()
             info.priority = candidate.priority;
 
             m_decoders.append(info);
-            LogManager::log(QString("Found decoder: %1 (%2) - %3")
+            LOG_DEBUG(Stream, QString("Found decoder: %1 (%2) - %3")
                            .arg(info.name, info.elementName,
                                 info.isHardware ? "Hardware" : "Software"));
 
@@ -145,7 +365,7 @@ void StreamManager::detectDecoders()
     }
 
     if (m_decoders.isEmpty()) {
-        LogManager::log("WARNING: No H.264 decoders found!");
+        LOG_WARNING(Stream, "No H.264 decoders found!");
     }
 
     emit availableDecodersChanged();
@@ -166,11 +386,11 @@ DecoderInfo StreamManager::selectBestDecoder()
     if (!m_preferredDecoder.isEmpty()) {
         for (const auto &decoder : m_decoders) {
             if (decoder.name == m_preferredDecoder || decoder.elementName == m_preferredDecoder) {
-                LogManager::log(QString("Using preferred decoder: %1").arg(decoder.name));
+                LOG_INFO(Stream, QString("Using preferred decoder: %1").arg(decoder.name));
                 return decoder;
             }
         }
-        LogManager::log(QString("Preferred decoder '%1' not available, auto-selecting...").arg(m_preferredDecoder));
+        LOG_WARNING(Stream, QString("Preferred decoder '%1' not available, auto-selecting...").arg(m_preferredDecoder));
     }
 
     // Sort by priority and pick the best
@@ -184,56 +404,133 @@ DecoderInfo StreamManager::selectBestDecoder()
     }
 
     if (best.priority >= 0) {
-        LogManager::log(QString("Auto-selected decoder: %1 (%2)")
+        LOG_INFO(Stream, QString("Auto-selected decoder: %1 (%2)")
                        .arg(best.name, best.isHardware ? "Hardware" : "Software"));
     }
 
     return best;
 }
 
+DecoderInfo StreamManager::selectSoftwareDecoder() const
+{
+    DecoderInfo softwareDecoder;
+    softwareDecoder.priority = -1;
+    for (const auto &decoder : m_decoders) {
+        if (!decoder.isHardware && decoder.priority > softwareDecoder.priority) {
+            softwareDecoder = decoder;
+        }
+    }
+    return softwareDecoder;
+}
+
 void StreamManager::setPreferredDecoder(const QString &decoderName)
 {
     m_preferredDecoder = decoderName;
-    LogManager::log(QString("Preferred decoder set to: %1").arg(decoderName));
+    LOG_INFO(Stream, QString("Preferred decoder set to: %1").arg(decoderName));
 }
 
 QString StreamManager::buildPipelineString()
 {
     DecoderInfo decoder = selectBestDecoder();
     if (decoder.elementName.isEmpty()) {
-        LogManager::log("No decoder available!");
+        LOG_ERROR(Stream, "No decoder available!");
         return QString();
     }
 
     m_currentDecoder = decoder.name;
+    m_decoderElement = decoder.elementName;
     emit currentDecoderChanged();
 
-    QString pipeline;
+    QString transport = resolveTransport();
+    QString pipeline = buildSourceString(transport);
+    if (pipeline.isEmpty()) {
+        return QString();
+    }
+    pipeline += "h264parse name=parse config-interval=-1 ! ";
 
-    // UDP source - minimal buffering for low latency
-    pipeline = QString("udpsrc port=%1 ! "
-                       "application/x-rtp,media=video,encoding-name=H264,payload=96 ! "
-                       "rtph264depay ! "
-                       "h264parse ! ").arg(m_port);
+    // Recording taps the encoded stream here; startRecording() requests a
+    // second tee pad, so the live branch never changes while recording
+    pipeline += "tee name=rectee allow-not-linked=true ! ";
 
     // Add decoder
-    pipeline += decoder.elementName + " ! ";
+    pipeline += decoder.elementName + " name=decoder ! ";
 
     // Platform-specific post-processing
 #ifdef _WIN32
     if (decoder.elementName.startsWith("d3d11") || decoder.elementName.startsWith("d3d12")) {
         // D3D11/D3D12 path: convert and download to system memory
         if (decoder.elementName.startsWith("d3d12")) {
-            pipeline += "d3d12download ! ";
+            pipeline += "d3d12download name=download ! ";
         } else {
-            pipeline += "d3d11download ! ";
+            pipeline += "d3d11download name=download ! ";
         }
     }
 #endif
 
+    // Scale down to the viewport before any conversion; the capsfilter starts
+    // unrestricted and is narrowed by applyViewportScale() once the source size is known
+    pipeline += "videoscale name=scaler ! capsfilter name=scalecaps caps=video/x-raw ! ";
+
     // Video conversion for rotation and format
     pipeline += "videoconvert ! ";
 
+    if (m_fusedConversion) {
+        // Hand YUV to the appsink; RGB conversion and rotation happen there in
+        // a single pass instead of videoconvert ! videoflip ! videoconvert
+        m_pipelineRotate = m_rotate;
+        pipeline += "video/x-raw,format=(string){I420,NV12} ! ";
+        LOG_INFO(Stream, QString("Using fused colour conversion (%1 kernel, rotate=%2)")
+                        .arg(QString::fromUtf8(ColorConvert::implementationName())).arg(m_rotate));
+    } else {
+        m_pipelineRotate = 0;
+        appendRotationElements(pipeline);
+        pipeline += "video/x-raw,format=RGB ! ";
+    }
+
+    // Decouple the decoder from the application and use appsink
+    pipeline += QString("queue name=framequeue max-size-buffers=3 leaky=downstream ! "
+                        "appsink name=sink emit-signals=true sync=false max-buffers=%1 drop=true")
+                    .arg(kAppSinkMaxBuffers);
+
+    LOG_DEBUG(Stream, QString("Pipeline: %1").arg(pipeline));
+    return pipeline;
+}
+
+QString StreamManager::resolveTransport() const
+{
+    QString transport = QString::fromUtf8(kTransports[m_transportIndex].id);
+    if (transport != "auto") {
+        return transport;
+    }
+
+    // Follow what the camera advertises, defaulting to plain RTP/UDP
+    for (int i = 1; i < kTransportCount; ++i) {
+        if (m_discoveredProtocol.compare(QString::fromUtf8(kTransports[i].id), Qt::CaseInsensitive) == 0) {
+            return QString::fromUtf8(kTransports[i].id);
+        }
+    }
+    return "udp";
+}
+
+QString StreamManager::buildSourceString(const QString &transport) const
+{
+    TransportSource::Options options;
+    options.host = m_host;
+    options.port = m_port;
+    options.latencyMs = m_transportLatency;
+    options.multicastGroup = m_multicastGroup;
+    options.multicastInterface = m_multicastInterface;
+
+    QString error;
+    QString source = TransportSource::build(transport, options, &error);
+    if (source.isEmpty()) {
+        LOG_WARNING(Stream, error);
+    }
+    return source;
+}
+
+void StreamManager::appendRotationElements(QString &pipeline)
+{
     // Add rotation if needed
     if (m_rotate != 0) {
         GstElementFactory *flipFactory = gst_element_factory_find("videoflip");
@@ -250,21 +547,40 @@ QString StreamManager::buildPipelineString()
             }
             gst_object_unref(flipFactory);
         } else {
-            LogManager::log("Warning: videoflip element not available, rotation disabled");
+            LOG_WARNING(Stream, "videoflip element not available, rotation disabled");
         }
     }
+}
+
+QStringList StreamManager::decoderProfileOptions() const
+{
+    return {"Lowest latency", "Highest throughput"};
+}
+
+void StreamManager::applyDecoderTuning(GstElement *decoder, const QString &elementName)
+{
+    QStringList skipped;
+    QStringList applied = DecoderTuning::apply(decoder, elementName,
+                                               DecoderTuning::Profile(m_decoderProfile), &skipped);
+    for (const QString &property : skipped) {
+        LOG_DEBUG(Stream, QString("Decoder tuning: %1 has no '%2' property, skipping")
+                        .arg(elementName, property));
+    }
 
-    // Convert to RGB for Qt and use appsink
-    pipeline += "video/x-raw,format=RGB ! "
-                "queue max-size-buffers=3 leaky=downstream ! "
-                "appsink name=sink emit-signals=true sync=false max-buffers=3 drop=true";
+    // With several sessions the cores are shared out instead of each decoder taking all of them
+    if (m_decoderThreads > 0 && g_object_class_find_property(G_OBJECT_GET_CLASS(decoder), "max-threads")) {
+        g_object_set(decoder, "max-threads", m_decoderThreads, nullptr);
+        applied.append(QString("max-threads=%1 (session limit)").arg(m_decoderThreads));
+    }
 
-    LogManager::log(QString("Pipeline: %1").arg(pipeline));
-    return pipeline;
+    LOG_INFO(Stream, QString("Decoder profile '%1' for %2: %3")
+                    .arg(decoderProfileOptions().value(m_decoderProfile), elementName,
+                         applied.isEmpty() ? QString("defaults") : applied.join(", ")));
 }
 
 bool StreamManager::createPipeline()
 {
+    TRACE_SCOPE("stream", "createPipeline");
     bool softwareFallbackTried = false;
 
     while (true) {
@@ -274,7 +590,7 @@ bool StreamManager::createPipeline()
             return false;
         }
 
-        LogManager::log(QString("Creating pipeline: %1").arg(pipelineStr));
+        LOG_DEBUG(Stream, QString("Creating pipeline: %1").arg(pipelineStr));
 
         GError *error = nullptr;
         m_pipeline = gst_parse_launch(pipelineStr.toUtf8().constData(), &error);
@@ -284,7 +600,7 @@ bool StreamManager::createPipeline()
         }
 
         QString errorMsg = error ? QString::fromUtf8(error->message) : "Unknown error";
-        LogManager::log(QString("Failed to create pipeline: %1").arg(errorMsg));
+        LOG_ERROR(Stream, QString("Failed to create pipeline: %1").arg(errorMsg));
         if (error) g_error_free(error);
         if (m_pipeline) {
             gst_object_unref(m_pipeline);
@@ -296,20 +612,13 @@ bool StreamManager::createPipeline()
             return false;
         }
 
-        DecoderInfo softwareDecoder;
-        softwareDecoder.priority = -1;
-        for (const auto &decoder : m_decoders) {
-            if (!decoder.isHardware && decoder.priority > softwareDecoder.priority) {
-                softwareDecoder = decoder;
-            }
-        }
-
+        DecoderInfo softwareDecoder = selectSoftwareDecoder();
         if (softwareDecoder.priority < 0 || m_currentDecoder == softwareDecoder.name) {
             setStatus("Failed to create pipeline");
             return false;
         }
 
-        LogManager::log(QString("Attempting fallback to software decoder: %1 (%2)")
+        LOG_INFO(Stream, QString("Attempting fallback to software decoder: %1 (%2)")
                         .arg(softwareDecoder.name, softwareDecoder.elementName));
         m_preferredDecoder = softwareDecoder.elementName;
         softwareFallbackTried = true;
@@ -318,7 +627,7 @@ bool StreamManager::createPipeline()
     // Get appsink element
     m_appSink = gst_bin_get_by_name(GST_BIN(m_pipeline), "sink");
     if (!m_appSink) {
-        LogManager::log("Failed to get appsink element");
+        LOG_ERROR(Stream, "Failed to get appsink element");
         destroyPipeline();
         setStatus("Pipeline configuration error");
         return false;
@@ -329,11 +638,76 @@ bool StreamManager::createPipeline()
     callbacks.new_sample = onNewSample;
     gst_app_sink_set_callbacks(GST_APP_SINK(m_appSink), &callbacks, this, nullptr);
 
+    // Count buffers reaching appsink so its silent drops can be derived
+    GstPad *sinkPad = gst_element_get_static_pad(m_appSink, "sink");
+    if (sinkPad) {
+        gst_pad_add_probe(sinkPad, GST_PAD_PROBE_TYPE_BUFFER, onAppSinkBuffer, this, nullptr);
+        gst_object_unref(sinkPad);
+    }
+
+    // A leaky queue emits "overrun" for every buffer it is about to leak
+    GstElement *frameQueue = gst_bin_get_by_name(GST_BIN(m_pipeline), "framequeue");
+    if (frameQueue) {
+        g_signal_connect(frameQueue, "overrun", G_CALLBACK(onQueueOverrun), this);
+        gst_object_unref(frameQueue);
+    }
+
+    // Full-resolution snapshots take the decoder output before it is scaled
+    GstElement *scaler = gst_bin_get_by_name(GST_BIN(m_pipeline), "scaler");
+    if (scaler) {
+        GstPad *scalerSink = gst_element_get_static_pad(scaler, "sink");
+        if (scalerSink) {
+            gst_pad_add_probe(scalerSink, GST_PAD_PROBE_TYPE_BUFFER, onDecodedFrame, this, nullptr);
+            gst_object_unref(scalerSink);
+        }
+        gst_object_unref(scaler);
+    }
+
+    // Parser output feeds the replay buffer (a no-op while it is disabled)
+    GstElement *tee = gst_bin_get_by_name(GST_BIN(m_pipeline), "rectee");
+    if (tee) {
+        GstPad *teeSink = gst_element_get_static_pad(tee, "sink");
+        if (teeSink) {
+            gst_pad_add_probe(teeSink, GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+                              onParsedData, this, nullptr);
+            gst_object_unref(teeSink);
+        }
+        gst_object_unref(tee);
+    }
+
+    m_scaleCaps = gst_bin_get_by_name(GST_BIN(m_pipeline), "scalecaps");
+    m_scaledSize = QSize();
+
+    // Gate decoder input so low-power mode can skip delta frames
+    GstElement *decoderElement = gst_bin_get_by_name(GST_BIN(m_pipeline), "decoder");
+    if (decoderElement) {
+        applyDecoderTuning(decoderElement, m_decoderElement);
+
+        GstPad *decoderSink = gst_element_get_static_pad(decoderElement, "sink");
+        if (decoderSink) {
+            gst_pad_add_probe(decoderSink, GST_PAD_PROBE_TYPE_BUFFER, onDecoderInput, this, nullptr);
+            gst_object_unref(decoderSink);
+        }
+        gst_object_unref(decoderElement);
+    }
+    m_awaitingKeyframe = false;
+
     // Set up bus watch
     GstBus *bus = gst_element_get_bus(m_pipeline);
     m_busWatchId = gst_bus_add_watch(bus, onBusMessage, this);
     gst_object_unref(bus);
 
+    // Watch RTP packets entering the depayloader for loss/jitter statistics
+    GstElement *depay = gst_bin_get_by_name(GST_BIN(m_pipeline), "depay");
+    if (depay) {
+        GstPad *depaySink = gst_element_get_static_pad(depay, "sink");
+        if (depaySink) {
+            gst_pad_add_probe(depaySink, GST_PAD_PROBE_TYPE_BUFFER, onRtpPacket, this, nullptr);
+            gst_object_unref(depaySink);
+        }
+        gst_object_unref(depay);
+    }
+
     // Set low latency
     gst_pipeline_set_latency(GST_PIPELINE(m_pipeline), 50 * GST_MSECOND);
 
@@ -342,6 +716,12 @@ bool StreamManager::createPipeline()
 
 void StreamManager::destroyPipeline()
 {
+    if (m_fullResRequested.exchange(false)) {
+        m_pendingSnapshots.fetch_sub(1);
+        LOG_WARNING(Stream, "Full-resolution snapshot cancelled, the stream stopped");
+        emit snapshotSaved(false, QString());
+    }
+
     if (m_busWatchId != 0) {
         g_source_remove(m_busWatchId);
         m_busWatchId = 0;
@@ -352,8 +732,14 @@ void StreamManager::destroyPipeline()
         m_appSink = nullptr;
     }
 
+    if (m_scaleCaps) {
+        gst_object_unref(m_scaleCaps);
+        m_scaleCaps = nullptr;
+    }
+
     if (m_pipeline) {
         gst_element_set_state(m_pipeline, GST_STATE_NULL);
+        releaseRecording();
         gst_object_unref(m_pipeline);
         m_pipeline = nullptr;
     }
@@ -361,8 +747,9 @@ void StreamManager::destroyPipeline()
 
 void StreamManager::start()
 {
+    TRACE_SCOPE("stream", "start");
     if (m_isStreaming) {
-        LogManager::log("Stream already running");
+        LOG_INFO(Stream, "Stream already running");
         return;
     }
 
@@ -384,13 +771,18 @@ void StreamManager::start()
         }
     }
 
-    LogManager::log(QString("Starting stream on UDP port %1...").arg(m_port));
-    LogManager::log(QString("Stream configuration: port=%1, rotate=%2").arg(m_port).arg(m_rotate));
+    LOG_INFO(Stream, QString("Starting stream on port %1...").arg(m_port));
+    LOG_DEBUG(Stream, QString("Stream configuration: transport=%1, host=%2, multicast=%3, port=%4, rotate=%5")
+                    .arg(resolveTransport(), m_host.isEmpty() ? QString("-") : m_host,
+                         m_multicastGroup.isEmpty() ? QString("off") : m_multicastGroup)
+                    .arg(m_port).arg(m_rotate));
     setStatus("Starting...");
 
     // Reset first frame flag for new session
     m_firstFrameReceived = false;
     m_frameCount = 0;
+    resetRtpStats();
+    resetDropStats();
 
     if (!createPipeline()) {
         emit errorOccurred("Failed to create pipeline");
@@ -399,7 +791,7 @@ void StreamManager::start()
 
     GstStateChangeReturn ret = gst_element_set_state(m_pipeline, GST_STATE_PLAYING);
     if (ret == GST_STATE_CHANGE_FAILURE) {
-        LogManager::log("Failed to start pipeline");
+        LOG_ERROR(Stream, "Failed to start pipeline");
         destroyPipeline();
         setStatus("Failed to start");
         emit errorOccurred("Failed to start pipeline");
@@ -409,25 +801,53 @@ void StreamManager::start()
     m_isStreaming = true;
     emit isStreamingChanged();
     setStatus(QString("Streaming (%1)").arg(m_currentDecoder));
-    LogManager::log(QString("Stream started on port %1 using %2").arg(m_port).arg(m_currentDecoder));
-    LogManager::log("Waiting for video frames...");
+    LOG_INFO(Stream, QString("Stream started on port %1 using %2").arg(m_port).arg(m_currentDecoder));
+    LOG_INFO(Stream, "Waiting for video frames...");
 
-    // Start frame polling timer (30fps polling rate)
-    m_frameTimer->start(33);
+    // Start frame polling timer (30fps polling rate), not needed while in low-power mode
+    if (!lowPower()) {
+        m_frameTimer->start(33);
+    }
+
+    m_statsLastFrames = m_framesDelivered.load(std::memory_order_relaxed);
+    m_statsElapsed.start();
+    m_statsTimer->start(1000);
+
+    m_sessionClock.start();
+    m_lastFrameMs.store(0, std::memory_order_relaxed);
+    m_lastDeliveredMs.store(-kThrottleResetMs, std::memory_order_relaxed);
+    m_recoveryStage = RecoveryStage::Healthy;
+    m_restartAttempt = 0;
+    m_lastFailoverMs = -1;
+    m_watchdogTimer->start(kWatchdogIntervalMs);
 }
 
 void StreamManager::stop()
 {
+    TRACE_SCOPE("stream", "stop");
+    stopTimeShift();
+
     // Stop frame timer first
     if (m_frameTimer) {
         m_frameTimer->stop();
     }
+    if (m_scaleTimer) {
+        m_scaleTimer->stop();
+    }
+    if (m_watchdogTimer) {
+        m_watchdogTimer->stop();
+    }
+    m_recoveryStage = RecoveryStage::Healthy;
+    if (m_statsTimer) {
+        m_statsTimer->stop();
+    }
+    publishFps(0.0);
 
     if (!m_isStreaming && !m_pipeline) {
         return;
     }
 
-    LogManager::log("Stopping stream...");
+    LOG_INFO(Stream, "Stopping stream...");
     setStatus("Stopping...");
 
     destroyPipeline();
@@ -435,7 +855,7 @@ void StreamManager::stop()
     m_isStreaming = false;
     emit isStreamingChanged();
     setStatus("Stopped");
-    LogManager::log("Stream stopped");
+    LOG_INFO(Stream, "Stream stopped");
 }
 
 void StreamManager::setPort(int port)
@@ -467,182 +887,1954 @@ void StreamManager::setRotate(int rotate)
     }
 }
 
-void StreamManager::setStatus(const QString &status)
+void StreamManager::setFusedConversion(bool enabled)
 {
-    if (m_status != status) {
-        m_status = status;
-        emit statusChanged();
+    if (m_fusedConversion != enabled) {
+        m_fusedConversion = enabled;
+        emit fusedConversionChanged();
+
+        // If streaming, restart with the new conversion chain
+        if (m_isStreaming) {
+            stop();
+            start();
+        }
     }
 }
 
-void StreamManager::pollForFrames()
+void StreamManager::setViewportSize(const QSize &size)
 {
-    if (!m_appSink || !m_isStreaming) {
-        return;
+    if (m_viewportSize != size) {
+        m_viewportSize = size;
+        emit viewportSizeChanged();
+
+        // Caps are renegotiated in place, no restart needed
+        if (m_isStreaming) {
+            m_scaleTimer->start();
+        }
     }
+}
 
-    // Try to pull a sample from appsink (non-blocking)
-    GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(m_appSink), 0);
-    if (!sample) {
-        return;
+QStringList StreamManager::transportOptions() const
+{
+    QStringList options;
+    for (const TransportInfo &transport : kTransports) {
+        options.append(QString::fromUtf8(transport.label));
     }
+    return options;
+}
 
-    GstBuffer *buffer = gst_sample_get_buffer(sample);
-    GstCaps *caps = gst_sample_get_caps(sample);
+QString StreamManager::activeTransport() const
+{
+    return resolveTransport();
+}
 
-    if (buffer && caps) {
-        GstVideoInfo videoInfo;
-        if (gst_video_info_from_caps(&videoInfo, caps)) {
-            GstMapInfo mapInfo;
-            if (gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
-                // Get proper stride from video info
-                int stride = GST_VIDEO_INFO_PLANE_STRIDE(&videoInfo, 0);
-
-                // Create QImage from RGB data
-                QImage frame(mapInfo.data,
-                            videoInfo.width,
-                            videoInfo.height,
-                            stride,
-                            QImage::Format_RGB888);
-
-                // Make a deep copy since the buffer will be released
-                m_imageProvider->updateFrame(frame.copy());
-
-                // Log first frame received (per session)
-                m_frameCount++;
-                if (!m_firstFrameReceived) {
-                    LogManager::log(QString("First frame received: %1x%2, stride=%3")
-                                   .arg(videoInfo.width).arg(videoInfo.height).arg(stride));
-                    m_firstFrameReceived = true;
-                }
+void StreamManager::setTransportIndex(int index)
+{
+    index = qBound(0, index, kTransportCount - 1);
+    if (m_transportIndex != index) {
+        QString previous = resolveTransport();
+        m_transportIndex = index;
+        emit transportChanged();
 
-                // Log periodic frame count updates (every 300 frames ~ 10 seconds at 30fps)
-                if (m_frameCount % 300 == 0) {
-                    LogManager::log(QString("Received %1 frames").arg(m_frameCount));
-                }
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("transportIndex", index);
 
-                emit frameReady();
+        if (resolveTransport() != previous) {
+            restartIfStreaming();
+        }
+    }
+}
 
-                gst_buffer_unmap(buffer, &mapInfo);
-            }
+void StreamManager::setDiscoveredProtocol(const QString &protocol)
+{
+    if (m_discoveredProtocol != protocol) {
+        QString previous = resolveTransport();
+        m_discoveredProtocol = protocol;
+        emit transportChanged();
+
+        if (resolveTransport() != previous) {
+            restartIfStreaming();
         }
     }
+}
 
-    gst_sample_unref(sample);
+void StreamManager::setHost(const QString &host)
+{
+    if (m_host != host) {
+        m_host = host;
+        emit hostChanged();
+
+        // Only client-side transports connect to the camera
+        if (resolveTransport() != "udp") {
+            restartIfStreaming();
+        }
+    }
 }
 
-// GStreamer callback: new video sample available
-GstFlowReturn StreamManager::onNewSample(GstAppSink *sink, gpointer userData)
+void StreamManager::setTransportLatency(int latencyMs)
 {
-    StreamManager *self = static_cast<StreamManager*>(userData);
+    latencyMs = qMax(0, latencyMs);
+    if (m_transportLatency != latencyMs) {
+        m_transportLatency = latencyMs;
+        emit transportLatencyChanged();
 
-    GstSample *sample = gst_app_sink_pull_sample(sink);
-    if (!sample) {
-        return GST_FLOW_OK;
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("transportLatency", latencyMs);
+
+        QString transport = resolveTransport();
+        if (transport.startsWith("rtsp") || transport == "srt") {
+            restartIfStreaming();
+        }
     }
+}
 
-    GstBuffer *buffer = gst_sample_get_buffer(sample);
-    GstCaps *caps = gst_sample_get_caps(sample);
+void StreamManager::setMulticastGroup(const QString &group)
+{
+    if (m_multicastGroup != group) {
+        m_multicastGroup = group;
+        emit multicastChanged();
 
-    if (buffer && caps) {
-        GstVideoInfo videoInfo;
-        if (gst_video_info_from_caps(&videoInfo, caps)) {
-            GstMapInfo mapInfo;
-            if (gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
-                // Get proper stride from video info
-                int stride = GST_VIDEO_INFO_PLANE_STRIDE(&videoInfo, 0);
-
-                // Create QImage from RGB data
-                QImage frame(mapInfo.data,
-                            videoInfo.width,
-                            videoInfo.height,
-                            stride,
-                            QImage::Format_RGB888);
-
-                // Make a deep copy since the buffer will be released
-                self->m_imageProvider->updateFrame(frame.copy());
-
-                // Log first frame received (per session)
-                self->m_frameCount++;
-                if (!self->m_firstFrameReceived) {
-                    LogManager::log(QString("First frame received (callback): %1x%2, stride=%3")
-                                   .arg(videoInfo.width).arg(videoInfo.height).arg(stride));
-                    self->m_firstFrameReceived = true;
-                }
+        if (resolveTransport() == "udp") {
+            restartIfStreaming();
+        }
+    }
+}
 
-                emit self->frameReady();
+void StreamManager::setMulticastInterface(const QString &iface)
+{
+    if (m_multicastInterface != iface) {
+        m_multicastInterface = iface;
+        emit multicastChanged();
 
-                gst_buffer_unmap(buffer, &mapInfo);
-            }
+        if (resolveTransport() == "udp" && !m_multicastGroup.isEmpty()) {
+            restartIfStreaming();
         }
     }
+}
 
-    gst_sample_unref(sample);
-    return GST_FLOW_OK;
+void StreamManager::setDecoderThreads(int threads)
+{
+    threads = qMax(0, threads);
+    if (m_decoderThreads != threads) {
+        m_decoderThreads = threads;
+        emit decoderThreadsChanged();
+    }
 }
 
-// GStreamer callback: bus messages
-gboolean StreamManager::onBusMessage(GstBus *bus, GstMessage *message, gpointer userData)
+void StreamManager::setMaxFrameRate(int fps)
 {
-    Q_UNUSED(bus);
-    StreamManager *self = static_cast<StreamManager*>(userData);
+    fps = qMax(0, fps);
+    if (m_maxFrameRate.load(std::memory_order_relaxed) != fps) {
+        m_maxFrameRate.store(fps, std::memory_order_relaxed);
+        emit maxFrameRateChanged();
+    }
+}
 
-    switch (GST_MESSAGE_TYPE(message)) {
-        case GST_MESSAGE_ERROR: {
-            GError *error = nullptr;
-            gchar *debug = nullptr;
-            gst_message_parse_error(message, &error, &debug);
+QStringList StreamManager::recordingFormatOptions() const
+{
+    QStringList options;
+    for (const RecordingFormat &format : kRecordingFormats) {
+        options.append(QString::fromUtf8(format.label));
+    }
+    return options;
+}
 
-            QString errorMsg = error ? QString::fromUtf8(error->message) : "Unknown error";
-            LogManager::log(QString("GStreamer Error: %1").arg(errorMsg));
-            if (debug) {
-                LogManager::log(QString("Debug: %1").arg(QString::fromUtf8(debug)));
-            }
+void StreamManager::setRecordingFormat(int format)
+{
+    format = qBound(0, format, kRecordingFormatCount - 1);
+    if (m_recordingFormat != format) {
+        m_recordingFormat = format;
+        emit recordingFormatChanged();
+
+        // Takes effect with the next recording
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("recordingFormat", format);
+    }
+}
 
-            self->setStatus(QString("Error: %1").arg(errorMsg));
-            emit self->errorOccurred(errorMsg);
+void StreamManager::setRecordingDirectory(const QString &directory)
+{
+    if (m_recordingDirectory != directory) {
+        m_recordingDirectory = directory;
+        emit recordingDirectoryChanged();
 
-            if (error) g_error_free(error);
-            if (debug) g_free(debug);
-            break;
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("recordingDirectory", directory);
+    }
+}
+
+QStringList StreamManager::snapshotFormatOptions() const
+{
+    QStringList options;
+    for (const SnapshotFormat &format : kSnapshotFormats) {
+        options.append(QString::fromUtf8(format.label));
+    }
+    return options;
+}
+
+void StreamManager::setSnapshotFormat(int format)
+{
+    format = qBound(0, format, kSnapshotFormatCount - 1);
+    if (m_snapshotFormat != format) {
+        m_snapshotFormat = format;
+        emit snapshotSettingsChanged();
+
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("snapshotFormat", format);
+    }
+}
+
+void StreamManager::setSnapshotFullResolution(bool enabled)
+{
+    if (m_snapshotFullResolution != enabled) {
+        m_snapshotFullResolution = enabled;
+        emit snapshotSettingsChanged();
+
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("snapshotFullResolution", enabled);
+    }
+}
+
+void StreamManager::setReplayEnabled(bool enabled)
+{
+    if (m_replayEnabled != enabled) {
+        m_replayEnabled = enabled;
+        emit replayChanged();
+
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("replayEnabled", enabled);
+        applyReplayBuffer();
+    }
+}
+
+void StreamManager::setReplaySeconds(int seconds)
+{
+    seconds = qBound(1, seconds, 600);
+    if (m_replaySeconds != seconds) {
+        m_replaySeconds = seconds;
+        emit replayChanged();
+
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("replaySeconds", seconds);
+        applyReplayBuffer();
+    }
+}
+
+void StreamManager::setReplayMemoryLimit(int megabytes)
+{
+    megabytes = qBound(8, megabytes, 1024);
+    if (m_replayMemoryLimit != megabytes) {
+        // One limit for the whole process, whichever stream it was set on
+        for (StreamManager *stream : std::as_const(s_streams)) {
+            stream->m_replayMemoryLimit = megabytes;
+            emit stream->replayChanged();
         }
 
-        case GST_MESSAGE_EOS:
-            LogManager::log("End of stream");
-            self->setStatus("Stream ended");
-            break;
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("replayMemoryLimit", megabytes);
+        applyReplayBuffer();
+    }
+}
 
-        case GST_MESSAGE_STATE_CHANGED: {
-            if (GST_MESSAGE_SRC(message) == GST_OBJECT(self->m_pipeline)) {
-                GstState oldState, newState;
-                gst_message_parse_state_changed(message, &oldState, &newState, nullptr);
-                LogManager::log(QString("Pipeline state: %1 -> %2")
-                               .arg(QString::fromUtf8(gst_element_state_get_name(oldState)),
-                                    QString::fromUtf8(gst_element_state_get_name(newState))));
+void StreamManager::restartIfStreaming()
+{
+    if (m_isStreaming) {
+        stop();
+        start();
+    }
+}
 
-                if (newState == GST_STATE_PLAYING) {
-                    self->setStatus(QString("Streaming (%1)").arg(self->m_currentDecoder));
-                }
-            }
-            break;
+void StreamManager::setDecoderProfile(int profile)
+{
+    profile = qBound(0, profile, 1);
+    if (m_decoderProfile != profile) {
+        m_decoderProfile = profile;
+        emit decoderProfileChanged();
+
+        QSettings settings("F1sh", "CameraRX");
+        settings.setValue("decoderProfile", profile);
+
+        s_profileLatency.set(profile == DecoderTuning::LowLatency ? 1.0 : 0.0);
+        s_profileThroughput.set(profile == DecoderTuning::Throughput ? 1.0 : 0.0);
+
+        // Threading properties can't change on a running decoder, restart it
+        if (m_isStreaming) {
+            stop();
+            start();
         }
+    }
+}
 
-        case GST_MESSAGE_WARNING: {
-            GError *warning = nullptr;
-            gchar *debug = nullptr;
-            gst_message_parse_warning(message, &warning, &debug);
+void StreamManager::setLowPower(bool enabled)
+{
+    if (m_lowPower.load(std::memory_order_relaxed) != enabled) {
+        m_lowPower.store(enabled, std::memory_order_relaxed);
+        emit lowPowerChanged();
 
-            if (warning) {
-                LogManager::log(QString("GStreamer Warning: %1").arg(QString::fromUtf8(warning->message)));
-                g_error_free(warning);
+        // The GUI-thread poll is only a fallback for the appsink callback;
+        // don't wake the main thread 30 times a second while hidden
+        if (m_isStreaming) {
+            if (enabled) {
+                m_frameTimer->stop();
+            } else {
+                m_frameTimer->start(33);
+                // Ask for an IDR now rather than waiting out the GOP with a
+                // frozen picture
+                requestKeyframe();
             }
-            if (debug) g_free(debug);
-            break;
         }
 
-        default:
-            break;
+        if (enabled) {
+            LOG_INFO(Stream, "Low-power mode on: decoding keyframes only");
+        } else {
+            LOG_INFO(Stream, "Low-power mode off: resuming full decoding at the next keyframe");
+        }
     }
+}
 
-    return TRUE;
+QSize StreamManager::scaledSizeFor(const QSize &source) const
+{
+    if (m_viewportSize.isEmpty()) {
+        return source;
+    }
+
+    // Rotation happens after the scaler, so fit against the unrotated viewport
+    QSize viewport = (m_rotate % 2) ? m_viewportSize.transposed() : m_viewportSize;
+    double scale = qMin(double(viewport.width()) / source.width(),
+                        double(viewport.height()) / source.height());
+    if (scale >= 1.0) {
+        // Never upscale; QML does that for free on the GPU
+        return source;
+    }
+
+    // Keep dimensions even so 4:2:0 chroma planes stay aligned
+    int width = qMax(2, int(std::lround(source.width() * scale)) & ~1);
+    int height = qMax(2, int(std::lround(source.height() * scale)) & ~1);
+    return QSize(width, height);
+}
+
+void StreamManager::applyViewportScale()
+{
+    if (!m_scaleCaps || !m_isStreaming) {
+        return;
+    }
+
+    // Source size comes from what the decoder negotiated with the scaler
+    GstElement *scaler = gst_bin_get_by_name(GST_BIN(m_pipeline), "scaler");
+    if (!scaler) {
+        return;
+    }
+    GstPad *scalerSink = gst_element_get_static_pad(scaler, "sink");
+    GstCaps *sourceCaps = scalerSink ? gst_pad_get_current_caps(scalerSink) : nullptr;
+    if (scalerSink) {
+        gst_object_unref(scalerSink);
+    }
+    gst_object_unref(scaler);
+
+    if (!sourceCaps) {
+        // Not negotiated yet; handleSample() calls back after the first frame
+        return;
+    }
+
+    GstStructure *structure = gst_caps_get_structure(sourceCaps, 0);
+    int sourceWidth = 0;
+    int sourceHeight = 0;
+    int parN = 1;
+    int parD = 1;
+    gst_structure_get_int(structure, "width", &sourceWidth);
+    gst_structure_get_int(structure, "height", &sourceHeight);
+    gst_structure_get_fraction(structure, "pixel-aspect-ratio", &parN, &parD);
+    gst_caps_unref(sourceCaps);
+
+    if (sourceWidth <= 0 || sourceHeight <= 0) {
+        return;
+    }
+
+    QSize source(sourceWidth, sourceHeight);
+    QSize target = scaledSizeFor(source);
+    if (target == m_scaledSize) {
+        return;
+    }
+    m_scaledSize = target;
+
+    GstCaps *caps = nullptr;
+    if (target == source) {
+        caps = gst_caps_new_empty_simple("video/x-raw");
+        LOG_INFO(Stream, QString("Viewport scaling disabled, using source size %1x%2")
+                        .arg(sourceWidth).arg(sourceHeight));
+    } else {
+        caps = gst_caps_new_simple("video/x-raw",
+                                   "width", G_TYPE_INT, target.width(),
+                                   "height", G_TYPE_INT, target.height(),
+                                   "pixel-aspect-ratio", GST_TYPE_FRACTION, parN, parD,
+                                   nullptr);
+        LOG_INFO(Stream, QString("Scaling %1x%2 to %3x%4 for %5x%6 viewport")
+                        .arg(sourceWidth).arg(sourceHeight)
+                        .arg(target.width()).arg(target.height())
+                        .arg(m_viewportSize.width()).arg(m_viewportSize.height()));
+    }
+
+    // Changing the capsfilter sends a reconfigure upstream and videoscale renegotiates live
+    g_object_set(m_scaleCaps, "caps", caps, nullptr);
+    gst_caps_unref(caps);
+}
+
+void StreamManager::setStatus(const QString &status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged();
+    }
+}
+
+void StreamManager::pollForFrames()
+{
+    if (!m_appSink || !m_isStreaming) {
+        return;
+    }
+
+    // Try to pull a sample from appsink (non-blocking)
+    GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(m_appSink), 0);
+    if (!sample) {
+        return;
+    }
+    m_samplesPulled.fetch_add(1, std::memory_order_relaxed);
+
+    handleSample(sample, false);
+    gst_sample_unref(sample);
+}
+
+void StreamManager::handleSample(GstSample *sample, bool fromCallback)
+{
+    TRACE_SCOPE("stream", "frame");
+
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+    if (!buffer || !caps) {
+        return;
+    }
+
+    // The replay branch owns the display; live frames only keep the watchdog fed
+    if (m_timeShifting.load(std::memory_order_relaxed)) {
+        m_lastFrameMs.store(m_sessionClock.elapsed(), std::memory_order_relaxed);
+        return;
+    }
+
+    // Within a frame-rate budget, skip conversion and delivery of excess frames.
+    // 10% slack keeps a budget that divides the source rate from dropping to the next step.
+    int maxFrameRate = m_maxFrameRate.load(std::memory_order_relaxed);
+    if (maxFrameRate > 0) {
+        qint64 now = m_sessionClock.elapsed();
+        qint64 sinceLast = now - m_lastDeliveredMs.load(std::memory_order_relaxed);
+        // Negative when the clock restarted under a late frame; deliver rather than stall
+        if (sinceLast >= 0 && sinceLast < 900 / maxFrameRate) {
+            m_lastFrameMs.store(now, std::memory_order_relaxed);
+            s_framesThrottled.inc();
+            return;
+        }
+        m_lastDeliveredMs.store(now, std::memory_order_relaxed);
+    }
+
+    GstVideoInfo videoInfo;
+    if (!gst_video_info_from_caps(&videoInfo, caps)) {
+        countDecodeError();
+        return;
+    }
+
+    QImage frame;
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&videoInfo);
+
+    if (format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_NV12) {
+        TRACE_SCOPE("stream", "convert");
+        frame = convertYuvFrame(buffer, &videoInfo, m_pipelineRotate);
+    } else {
+        TRACE_SCOPE("stream", "copy");
+        GstMapInfo mapInfo;
+        if (gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
+            // Get proper stride from video info
+            int stride = GST_VIDEO_INFO_PLANE_STRIDE(&videoInfo, 0);
+
+            // Create QImage from RGB data and make a deep copy since the buffer will be released
+            frame = QImage(mapInfo.data,
+                           videoInfo.width,
+                           videoInfo.height,
+                           stride,
+                           QImage::Format_RGB888).copy();
+
+            gst_buffer_unmap(buffer, &mapInfo);
+        }
+    }
+
+    if (frame.isNull()) {
+        countDecodeError();
+        return;
+    }
+
+    {
+        TRACE_SCOPE("stream", "publish");
+        m_imageProvider->updateFrame(frame);
+    }
+    recordFrameMetrics(buffer);
+    m_lastFrameMs.store(m_sessionClock.elapsed(), std::memory_order_relaxed);
+
+    // Log first frame received (per session)
+    m_frameCount++;
+    if (!m_firstFrameReceived) {
+        LOG_INFO(Stream, QString("First frame received%1: %2x%3, format=%4, displayed as %5x%6")
+                       .arg(fromCallback ? " (callback)" : "")
+                       .arg(videoInfo.width).arg(videoInfo.height)
+                       .arg(QString::fromUtf8(gst_video_format_to_string(format)))
+                       .arg(frame.width()).arg(frame.height()));
+        Trace::instant("stream", "firstFrame");
+        m_firstFrameReceived = true;
+
+        // Caps are known now, fit the output to the viewport
+        QMetaObject::invokeMethod(this, &StreamManager::applyViewportScale, Qt::QueuedConnection);
+    }
+
+    // Log periodic frame count updates (every 300 frames ~ 10 seconds at 30fps),
+    // at most one every 10 s across all streams
+    if (m_frameCount % 300 == 0) {
+        LOG_AT_RATE(Stream, Debug, 0.1, 1, QString("Received %1 frames").arg(m_frameCount));
+    }
+
+    emit frameReady();
+}
+
+QImage StreamManager::convertYuvFrame(GstBuffer *buffer, GstVideoInfo *videoInfo, int rotate)
+{
+    GstVideoFrame videoFrame;
+    if (!gst_video_frame_map(&videoFrame, videoInfo, buffer, GST_MAP_READ)) {
+        return QImage();
+    }
+
+    const GstVideoColorimetry &colorimetry = GST_VIDEO_INFO_COLORIMETRY(videoInfo);
+    bool nv12 = GST_VIDEO_INFO_FORMAT(videoInfo) == GST_VIDEO_FORMAT_NV12;
+
+    ColorConvert::YuvImage yuv;
+    yuv.layout = nv12 ? ColorConvert::Layout::NV12 : ColorConvert::Layout::I420;
+    yuv.matrix = colorimetry.matrix == GST_VIDEO_COLOR_MATRIX_BT601
+        ? ColorConvert::Matrix::Bt601 : ColorConvert::Matrix::Bt709;
+    yuv.fullRange = colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+    yuv.width = GST_VIDEO_INFO_WIDTH(videoInfo);
+    yuv.height = GST_VIDEO_INFO_HEIGHT(videoInfo);
+    yuv.y = static_cast<const quint8*>(GST_VIDEO_FRAME_PLANE_DATA(&videoFrame, 0));
+    yuv.strideY = GST_VIDEO_FRAME_PLANE_STRIDE(&videoFrame, 0);
+    yuv.u = static_cast<const quint8*>(GST_VIDEO_FRAME_PLANE_DATA(&videoFrame, 1));
+    yuv.strideU = GST_VIDEO_FRAME_PLANE_STRIDE(&videoFrame, 1);
+    if (!nv12) {
+        yuv.v = static_cast<const quint8*>(GST_VIDEO_FRAME_PLANE_DATA(&videoFrame, 2));
+        yuv.strideV = GST_VIDEO_FRAME_PLANE_STRIDE(&videoFrame, 2);
+    }
+
+    // 90/270 degree rotation swaps the output dimensions
+    bool swapAxes = (rotate % 2) != 0;
+    QImage image(swapAxes ? yuv.height : yuv.width,
+                 swapAxes ? yuv.width : yuv.height,
+                 QImage::Format_RGB32);
+
+    bool ok = !image.isNull()
+              && ColorConvert::convertToRgb32(yuv, rotate, image.bits(), image.bytesPerLine());
+
+    gst_video_frame_unmap(&videoFrame);
+    return ok ? image : QImage();
+}
+
+void StreamManager::recordFrameMetrics(GstBuffer *buffer)
+{
+    s_framesDecoded.inc();
+    m_framesDelivered.fetch_add(1, std::memory_order_relaxed);
+
+    // With sync=false the buffer PTS is the running time at which udpsrc
+    // captured the packet, so (now - PTS) is the receive-to-decode latency
+    if (!m_pipeline || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+        return;
+    }
+
+    GstClock *clock = gst_element_get_clock(m_pipeline);
+    if (!clock) {
+        return;
+    }
+
+    GstClockTime now = gst_clock_get_time(clock);
+    GstClockTime baseTime = gst_element_get_base_time(m_pipeline);
+    gst_object_unref(clock);
+
+    if (now > baseTime) {
+        GstClockTime runningTime = now - baseTime;
+        GstClockTime pts = GST_BUFFER_PTS(buffer);
+        if (runningTime >= pts) {
+            s_frameLatency.observe(static_cast<double>(runningTime - pts) / GST_SECOND);
+        }
+    }
+}
+
+void StreamManager::updateStreamStats()
+{
+    qint64 elapsedMs = m_statsElapsed.restart();
+    quint64 frames = m_framesDelivered.load(std::memory_order_relaxed);
+
+    if (elapsedMs > 0) {
+        m_fps = (frames - m_statsLastFrames) * 1000.0 / elapsedMs;
+        publishFps(m_fps);
+    }
+    m_statsLastFrames = frames;
+
+    // appsink has no drop signal: anything that entered it, was not pulled and
+    // cannot still be sitting in its queue was dropped. This is a lower bound
+    // that trails the true value by at most kAppSinkMaxBuffers.
+    qint64 appsinkIn = static_cast<qint64>(m_appSinkBuffersIn.load(std::memory_order_relaxed));
+    qint64 pulled = static_cast<qint64>(m_samplesPulled.load(std::memory_order_relaxed));
+    qint64 appsinkDropped = qMax<qint64>(0, appsinkIn - pulled - kAppSinkMaxBuffers);
+    if (appsinkDropped > m_droppedAppsink) {
+        s_framesDroppedAppsink.inc(appsinkDropped - m_droppedAppsink);
+        m_droppedAppsink = appsinkDropped;
+    }
+
+    if (m_imageProvider) {
+        qint64 superseded = static_cast<qint64>(m_imageProvider->supersededCount() - m_supersededBase);
+        if (superseded > m_droppedSuperseded) {
+            s_framesDroppedSuperseded.inc(superseded - m_droppedSuperseded);
+            m_droppedSuperseded = superseded;
+        }
+    }
+
+    m_droppedQueue = static_cast<qint64>(m_queueLeaks.load(std::memory_order_relaxed));
+    m_droppedDecodeError = static_cast<qint64>(m_decodeErrors.load(std::memory_order_relaxed));
+
+    if (m_replayEnabled) {
+        updateReplayStats();
+    }
+
+    emit streamStatsChanged();
+}
+
+void StreamManager::publishFps(double fps)
+{
+    // The gauge covers every stream in the process, so publish this stream's change
+    qint64 milli = std::llround(fps * 1000.0);
+    qint64 delta = milli - m_fpsPublishedMilli;
+    s_streamFps.set((s_streamFpsTotalMilli.fetch_add(delta) + delta) / 1000.0);
+    m_fpsPublishedMilli = milli;
+}
+
+void StreamManager::resetDropStats()
+{
+    m_queueLeaks.store(0, std::memory_order_relaxed);
+    m_appSinkBuffersIn.store(0, std::memory_order_relaxed);
+    m_samplesPulled.store(0, std::memory_order_relaxed);
+    m_decodeErrors.store(0, std::memory_order_relaxed);
+    m_supersededBase = m_imageProvider ? m_imageProvider->supersededCount() : 0;
+
+    m_fps = 0.0;
+    m_droppedQueue = 0;
+    m_droppedAppsink = 0;
+    m_droppedSuperseded = 0;
+    m_droppedDecodeError = 0;
+    emit streamStatsChanged();
+}
+
+void StreamManager::countDecodeError()
+{
+    m_decodeErrors.fetch_add(1, std::memory_order_relaxed);
+    s_framesDroppedDecodeError.inc();
+}
+
+void StreamManager::checkStreamHealth()
+{
+    if (!m_isStreaming) {
+        return;
+    }
+
+    qint64 now = m_sessionClock.elapsed();
+    qint64 lastFrame = m_lastFrameMs.load(std::memory_order_relaxed);
+
+    if (m_recoveryStage == RecoveryStage::Healthy) {
+        // Keyframe-only decoding produces frames too rarely to judge a stall
+        if (lowPower() || now - lastFrame < kStallTimeoutMs) {
+            return;
+        }
+        beginRecovery(QString("no frames for %1 ms").arg(now - lastFrame), RecoveryStage::Flushed);
+        return;
+    }
+
+    // Any frame since recovery began means the stream is back
+    if (lastFrame > m_recoveryStartMs) {
+        double seconds = (lastFrame - m_outageStartMs) / 1000.0;
+        s_recoveryTime.observe(seconds);
+        LOG_INFO(Stream, QString("Stream recovered after %1 s (%2 rebuild(s))")
+                        .arg(seconds, 0, 'f', 2).arg(m_restartAttempt));
+        m_recoveryStage = RecoveryStage::Healthy;
+        m_restartAttempt = 0;
+        setStatus(QString("Streaming (%1)").arg(m_currentDecoder));
+        return;
+    }
+
+    switch (m_recoveryStage) {
+        case RecoveryStage::Flushed:
+            if (now - m_stageStartMs >= kRecoveryStepMs) {
+                LOG_WARNING(Stream, "Watchdog: still no frames after flush, requesting a keyframe");
+                requestKeyframe();
+                m_recoveryStage = RecoveryStage::KeyframeRequested;
+                m_stageStartMs = now;
+                setStatus("Recovering: waiting for keyframe");
+            }
+            break;
+
+        case RecoveryStage::KeyframeRequested:
+            if (now - m_stageStartMs >= kRecoveryStepMs) {
+                LOG_WARNING(Stream, "Watchdog: still no frames after keyframe request, rebuilding pipeline");
+                m_recoveryStage = RecoveryStage::Rebuilding;
+                m_nextRestartMs = now;
+            }
+            break;
+
+        case RecoveryStage::Rebuilding:
+            if (now >= m_nextRestartMs) {
+                int delay = qMin(kRestartBackoffMaxMs, kRestartBackoffBaseMs << qMin(m_restartAttempt, 6));
+                m_restartAttempt++;
+                m_stageStartMs = now;
+                m_nextRestartMs = now + delay;
+
+                setStatus(QString("Recovering: restart %1").arg(m_restartAttempt));
+                LOG_INFO(Stream, QString("Watchdog: rebuilding pipeline (attempt %1, next retry in %2 ms)")
+                                .arg(m_restartAttempt).arg(delay));
+                rebuildPipeline();
+            }
+            break;
+
+        case RecoveryStage::Healthy:
+            break;
+    }
+}
+
+void StreamManager::beginRecovery(const QString &reason, RecoveryStage stage)
+{
+    qint64 now = m_sessionClock.elapsed();
+
+    if (m_recoveryStage == RecoveryStage::Healthy) {
+        s_streamStalls.inc();
+        m_outageStartMs = m_lastFrameMs.load(std::memory_order_relaxed);
+        m_recoveryStartMs = now;
+        m_restartAttempt = 0;
+    }
+    LOG_WARNING(Stream, QString("Watchdog: stream stalled (%1), recovering").arg(reason));
+    if (Trace::isEnabled()) {
+        Trace::instant("stream", "stall", reason.toUtf8().constData());
+    }
+
+    m_recoveryStage = stage;
+    m_stageStartMs = now;
+
+    if (stage == RecoveryStage::Flushed) {
+        flushPipeline();
+        setStatus("Recovering: flushing");
+    } else if (stage == RecoveryStage::Rebuilding) {
+        m_nextRestartMs = now;
+    }
+}
+
+void StreamManager::flushPipeline()
+{
+    if (!m_pipeline) {
+        return;
+    }
+
+    // Flushing from the live source drops whatever the depayloader, decoder
+    // and queues are holding; basesrc restarts its task on flush-stop.
+    // Running time is not reset so latency metrics stay valid.
+    GstElement *source = gst_bin_get_by_name(GST_BIN(m_pipeline), "src");
+    if (source && !GST_IS_BASE_SRC(source)) {
+        // rtspsrc is a bin; its jitterbuffer resyncs on its own
+        gst_object_unref(source);
+        return;
+    }
+    if (source) {
+        gst_element_send_event(source, gst_event_new_flush_start());
+        gst_element_send_event(source, gst_event_new_flush_stop(FALSE));
+        gst_object_unref(source);
+    }
+}
+
+void StreamManager::requestKeyframe()
+{
+    if (!m_appSink) {
+        return;
+    }
+
+    // Travels upstream to the depayloader; only senders with a feedback
+    // channel act on it, otherwise we wait for the next periodic IDR
+    GstEvent *event = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0);
+    gst_element_send_event(m_appSink, event);
+}
+
+bool StreamManager::rebuildPipeline()
+{
+    TRACE_SCOPE("stream", "rebuildPipeline");
+    s_pipelineRebuilds.inc();
+
+    bool wasRecording = m_isRecording;
+    destroyPipeline();
+    resetRtpStats();
+    m_firstFrameReceived = false;
+
+    if (!createPipeline()) {
+        LOG_ERROR(Stream, "Watchdog: pipeline rebuild failed");
+        return false;
+    }
+
+    if (gst_element_set_state(m_pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        LOG_ERROR(Stream, "Watchdog: rebuilt pipeline failed to start");
+        destroyPipeline();
+        return false;
+    }
+
+    if (wasRecording) {
+        LOG_INFO(Stream, "Watchdog: continuing the recording in a new file");
+        startRecording();
+    }
+
+    return true;
+}
+
+bool StreamManager::isDecoderChainElement(GstObject *object) const
+{
+    if (!m_pipeline) {
+        return false;
+    }
+
+    bool found = false;
+    for (const char *name : {"decoder", "download"}) {
+        GstElement *element = gst_bin_get_by_name(GST_BIN(m_pipeline), name);
+        if (element) {
+            found = found || object == GST_OBJECT(element)
+                    || gst_object_has_as_ancestor(object, GST_OBJECT(element));
+            gst_object_unref(element);
+        }
+    }
+    return found;
+}
+
+bool StreamManager::inFailoverGrace() const
+{
+    return m_failoverPending
+           || (m_lastFailoverMs >= 0 && m_sessionClock.elapsed() - m_lastFailoverMs < kFailoverGraceMs);
+}
+
+bool StreamManager::startDecoderFailover(const QString &reason)
+{
+    if (Trace::isEnabled()) {
+        Trace::instant("stream", "decoderFailover", reason.toUtf8().constData());
+    }
+    if (m_failoverPending || !m_pipeline) {
+        return false;
+    }
+
+    bool currentIsHardware = false;
+    for (const auto &decoder : m_decoders) {
+        if (decoder.elementName == m_decoderElement) {
+            currentIsHardware = decoder.isHardware;
+        }
+    }
+
+    DecoderInfo softwareDecoder = selectSoftwareDecoder();
+    if (!currentIsHardware || softwareDecoder.priority < 0) {
+        return false;
+    }
+
+    GstElement *parser = gst_bin_get_by_name(GST_BIN(m_pipeline), "parse");
+    if (!parser) {
+        return false;
+    }
+    GstPad *parserSrc = gst_element_get_static_pad(parser, "src");
+    gst_object_unref(parser);
+    if (!parserSrc) {
+        return false;
+    }
+
+    LOG_WARNING(Stream, QString("Decoder %1 failed (%2), switching to %3 without restarting the stream")
+                    .arg(m_currentDecoder, reason, softwareDecoder.name));
+    setStatus(QString("Switching to %1").arg(softwareDecoder.name));
+
+    m_failoverDecoder = softwareDecoder;
+    m_failoverPending = true;
+    m_lastFailoverMs = m_sessionClock.elapsed();
+
+    // The idle probe runs once no buffer is in flight on the parser output,
+    // either right here or on the streaming thread after the current push
+    gst_pad_add_probe(parserSrc, GST_PAD_PROBE_TYPE_IDLE, onParserIdle, this, nullptr);
+    gst_object_unref(parserSrc);
+    return true;
+}
+
+bool StreamManager::swapDecoder()
+{
+    // The decoder hangs off the recording tee; a running recording keeps its
+    // own tee pad and is not interrupted by the swap
+    GstBin *bin = GST_BIN(m_pipeline);
+    GstElement *tee = gst_bin_get_by_name(bin, "rectee");
+    GstElement *oldDecoder = gst_bin_get_by_name(bin, "decoder");
+    GstElement *download = gst_bin_get_by_name(bin, "download");
+    GstElement *scaler = gst_bin_get_by_name(bin, "scaler");
+    bool ok = false;
+
+    if (tee && oldDecoder && scaler) {
+        // Drop the failed decoder (and its download element) without draining it;
+        // unlinking also releases the decoder's tee pad
+        gst_element_unlink(tee, oldDecoder);
+        gst_element_unlink(download ? download : oldDecoder, scaler);
+        for (GstElement *element : {oldDecoder, download}) {
+            if (element) {
+                gst_element_set_state(element, GST_STATE_NULL);
+                gst_bin_remove(bin, element);
+            }
+        }
+
+        const QByteArray factory = m_failoverDecoder.elementName.toUtf8();
+        GstElement *newDecoder = gst_element_factory_make(factory.constData(), "decoder");
+        if (newDecoder) {
+            applyDecoderTuning(newDecoder, m_failoverDecoder.elementName);
+            gst_bin_add(bin, newDecoder);
+
+            if (gst_element_link(tee, newDecoder) && gst_element_link(newDecoder, scaler)) {
+                GstPad *decoderSink = gst_element_get_static_pad(newDecoder, "sink");
+                if (decoderSink) {
+                    gst_pad_add_probe(decoderSink, GST_PAD_PROBE_TYPE_BUFFER, onDecoderInput, this, nullptr);
+                    gst_object_unref(decoderSink);
+                }
+
+                // The new decoder has no reference pictures; resume at the next IDR.
+                // Sticky caps/segment events are copied by the tee to the new pad.
+                m_awaitingKeyframe = true;
+                ok = gst_element_sync_state_with_parent(newDecoder);
+            }
+        }
+    }
+
+    if (tee) gst_object_unref(tee);
+    if (oldDecoder) gst_object_unref(oldDecoder);
+    if (download) gst_object_unref(download);
+    if (scaler) gst_object_unref(scaler);
+    return ok;
+}
+
+void StreamManager::finishDecoderFailover(bool success)
+{
+    m_failoverPending = false;
+    if (!m_isStreaming) {
+        return;
+    }
+
+    // Subsequent rebuilds should not go back to the failed decoder
+    m_preferredDecoder = m_failoverDecoder.elementName;
+
+    if (!success) {
+        LOG_WARNING(Stream, QString("Decoder failover to %1 failed, rebuilding pipeline")
+                        .arg(m_failoverDecoder.name));
+        beginRecovery("decoder failover failed", RecoveryStage::Rebuilding);
+        return;
+    }
+
+    s_decoderFailovers.inc();
+    m_currentDecoder = m_failoverDecoder.name;
+    m_decoderElement = m_failoverDecoder.elementName;
+    emit currentDecoderChanged();
+
+    // If the decoder error stopped udpsrc's task, a flush restarts it; otherwise
+    // it only drops packets the new decoder couldn't use before the next IDR
+    flushPipeline();
+
+    setStatus(QString("Streaming (%1)").arg(m_currentDecoder));
+    LOG_INFO(Stream, QString("Decoder failover complete, now using %1").arg(m_currentDecoder));
+}
+
+// GStreamer callback: parser output idle, safe to relink the decoder
+GstPadProbeReturn StreamManager::onParserIdle(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    Q_UNUSED(info);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    bool success = self->swapDecoder();
+    QMetaObject::invokeMethod(self, [self, success]() {
+        self->finishDecoderFailover(success);
+    }, Qt::QueuedConnection);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+// ============ Recording ============
+
+bool StreamManager::startRecording()
+{
+    if (m_isRecording) {
+        LOG_INFO(Stream, "Recording already running");
+        return false;
+    }
+    if (m_recordBin) {
+        LOG_INFO(Stream, "Previous recording is still being finalised");
+        return false;
+    }
+    if (!m_isStreaming || !m_pipeline) {
+        LOG_WARNING(Stream, "Recording needs a running stream");
+        return false;
+    }
+
+    QDir directory(m_recordingDirectory);
+    if (m_recordingDirectory.isEmpty() || !directory.mkpath(".")) {
+        LOG_WARNING(Stream, QString("Recording directory is not usable: '%1'").arg(m_recordingDirectory));
+        return false;
+    }
+
+    const RecordingFormat &format = kRecordingFormats[m_recordingFormat];
+    const QString path = directory.absoluteFilePath(
+        QString("F1sh_%1_%2.%3").arg(m_port)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"), QString::fromUtf8(format.extension)));
+
+    // The queue gives muxing and disk writes their own thread, so they never
+    // block the tee and with it the decoder. It doesn't leak: a leaky queue
+    // would drop access units mid-GOP and corrupt the file until the next
+    // keyframe. Instead onRecordBuffer() drops whole GOPs once the queue holds
+    // kRecordQueueSeconds, and the extra second of room means the queue never
+    // fills and blocks the tee. h264parse converts the byte-stream to the avc
+    // format the muxers expect; nothing is re-encoded.
+    const QString description =
+        QString("queue name=recqueue max-size-buffers=0 max-size-bytes=0 max-size-time=%1 ! "
+                "h264parse ! %2 ! filesink name=recsink async=false")
+            .arg((kRecordQueueSeconds + 1) * GST_SECOND).arg(QString::fromUtf8(format.muxer));
+
+    GError *error = nullptr;
+    GstElement *bin = gst_parse_bin_from_description(description.toUtf8().constData(), TRUE, &error);
+    if (!bin || error) {
+        LOG_WARNING(Stream, QString("Failed to create recording branch: %1")
+                        .arg(error ? QString::fromUtf8(error->message) : QString("unknown error")));
+        if (error) g_error_free(error);
+        if (bin) gst_object_unref(bin);
+        return false;
+    }
+
+    GstElement *fileSink = gst_bin_get_by_name(GST_BIN(bin), "recsink");
+    g_object_set(fileSink, "location", path.toUtf8().constData(), nullptr);
+    GstPad *fileSinkPad = gst_element_get_static_pad(fileSink, "sink");
+    gst_pad_add_probe(fileSinkPad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, onRecordSinkEvent, this, nullptr);
+    gst_object_unref(fileSinkPad);
+    gst_object_unref(fileSink);
+
+    GstElement *tee = gst_bin_get_by_name(GST_BIN(m_pipeline), "rectee");
+    if (!tee) {
+        LOG_WARNING(Stream, "Pipeline has no recording tee");
+        gst_object_unref(bin);
+        return false;
+    }
+
+    gst_bin_add(GST_BIN(m_pipeline), bin);
+    m_recordBin = GST_ELEMENT(gst_object_ref(bin));
+
+    // Bring the branch up before linking so the first buffer finds it playing,
+    // and drop everything up to the next keyframe so the file starts decodable
+    m_recordAwaitKeyframe.store(true, std::memory_order_relaxed);
+    gst_element_sync_state_with_parent(m_recordBin);
+
+    GstPad *teePad = gst_element_request_pad_simple(tee, "src_%u");
+    GstPad *binPad = gst_element_get_static_pad(m_recordBin, "sink");
+    RecordProbe *probe = new RecordProbe{this, gst_bin_get_by_name(GST_BIN(m_recordBin), "recqueue")};
+    m_recordOverrun.store(false, std::memory_order_relaxed);
+    gst_pad_add_probe(teePad, GST_PAD_PROBE_TYPE_BUFFER, onRecordBuffer, probe, freeRecordProbe);
+    GstPadLinkReturn linked = gst_pad_link(teePad, binPad);
+    gst_object_unref(binPad);
+
+    if (linked != GST_PAD_LINK_OK) {
+        LOG_WARNING(Stream, QString("Failed to link recording branch: %1")
+                        .arg(QString::fromUtf8(gst_pad_link_get_name(linked))));
+        gst_element_release_request_pad(tee, teePad);
+        gst_object_unref(teePad);
+        gst_object_unref(tee);
+        gst_element_set_state(m_recordBin, GST_STATE_NULL);
+        gst_bin_remove(GST_BIN(m_pipeline), m_recordBin);
+        gst_object_unref(m_recordBin);
+        m_recordBin = nullptr;
+        return false;
+    }
+    gst_object_unref(tee);
+
+    m_recordTeePad = teePad;
+    m_recordGeneration++;
+    m_recordingPath = path;
+    m_isRecording = true;
+    emit recordingChanged();
+    LOG_INFO(Stream, QString("Recording started: %1 (%2)").arg(path, QString::fromUtf8(format.label)));
+
+    // Don't wait a whole GOP for the first keyframe if the sender can produce one
+    requestKeyframe();
+    return true;
+}
+
+void StreamManager::stopRecording()
+{
+    if (!m_isRecording) {
+        return;
+    }
+
+    m_isRecording = false;
+    emit recordingChanged();
+    LOG_INFO(Stream, QString("Stopping recording, finalising %1").arg(m_recordingPath));
+
+    // Detach once no buffer is in flight on the tee pad, then let EOS drain
+    // the branch so the muxer writes out its last fragment / index
+    gst_pad_add_probe(m_recordTeePad, GST_PAD_PROBE_TYPE_IDLE, onRecordTeeIdle, this, nullptr);
+
+    const int generation = m_recordGeneration;
+    QTimer::singleShot(kRecordFinalizeTimeoutMs, this, [this, generation]() {
+        if (generation == m_recordGeneration && m_recordBin) {
+            LOG_WARNING(Stream, "Recording did not drain in time, closing it");
+            finishRecording();
+        }
+    });
+}
+
+void StreamManager::onRecordingDetached(GstPad *teePad)
+{
+    // The pipeline may have been torn down (and a new recording started) meanwhile
+    if (m_recordTeePad && m_recordTeePad == teePad) {
+        gst_object_unref(m_recordTeePad);
+        m_recordTeePad = nullptr;
+    }
+}
+
+void StreamManager::finishRecording()
+{
+    // Still attached to the tee: only releaseRecording() may tear it down
+    if (!m_recordBin || m_recordTeePad) {
+        return;
+    }
+
+    gst_element_set_state(m_recordBin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(m_pipeline), m_recordBin);
+    gst_object_unref(m_recordBin);
+    m_recordBin = nullptr;
+
+    LOG_INFO(Stream, QString("Recording saved: %1 (%2 KB)")
+                    .arg(m_recordingPath).arg(QFileInfo(m_recordingPath).size() / 1024));
+}
+
+void StreamManager::releaseRecording()
+{
+    // Pipeline is already in NULL; the branch goes away with it. Fragments
+    // already on disk stay playable even though no trailer was written.
+    if (m_recordTeePad) {
+        GstElement *tee = gst_pad_get_parent_element(m_recordTeePad);
+        if (tee) {
+            gst_element_release_request_pad(tee, m_recordTeePad);
+            gst_object_unref(tee);
+        }
+        gst_object_unref(m_recordTeePad);
+        m_recordTeePad = nullptr;
+    }
+
+    if (m_recordBin) {
+        gst_object_unref(m_recordBin);
+        m_recordBin = nullptr;
+    }
+
+    if (m_isRecording) {
+        m_isRecording = false;
+        emit recordingChanged();
+        LOG_INFO(Stream, QString("Recording ended with the stream: %1").arg(m_recordingPath));
+    }
+}
+
+void StreamManager::freeRecordProbe(gpointer data)
+{
+    RecordProbe *probe = static_cast<RecordProbe*>(data);
+    if (probe->queue) {
+        gst_object_unref(probe->queue);
+    }
+    delete probe;
+}
+
+// GStreamer pad probe: encoded buffer leaving the tee for the recording (streaming thread)
+GstPadProbeReturn StreamManager::onRecordBuffer(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    RecordProbe *probe = static_cast<RecordProbe*>(userData);
+    StreamManager *self = probe->self;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    // Disk too far behind: drop from here up to a keyframe that finds room,
+    // so the file skips whole GOPs instead of holding undecodable fragments
+    guint64 queued = 0;
+    if (probe->queue) {
+        g_object_get(probe->queue, "current-level-time", &queued, nullptr);
+    }
+    const bool full = queued >= kRecordQueueSeconds * GST_SECOND;
+    if (full && !self->m_recordOverrun.load(std::memory_order_relaxed)) {
+        self->m_recordOverrun.store(true, std::memory_order_relaxed);
+        self->m_recordAwaitKeyframe.store(true, std::memory_order_relaxed);
+        LOG_AT_RATE(Stream, Warning, 0.2, 1,
+                    QString("Recording is %1 s behind, dropping until the next keyframe").arg(kRecordQueueSeconds));
+    }
+
+    if (self->m_recordAwaitKeyframe.load(std::memory_order_relaxed)) {
+        const bool overrun = self->m_recordOverrun.load(std::memory_order_relaxed);
+        if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) || full) {
+            if (overrun) {
+                s_recordingDropped.inc();
+            }
+            return GST_PAD_PROBE_DROP;
+        }
+        self->m_recordAwaitKeyframe.store(false, std::memory_order_relaxed);
+        self->m_recordOverrun.store(false, std::memory_order_relaxed);
+    }
+
+    s_recordedBytes.inc(gst_buffer_get_size(buffer));
+    return GST_PAD_PROBE_OK;
+}
+
+// GStreamer callback: recording tee pad idle, safe to detach the branch
+GstPadProbeReturn StreamManager::onRecordTeeIdle(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(info);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    GstPad *binPad = gst_element_get_static_pad(self->m_recordBin, "sink");
+    gst_pad_unlink(pad, binPad);
+
+    GstElement *tee = gst_pad_get_parent_element(pad);
+    if (tee) {
+        gst_element_release_request_pad(tee, pad);
+        gst_object_unref(tee);
+    }
+
+    // Queued ahead of the EOS notification so finishRecording() sees the branch detached
+    QMetaObject::invokeMethod(self, [self, pad]() {
+        self->onRecordingDetached(pad);
+    }, Qt::QueuedConnection);
+
+    // Travels through the branch's queue thread; the muxer finalises the file before passing it on
+    gst_pad_send_event(binPad, gst_event_new_eos());
+    gst_object_unref(binPad);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+// GStreamer pad probe: event arriving at the recording filesink (queue thread)
+GstPadProbeReturn StreamManager::onRecordSinkEvent(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_EOS) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Everything is written; keep the EOS away from the pipeline bus, where it would mean the stream ended
+    QMetaObject::invokeMethod(self, [self]() {
+        self->finishRecording();
+    }, Qt::QueuedConnection);
+    return GST_PAD_PROBE_DROP;
+}
+
+// ============ Replay Buffer ============
+
+void StreamManager::applyReplayBuffer()
+{
+    s_replayStreams.removeOne(this);
+    if (m_replayEnabled) {
+        s_replayStreams.append(this);
+    } else if (m_replayBuffer.isAllocated()) {
+        m_replayBuffer.release();
+        m_replayUnits = 0;
+        LOG_INFO(Stream, "Replay buffer disabled");
+        updateReplayStats();
+    }
+
+    // Every enabled stream's share depends on how many there are
+    for (StreamManager *stream : std::as_const(s_replayStreams)) {
+        stream->allocateReplayBuffer();
+    }
+}
+
+void StreamManager::allocateReplayBuffer()
+{
+    const qint64 shareBytes = qint64(m_replayMemoryLimit) * 1024 * 1024 / qMax(1, int(s_replayStreams.size()));
+    const int units = m_replaySeconds * kReplayMaxFps;
+    m_replayBuffer.setRetention(GstClockTime(m_replaySeconds) * GST_SECOND);
+
+    // Reallocating drops the buffered history, so only when the layout changes
+    if (m_replayBuffer.isAllocated() && m_replayBuffer.capacityBytes() == shareBytes && m_replayUnits == units) {
+        return;
+    }
+    m_replayBuffer.allocate(shareBytes, units);
+    m_replayUnits = units;
+    LOG_INFO(Stream, QString("Replay buffer: last %1 s, %2 MB (%3 MB shared by %4 stream(s))")
+                    .arg(m_replaySeconds).arg(shareBytes / 1048576.0, 0, 'f', 1)
+                    .arg(m_replayMemoryLimit).arg(s_replayStreams.size()));
+    updateReplayStats();
+}
+
+void StreamManager::updateReplayStats()
+{
+    qint64 allocated = m_replayBuffer.capacityBytes();
+    qint64 used = m_replayBuffer.usedBytes();
+
+    // Gauges cover every stream in the process, so publish this stream's change
+    s_replayAllocated.set(double(s_replayAllocatedTotal.fetch_add(allocated - m_replayMemoryAllocated)
+                                 + allocated - m_replayMemoryAllocated));
+    s_replayUsed.set(double(s_replayUsedTotal.fetch_add(used - m_replayMemoryUsed)
+                            + used - m_replayMemoryUsed));
+
+    m_replayMemoryAllocated = allocated;
+    m_replayMemoryUsed = used;
+    m_replayBufferedSeconds = double(m_replayBuffer.bufferedDuration()) / GST_SECOND;
+    emit replayStatsChanged();
+}
+
+bool StreamManager::exportReplay(int seconds)
+{
+    if (!m_replayEnabled) {
+        LOG_INFO(Stream, "Replay export: replay buffer is disabled");
+        return false;
+    }
+    if (m_isExporting) {
+        LOG_INFO(Stream, "Replay export already running");
+        return false;
+    }
+
+    QDir directory(m_recordingDirectory);
+    if (m_recordingDirectory.isEmpty() || !directory.mkpath(".")) {
+        LOG_WARNING(Stream, QString("Recording directory is not usable: '%1'").arg(m_recordingDirectory));
+        return false;
+    }
+
+    const RecordingFormat &format = kRecordingFormats[m_recordingFormat];
+    const QString path = directory.absoluteFilePath(
+        QString("F1sh_replay_%1_%2.%3").arg(m_port)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"), QString::fromUtf8(format.extension)));
+
+    if (!m_replayThread) {
+        m_replayThread = new QThread(this);
+        m_replayExporter = new ReplayExporter(&m_replayBuffer);
+        m_replayExporter->moveToThread(m_replayThread);
+        connect(this, &StreamManager::startReplayExport, m_replayExporter, &ReplayExporter::doExport);
+        connect(m_replayExporter, &ReplayExporter::exportFinished, this, &StreamManager::onReplayExportFinished);
+        connect(m_replayThread, &QThread::finished, m_replayExporter, &QObject::deleteLater);
+        m_replayThread->start();
+    }
+
+    m_isExporting = true;
+    emit exportChanged();
+    LOG_INFO(Stream, QString("Exporting %1 of replay (%2 s buffered) to %3")
+                    .arg(seconds > 0 ? QString("last %1 s").arg(seconds) : QString("all"))
+                    .arg(m_replayBuffer.bufferedDuration() / double(GST_SECOND), 0, 'f', 1)
+                    .arg(path));
+    emit startReplayExport(qint64(qMax(0, seconds)) * 1000, path, QString::fromUtf8(format.muxer));
+    return true;
+}
+
+void StreamManager::onReplayExportFinished(bool success, const QString &path, const QString &message)
+{
+    m_isExporting = false;
+    if (success) {
+        m_lastExportPath = path;
+        s_replayExports.inc();
+        LOG_INFO(Stream, QString("Replay exported: %1 (%2, %3 KB)")
+                        .arg(path, message).arg(QFileInfo(path).size() / 1024));
+    } else {
+        LOG_ERROR(Stream, QString("Replay export failed: %1").arg(message));
+    }
+    emit exportChanged();
+    emit exportFinished(success, path);
+}
+
+bool StreamManager::startTimeShift(int seconds)
+{
+    if (isTimeShifting() || m_timeShiftPending) {
+        return true;
+    }
+    if (!m_replayEnabled || !m_gstInitialized) {
+        LOG_WARNING(Stream, "Time-shift needs the replay buffer");
+        return false;
+    }
+
+    // Software decoding keeps the replay off the hardware decoder session the
+    // live branch is using, and needs no platform download step
+    DecoderInfo decoder = selectSoftwareDecoder();
+    if (decoder.priority < 0) {
+        LOG_INFO(Stream, "Time-shift: no software decoder available");
+        return false;
+    }
+
+    // Copying the snapshot can take a while for a long buffer; do it on the
+    // pool and build the replay pipeline back on this thread. A stop in the
+    // meantime bumps the generation and the snapshot is discarded.
+    m_timeShiftPending = true;
+    const int generation = ++m_timeShiftGeneration;
+    const GstClockTime duration = GstClockTime(qMax(0, seconds)) * GST_SECOND;
+    const QString element = decoder.elementName;
+    m_snapshotPool->start([this, generation, duration, element]() {
+        auto snapshot = std::make_shared<ReplaySnapshot>();
+        snapshot->units = m_replayBuffer.snapshot(duration, &snapshot->caps);
+        QMetaObject::invokeMethod(this, [this, generation, snapshot, element]() {
+            if (generation == m_timeShiftGeneration) {
+                m_timeShiftPending = false;
+                finishTimeShift(*snapshot, element);
+            }
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+void StreamManager::finishTimeShift(ReplaySnapshot &snapshot, const QString &decoderElement)
+{
+    if (!snapshot.units) {
+        LOG_WARNING(Stream, "Time-shift: replay buffer is empty");
+        return;
+    }
+
+    GstBufferList *units = std::exchange(snapshot.units, nullptr);
+    GstCaps *caps = std::exchange(snapshot.caps, nullptr);
+
+    // Timestamps start at zero and the sink syncs to the clock, so the
+    // snapshot plays back at its original pace
+    const QString description =
+        QString("appsrc name=replaysrc format=time max-bytes=0 ! h264parse ! %1 ! videoconvert ! "
+                "video/x-raw,format=(string){I420,NV12} ! "
+                "appsink name=replaysink sync=true max-buffers=2 drop=true")
+            .arg(decoderElement);
+
+    GError *error = nullptr;
+    m_replayPipeline = gst_parse_launch(description.toUtf8().constData(), &error);
+    if (!m_replayPipeline || error) {
+        LOG_ERROR(Stream, QString("Time-shift: failed to create replay pipeline: %1")
+                        .arg(error ? QString::fromUtf8(error->message) : QString("unknown error")));
+        if (error) g_error_free(error);
+        destroyReplayPipeline();
+        gst_buffer_list_unref(units);
+        if (caps) gst_caps_unref(caps);
+        return;
+    }
+
+    GstElement *source = gst_bin_get_by_name(GST_BIN(m_replayPipeline), "replaysrc");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(m_replayPipeline), "replaysink");
+    if (caps) {
+        g_object_set(source, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+    }
+
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = onReplaySample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, this, nullptr);
+    gst_object_unref(sink);
+
+    GstBus *bus = gst_element_get_bus(m_replayPipeline);
+    m_replayBusWatchId = gst_bus_add_watch(bus, onReplayBusMessage, this);
+    gst_object_unref(bus);
+
+    guint unitCount = gst_buffer_list_length(units);
+    gst_app_src_push_buffer_list(GST_APP_SRC(source), units);
+    gst_app_src_end_of_stream(GST_APP_SRC(source));
+    gst_object_unref(source);
+
+    if (gst_element_set_state(m_replayPipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        LOG_ERROR(Stream, "Time-shift: replay pipeline failed to start");
+        destroyReplayPipeline();
+        return;
+    }
+
+    m_timeShifting.store(true, std::memory_order_relaxed);
+    emit timeShiftChanged();
+    LOG_INFO(Stream, QString("Time-shift: replaying %1 access units through %2")
+                    .arg(unitCount).arg(decoderElement));
+}
+
+void StreamManager::stopTimeShift()
+{
+    if (m_timeShiftPending) {
+        // Discard the snapshot still being copied
+        m_timeShiftPending = false;
+        m_timeShiftGeneration++;
+    }
+    if (!m_replayPipeline && !isTimeShifting()) {
+        return;
+    }
+
+    destroyReplayPipeline();
+    m_timeShifting.store(false, std::memory_order_relaxed);
+    emit timeShiftChanged();
+    LOG_INFO(Stream, "Time-shift ended, back to live video");
+}
+
+void StreamManager::destroyReplayPipeline()
+{
+    if (m_replayBusWatchId != 0) {
+        g_source_remove(m_replayBusWatchId);
+        m_replayBusWatchId = 0;
+    }
+
+    if (m_replayPipeline) {
+        gst_element_set_state(m_replayPipeline, GST_STATE_NULL);
+        gst_object_unref(m_replayPipeline);
+        m_replayPipeline = nullptr;
+    }
+}
+
+void StreamManager::handleReplaySample(GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+    GstVideoInfo videoInfo;
+    if (!buffer || !caps || !gst_video_info_from_caps(&videoInfo, caps)) {
+        return;
+    }
+
+    QImage frame = convertYuvFrame(buffer, &videoInfo, m_rotate);
+    if (!frame.isNull()) {
+        m_imageProvider->updateFrame(frame);
+        emit frameReady();
+    }
+}
+
+// GStreamer pad probe: parser output entering the tee (streaming thread)
+GstPadProbeReturn StreamManager::onParsedData(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+        self->m_replayBuffer.push(GST_PAD_PROBE_INFO_BUFFER(info));
+    } else if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_CAPS) {
+        GstCaps *caps = nullptr;
+        gst_event_parse_caps(GST_PAD_PROBE_INFO_EVENT(info), &caps);
+        self->m_replayBuffer.setCaps(caps);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// GStreamer callback: decoded replay frame (replay streaming thread)
+GstFlowReturn StreamManager::onReplaySample(GstAppSink *sink, gpointer userData)
+{
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (sample) {
+        self->handleReplaySample(sample);
+        gst_sample_unref(sample);
+    }
+    return GST_FLOW_OK;
+}
+
+gboolean StreamManager::onReplayBusMessage(GstBus *bus, GstMessage *message, gpointer userData)
+{
+    Q_UNUSED(bus);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR) {
+        GError *error = nullptr;
+        gst_message_parse_error(message, &error, nullptr);
+        LOG_ERROR(Stream, QString("Time-shift error: %1")
+                        .arg(error ? QString::fromUtf8(error->message) : QString("unknown error")));
+        if (error) g_error_free(error);
+    } else if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_EOS) {
+        return TRUE;
+    }
+
+    // End of the snapshot (or a failure): return to live outside the bus dispatch
+    QMetaObject::invokeMethod(self, &StreamManager::stopTimeShift, Qt::QueuedConnection);
+    return TRUE;
+}
+
+// ============ Snapshots ============
+
+bool StreamManager::captureSnapshot(bool fullResolution)
+{
+    int pending = m_pendingSnapshots.load(std::memory_order_relaxed);
+    if (pending >= kMaxPendingSnapshots) {
+        LOG_WARNING(Stream, QString("Snapshot skipped: %1 still being encoded").arg(pending));
+        return false;
+    }
+
+    // The pre-scale frame only exists in the live pipeline
+    if (fullResolution && m_pipeline && !isTimeShifting()) {
+        // Requests made before the next frame arrives share it
+        if (!m_fullResRequested.exchange(true)) {
+            m_pendingSnapshots.fetch_add(1);
+        }
+        return true;
+    }
+
+    QImage frame = m_imageProvider->currentFrame();
+    if (frame.isNull()) {
+        LOG_WARNING(Stream, "Snapshot skipped: no frame received yet");
+        return false;
+    }
+
+    m_pendingSnapshots.fetch_add(1);
+    queueSnapshot(frame, SamplePtr(), 0);
+    return true;
+}
+
+QString StreamManager::snapshotPath() const
+{
+    QDir directory(m_recordingDirectory);
+    if (m_recordingDirectory.isEmpty() || !directory.mkpath(".")) {
+        LOG_WARNING(Stream, QString("Recording directory is not usable: '%1'").arg(m_recordingDirectory));
+        return QString();
+    }
+
+    // Milliseconds in the name keep bursts from overwriting each other
+    return directory.absoluteFilePath(
+        QString("F1sh_snapshot_%1_%2.%3").arg(m_port)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz"),
+                 QString::fromUtf8(kSnapshotFormats[m_snapshotFormat].extension)));
+}
+
+void StreamManager::queueSnapshot(const QImage &image, SamplePtr sample, int rotate)
+{
+    const QString path = snapshotPath();
+    if (path.isEmpty()) {
+        m_pendingSnapshots.fetch_sub(1);
+        emit snapshotSaved(false, QString());
+        return;
+    }
+
+    const QByteArray format = kSnapshotFormats[m_snapshotFormat].format;
+    const int quality = kSnapshotFormats[m_snapshotFormat].quality;
+
+    // The displayed QImage is shared, not copied, and a full-resolution sample
+    // only holds a reference to the decoder's buffer until it is converted
+    m_snapshotPool->start([this, image, sample = std::move(sample), rotate, path, format, quality]() mutable {
+        QElapsedTimer timer;
+        timer.start();
+
+        QImage frame = image;
+        if (sample) {
+            frame = sampleToImage(sample.get(), rotate);
+            sample.reset();
+        }
+
+        bool ok = !frame.isNull() && frame.save(path, format.constData(), quality);
+        s_snapshotEncode.observeMs(timer.elapsed());
+        if (ok) {
+            s_snapshots.inc();
+        }
+
+        QSize size = frame.size();
+        QMetaObject::invokeMethod(this, [this, ok, path, size]() {
+            m_pendingSnapshots.fetch_sub(1);
+            if (ok) {
+                LOG_INFO(Stream, QString("Snapshot saved: %1 (%2x%3)").arg(path).arg(size.width()).arg(size.height()));
+            } else {
+                LOG_WARNING(Stream, QString("Snapshot failed: %1").arg(path));
+            }
+            emit snapshotSaved(ok, path);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QImage StreamManager::sampleToImage(GstSample *sample, int rotate)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+    GstVideoInfo videoInfo;
+    if (!buffer || !caps || !gst_video_info_from_caps(&videoInfo, caps)) {
+        return QImage();
+    }
+
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&videoInfo);
+    if (format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_NV12) {
+        return convertYuvFrame(buffer, &videoInfo, rotate);
+    }
+
+    // Other decoder output formats: let GStreamer convert, then rotate here
+    GstCaps *rgbCaps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING, "RGBx", nullptr);
+    GError *error = nullptr;
+    GstSample *converted = gst_video_convert_sample(sample, rgbCaps, 5 * GST_SECOND, &error);
+    gst_caps_unref(rgbCaps);
+    if (!converted) {
+        LOG_WARNING(Stream, QString("Snapshot conversion failed: %1")
+                        .arg(error ? QString::fromUtf8(error->message) : QString("unknown error")));
+        if (error) g_error_free(error);
+        return QImage();
+    }
+
+    QImage image;
+    GstVideoInfo rgbInfo;
+    GstMapInfo mapInfo;
+    GstBuffer *rgbBuffer = gst_sample_get_buffer(converted);
+    if (gst_video_info_from_caps(&rgbInfo, gst_sample_get_caps(converted))
+        && gst_buffer_map(rgbBuffer, &mapInfo, GST_MAP_READ)) {
+        image = QImage(mapInfo.data, rgbInfo.width, rgbInfo.height,
+                       GST_VIDEO_INFO_PLANE_STRIDE(&rgbInfo, 0), QImage::Format_RGBX8888).copy();
+        gst_buffer_unmap(rgbBuffer, &mapInfo);
+    }
+    gst_sample_unref(converted);
+
+    if (!image.isNull() && rotate > 0 && rotate < 4) {
+        image = image.transformed(QTransform().rotate(90.0 * rotate));
+    }
+    return image;
+}
+
+// GStreamer pad probe: decoded frame entering the scaler (streaming thread)
+GstPadProbeReturn StreamManager::onDecodedFrame(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    if (!self->m_fullResRequested.load(std::memory_order_relaxed)
+        || !self->m_fullResRequested.exchange(false)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    // The sample references the buffer; no pixels are copied here
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    SamplePtr sample(gst_sample_new(GST_PAD_PROBE_INFO_BUFFER(info), caps, nullptr, nullptr), gst_sample_unref);
+    if (caps) gst_caps_unref(caps);
+
+    int rotate = self->m_rotate;
+    QMetaObject::invokeMethod(self, [self, sample, rotate]() {
+        self->queueSnapshot(QImage(), sample, rotate);
+    }, Qt::QueuedConnection);
+    return GST_PAD_PROBE_OK;
+}
+
+void StreamManager::resetRtpStats()
+{
+    m_rtpHaveLast = false;
+    m_rtpLastSeq = 0;
+    m_rtpLastTimestamp = 0;
+    m_rtpLastArrival = 0;
+    m_rtpJitter = 0.0;
+    s_rtpJitter.set(0.0);
+}
+
+// GStreamer callback: new video sample available
+GstFlowReturn StreamManager::onNewSample(GstAppSink *sink, gpointer userData)
+{
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample) {
+        return GST_FLOW_OK;
+    }
+    self->m_samplesPulled.fetch_add(1, std::memory_order_relaxed);
+
+    self->handleSample(sample, true);
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+// GStreamer callback: buffers entering the decoder
+GstPadProbeReturn StreamManager::onDecoderInput(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    bool keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    if (self->m_lowPower.load(std::memory_order_relaxed)) {
+        // Delta frames would reference pictures we skipped, so resume only at a keyframe
+        self->m_awaitingKeyframe = true;
+    } else if (self->m_awaitingKeyframe && keyframe) {
+        self->m_awaitingKeyframe = false;
+    }
+
+    if (self->m_awaitingKeyframe && !keyframe) {
+        s_lowPowerSkipped.inc();
+        return GST_PAD_PROBE_DROP;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// GStreamer callback: bus messages
+gboolean StreamManager::onBusMessage(GstBus *bus, GstMessage *message, gpointer userData)
+{
+    Q_UNUSED(bus);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    switch (GST_MESSAGE_TYPE(message)) {
+        case GST_MESSAGE_ERROR: {
+            GError *error = nullptr;
+            gchar *debug = nullptr;
+            gst_message_parse_error(message, &error, &debug);
+
+            QString errorMsg = error ? QString::fromUtf8(error->message) : "Unknown error";
+            LOG_AT_RATE(Stream, Error, 1.0, 10, QString("GStreamer: %1").arg(errorMsg));
+            if (error && g_error_matches(error, GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE)) {
+                self->countDecodeError();
+            }
+            if (debug) {
+                LOG_AT_RATE(Stream, Debug, 1.0, 10, QString("GStreamer debug info: %1").arg(QString::fromUtf8(debug)));
+            }
+
+            // Errors queued by elements already swapped out of the pipeline are
+            // stale, and a decoder failure also makes udpsrc report the failed
+            // push; the failover restarts udpsrc, so neither needs handling
+            GstObject *source = GST_MESSAGE_SRC(message);
+
+            // A failing recording (disk full, unwritable path) ends the recording, not the stream
+            if (self->m_recordBin && (source == GST_OBJECT(self->m_recordBin)
+                                      || gst_object_has_as_ancestor(source, GST_OBJECT(self->m_recordBin)))) {
+                LOG_ERROR(Stream, QString("Recording failed: %1").arg(errorMsg));
+                self->stopRecording();
+                if (error) g_error_free(error);
+                if (debug) g_free(debug);
+                break;
+            }
+
+            bool stale = self->m_pipeline && source != GST_OBJECT(self->m_pipeline)
+                         && !gst_object_has_as_ancestor(source, GST_OBJECT(self->m_pipeline));
+            if (stale || (self->inFailoverGrace() && !self->isDecoderChainElement(source))) {
+                LOG_INFO(Stream, "Ignoring error raised by the decoder failover");
+                if (error) g_error_free(error);
+                if (debug) g_free(debug);
+                break;
+            }
+
+            self->setStatus(QString("Error: %1").arg(errorMsg));
+            emit self->errorOccurred(errorMsg);
+
+            // A failing hardware decoder is replaced in place; anything else
+            // won't come back by itself, so go straight to a rebuild
+            if (self->m_isStreaming && self->isDecoderChainElement(source)
+                && self->startDecoderFailover(errorMsg)) {
+                // Failover in progress
+            } else if (self->m_isStreaming && self->m_recoveryStage != RecoveryStage::Rebuilding) {
+                self->beginRecovery(QString("pipeline error: %1").arg(errorMsg), RecoveryStage::Rebuilding);
+            }
+
+            if (error) g_error_free(error);
+            if (debug) g_free(debug);
+            break;
+        }
+
+        case GST_MESSAGE_EOS:
+            // Unlinking the old decoder can push EOS through the live branch;
+            // the swap owns recovery until its grace period is over
+            if (self->inFailoverGrace()) {
+                LOG_INFO(Stream, "Ignoring end of stream raised by the decoder failover");
+                break;
+            }
+            LOG_INFO(Stream, "End of stream");
+            self->setStatus("Stream ended");
+            if (self->m_isStreaming && self->m_recoveryStage != RecoveryStage::Rebuilding) {
+                self->beginRecovery("end of stream", RecoveryStage::Rebuilding);
+            }
+            break;
+
+        case GST_MESSAGE_STATE_CHANGED: {
+            if (GST_MESSAGE_SRC(message) == GST_OBJECT(self->m_pipeline)) {
+                GstState oldState, newState;
+                gst_message_parse_state_changed(message, &oldState, &newState, nullptr);
+                if (Trace::isEnabled()) {
+                    char detail[40];
+                    std::snprintf(detail, sizeof(detail), "%s -> %s",
+                              gst_element_state_get_name(oldState), gst_element_state_get_name(newState));
+                    Trace::instant("pipeline", "state", detail);
+                }
+                LOG_DEBUG(Stream, QString("Pipeline state: %1 -> %2")
+                               .arg(QString::fromUtf8(gst_element_state_get_name(oldState)),
+                                    QString::fromUtf8(gst_element_state_get_name(newState))));
+
+                if (newState == GST_STATE_PLAYING && self->m_recoveryStage == RecoveryStage::Healthy) {
+                    self->setStatus(QString("Streaming (%1)").arg(self->m_currentDecoder));
+                }
+            }
+            break;
+        }
+
+        case GST_MESSAGE_WARNING: {
+            GError *warning = nullptr;
+            gchar *debug = nullptr;
+            gst_message_parse_warning(message, &warning, &debug);
+
+            if (warning) {
+                // Decoders report corrupt/undecodable frames as stream warnings
+                if (g_error_matches(warning, GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE)) {
+                    self->countDecodeError();
+                }
+                // A lossy network can raise these for every frame
+                LOG_AT_RATE(Stream, Warning, 1.0, 5, QString("GStreamer: %1").arg(QString::fromUtf8(warning->message)));
+                g_error_free(warning);
+            }
+            if (debug) g_free(debug);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return TRUE;
+}
+
+// GStreamer pad probe: RTP packet entering the depayloader (streaming thread)
+GstPadProbeReturn StreamManager::onRtpPacket(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!buffer) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    guint16 seq = gst_rtp_buffer_get_seq(&rtp);
+    guint32 timestamp = gst_rtp_buffer_get_timestamp(&rtp);
+    gst_rtp_buffer_unmap(&rtp);
+
+    s_rtpPackets.inc();
+
+    gint64 arrival = g_get_monotonic_time() * 9 / 100;  // microseconds -> 90 kHz
+
+    if (self->m_rtpHaveLast) {
+        // Duplicates and packets slightly behind are ignored; small forward
+        // gaps are losses. Any other jump is a sender restart: resync to it
+        // without counting loss or taking a jitter sample.
+        guint16 gap = static_cast<guint16>(seq - self->m_rtpLastSeq);
+        if (gap == 0 || gap > 0xFFFF - kRtpMaxMisorder) {
+            return GST_PAD_PROBE_OK;
+        }
+        if (gap < kRtpMaxDropout) {
+            if (gap > 1) {
+                s_rtpLost.inc(gap - 1);
+            }
+
+            // RFC 3550 section 6.4.1 interarrival jitter
+            gint64 transitDelta = (arrival - self->m_rtpLastArrival)
+                                - static_cast<gint32>(timestamp - self->m_rtpLastTimestamp);
+            self->m_rtpJitter += (std::abs(static_cast<double>(transitDelta)) - self->m_rtpJitter) / 16.0;
+            s_rtpJitter.set(self->m_rtpJitter / kRtpClockRate);
+        }
+    }
+
+    self->m_rtpHaveLast = true;
+    self->m_rtpLastSeq = seq;
+    self->m_rtpLastTimestamp = timestamp;
+    self->m_rtpLastArrival = arrival;
+
+    return GST_PAD_PROBE_OK;
+}
+
+// GStreamer pad probe: buffer arriving at the appsink (streaming thread)
+GstPadProbeReturn StreamManager::onAppSinkBuffer(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+{
+    Q_UNUSED(pad);
+    Q_UNUSED(info);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+    self->m_appSinkBuffersIn.fetch_add(1, std::memory_order_relaxed);
+    return GST_PAD_PROBE_OK;
+}
+
+// GStreamer signal: leaky queue is full and about to drop a buffer
+void StreamManager::onQueueOverrun(GstElement *queue, gpointer userData)
+{
+    Q_UNUSED(queue);
+    StreamManager *self = static_cast<StreamManager*>(userData);
+    self->m_queueLeaks.fetch_add(1, std::memory_order_relaxed);
+    s_framesDroppedQueue.inc();
 }
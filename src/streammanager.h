@@ -6,8 +6,15 @@
 #include <QQuickImageProvider>
 #include <QMutex>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+#include <atomic>
+#include <memory>
+#include "replaybuffer.h"
 
 // Forward declarations
 class StreamManager;
@@ -19,10 +26,17 @@ public:
     VideoFrameProvider();
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
     void updateFrame(const QImage &frame);
+    // Newest frame; shares the pixel data rather than copying it
+    QImage currentFrame();
+
+    // Frames replaced before QML requested them (cumulative)
+    quint64 supersededCount() const { return m_superseded.load(std::memory_order_relaxed); }
 
 private:
     QImage m_currentFrame;
     QMutex m_mutex;
+    bool m_frameConsumed = true;
+    std::atomic<quint64> m_superseded{0};
 };
 
 // Decoder info structure
@@ -43,6 +57,61 @@ class StreamManager : public QObject
     Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
     Q_PROPERTY(int rotate READ rotate WRITE setRotate NOTIFY rotateChanged)
     Q_PROPERTY(QStringList availableDecoders READ availableDecoders NOTIFY availableDecodersChanged)
+    Q_PROPERTY(bool fusedConversion READ fusedConversion WRITE setFusedConversion NOTIFY fusedConversionChanged)
+    // Display size in device pixels; frames are scaled down to fit it before conversion
+    Q_PROPERTY(QSize viewportSize READ viewportSize WRITE setViewportSize NOTIFY viewportSizeChanged)
+    // Keyframe-only decoding while the video is not visible; the UDP session stays up
+    Q_PROPERTY(bool lowPower READ lowPower WRITE setLowPower NOTIFY lowPowerChanged)
+    // Decoder tuning: 0 = lowest latency, 1 = highest throughput
+    Q_PROPERTY(int decoderProfile READ decoderProfile WRITE setDecoderProfile NOTIFY decoderProfileChanged)
+    Q_PROPERTY(QStringList decoderProfileOptions READ decoderProfileOptions CONSTANT)
+
+    // Transport: index into transportOptions; 0 (auto) follows discoveredProtocol
+    Q_PROPERTY(int transportIndex READ transportIndex WRITE setTransportIndex NOTIFY transportChanged)
+    Q_PROPERTY(QStringList transportOptions READ transportOptions CONSTANT)
+    Q_PROPERTY(QString discoveredProtocol READ discoveredProtocol WRITE setDiscoveredProtocol NOTIFY transportChanged)
+    Q_PROPERTY(QString activeTransport READ activeTransport NOTIFY transportChanged)
+    Q_PROPERTY(QString host READ host WRITE setHost NOTIFY hostChanged)
+    Q_PROPERTY(int transportLatency READ transportLatency WRITE setTransportLatency NOTIFY transportLatencyChanged)
+    // RTP/UDP only: join this group (empty = unicast) on the given interface (empty = default)
+    Q_PROPERTY(QString multicastGroup READ multicastGroup WRITE setMulticastGroup NOTIFY multicastChanged)
+    Q_PROPERTY(QString multicastInterface READ multicastInterface WRITE setMulticastInterface NOTIFY multicastChanged)
+    // Upper bound for software decoder threads (0 = decoder default), applied on the next pipeline build
+    Q_PROPERTY(int decoderThreads READ decoderThreads WRITE setDecoderThreads NOTIFY decoderThreadsChanged)
+    // Frame-rate budget for delivery to QML (0 = every frame); excess frames skip conversion
+    Q_PROPERTY(int maxFrameRate READ maxFrameRate WRITE setMaxFrameRate NOTIFY maxFrameRateChanged)
+
+    // Recording of the encoded stream (no transcode) from a tee after h264parse
+    Q_PROPERTY(bool isRecording READ isRecording NOTIFY recordingChanged)
+    Q_PROPERTY(QString recordingPath READ recordingPath NOTIFY recordingChanged)
+    Q_PROPERTY(int recordingFormat READ recordingFormat WRITE setRecordingFormat NOTIFY recordingFormatChanged)
+    Q_PROPERTY(QStringList recordingFormatOptions READ recordingFormatOptions CONSTANT)
+    Q_PROPERTY(QString recordingDirectory READ recordingDirectory WRITE setRecordingDirectory NOTIFY recordingDirectoryChanged)
+
+    // Instant replay: the last replaySeconds of encoded video kept in a fixed-size memory buffer.
+    // replayMemoryLimit caps all streams together; each enabled stream gets an equal share.
+    Q_PROPERTY(bool replayEnabled READ replayEnabled WRITE setReplayEnabled NOTIFY replayChanged)
+    Q_PROPERTY(int replaySeconds READ replaySeconds WRITE setReplaySeconds NOTIFY replayChanged)
+    Q_PROPERTY(int replayMemoryLimit READ replayMemoryLimit WRITE setReplayMemoryLimit NOTIFY replayChanged)
+    Q_PROPERTY(double replayBufferedSeconds READ replayBufferedSeconds NOTIFY replayStatsChanged)
+    Q_PROPERTY(qint64 replayMemoryUsed READ replayMemoryUsed NOTIFY replayStatsChanged)
+    Q_PROPERTY(qint64 replayMemoryAllocated READ replayMemoryAllocated NOTIFY replayStatsChanged)
+    Q_PROPERTY(bool isExporting READ isExporting NOTIFY exportChanged)
+    Q_PROPERTY(QString lastExportPath READ lastExportPath NOTIFY exportChanged)
+    Q_PROPERTY(bool isTimeShifting READ isTimeShifting NOTIFY timeShiftChanged)
+
+    // Stills: encoded off the GUI thread, saved to recordingDirectory
+    Q_PROPERTY(int snapshotFormat READ snapshotFormat WRITE setSnapshotFormat NOTIFY snapshotSettingsChanged)
+    Q_PROPERTY(QStringList snapshotFormatOptions READ snapshotFormatOptions CONSTANT)
+    Q_PROPERTY(bool snapshotFullResolution READ snapshotFullResolution WRITE setSnapshotFullResolution NOTIFY snapshotSettingsChanged)
+
+    // Per-session statistics, refreshed once per second while streaming
+    Q_PROPERTY(double fps READ fps NOTIFY streamStatsChanged)
+    Q_PROPERTY(qint64 droppedQueue READ droppedQueue NOTIFY streamStatsChanged)
+    Q_PROPERTY(qint64 droppedAppsink READ droppedAppsink NOTIFY streamStatsChanged)
+    Q_PROPERTY(qint64 droppedSuperseded READ droppedSuperseded NOTIFY streamStatsChanged)
+    Q_PROPERTY(qint64 droppedDecodeError READ droppedDecodeError NOTIFY streamStatsChanged)
+    Q_PROPERTY(qint64 droppedTotal READ droppedTotal NOTIFY streamStatsChanged)
 
 public:
     explicit StreamManager(QObject *parent = nullptr);
@@ -53,13 +122,84 @@ public:
     QString currentDecoder() const { return m_currentDecoder; }
     int port() const { return m_port; }
     int rotate() const { return m_rotate; }
+    bool fusedConversion() const { return m_fusedConversion; }
+    QSize viewportSize() const { return m_viewportSize; }
+    bool lowPower() const { return m_lowPower.load(std::memory_order_relaxed); }
+    int decoderProfile() const { return m_decoderProfile; }
+    QStringList decoderProfileOptions() const;
+    int transportIndex() const { return m_transportIndex; }
+    QStringList transportOptions() const;
+    QString discoveredProtocol() const { return m_discoveredProtocol; }
+    QString activeTransport() const;
+    QString host() const { return m_host; }
+    int transportLatency() const { return m_transportLatency; }
+    QString multicastGroup() const { return m_multicastGroup; }
+    QString multicastInterface() const { return m_multicastInterface; }
+    int decoderThreads() const { return m_decoderThreads; }
+    int maxFrameRate() const { return m_maxFrameRate.load(std::memory_order_relaxed); }
+    bool isRecording() const { return m_isRecording; }
+    QString recordingPath() const { return m_recordingPath; }
+    int recordingFormat() const { return m_recordingFormat; }
+    QStringList recordingFormatOptions() const;
+    QString recordingDirectory() const { return m_recordingDirectory; }
+    bool replayEnabled() const { return m_replayEnabled; }
+    int replaySeconds() const { return m_replaySeconds; }
+    int replayMemoryLimit() const { return m_replayMemoryLimit; }
+    double replayBufferedSeconds() const { return m_replayBufferedSeconds; }
+    qint64 replayMemoryUsed() const { return m_replayMemoryUsed; }
+    qint64 replayMemoryAllocated() const { return m_replayMemoryAllocated; }
+    bool isExporting() const { return m_isExporting; }
+    QString lastExportPath() const { return m_lastExportPath; }
+    bool isTimeShifting() const { return m_timeShifting.load(std::memory_order_relaxed); }
+    int snapshotFormat() const { return m_snapshotFormat; }
+    QStringList snapshotFormatOptions() const;
+    bool snapshotFullResolution() const { return m_snapshotFullResolution; }
     QStringList availableDecoders() const;
 
+    double fps() const { return m_fps; }
+    qint64 droppedQueue() const { return m_droppedQueue; }
+    qint64 droppedAppsink() const { return m_droppedAppsink; }
+    qint64 droppedSuperseded() const { return m_droppedSuperseded; }
+    qint64 droppedDecodeError() const { return m_droppedDecodeError; }
+    qint64 droppedTotal() const
+    {
+        return m_droppedQueue + m_droppedAppsink + m_droppedSuperseded + m_droppedDecodeError;
+    }
+
     void setPort(int port);
     void setRotate(int rotate);
+    void setFusedConversion(bool enabled);
+    void setViewportSize(const QSize &size);
+    void setLowPower(bool enabled);
+    void setDecoderProfile(int profile);
+    void setTransportIndex(int index);
+    void setDiscoveredProtocol(const QString &protocol);
+    void setHost(const QString &host);
+    void setTransportLatency(int latencyMs);
+    void setMulticastGroup(const QString &group);
+    void setMulticastInterface(const QString &iface);
+    void setDecoderThreads(int threads);
+    void setMaxFrameRate(int fps);
+    void setRecordingFormat(int format);
+    void setRecordingDirectory(const QString &directory);
+    void setReplayEnabled(bool enabled);
+    void setReplaySeconds(int seconds);
+    void setReplayMemoryLimit(int megabytes);
+    void setSnapshotFormat(int format);
+    void setSnapshotFullResolution(bool enabled);
 
     Q_INVOKABLE void start();
     Q_INVOKABLE void stop();
+    Q_INVOKABLE bool startRecording();
+    Q_INVOKABLE void stopRecording();
+    // Mux the newest `seconds` (0 = all) of the replay buffer to a file on a background thread
+    Q_INVOKABLE bool exportReplay(int seconds);
+    // Show the newest `seconds` of the replay buffer through a second decoder instead of live video
+    Q_INVOKABLE bool startTimeShift(int seconds);
+    Q_INVOKABLE void stopTimeShift();
+    // Saves a still without blocking; the result arrives through snapshotSaved().
+    // fullResolution takes the next decoded frame before scaling instead of the displayed one.
+    Q_INVOKABLE bool captureSnapshot(bool fullResolution = false);
     Q_INVOKABLE void detectDecoders();
     Q_INVOKABLE void setPreferredDecoder(const QString &decoderName);
 
@@ -72,7 +212,29 @@ signals:
     void currentDecoderChanged();
     void portChanged();
     void rotateChanged();
+    void fusedConversionChanged();
+    void viewportSizeChanged();
+    void lowPowerChanged();
+    void decoderProfileChanged();
+    void transportChanged();
+    void hostChanged();
+    void transportLatencyChanged();
+    void multicastChanged();
+    void decoderThreadsChanged();
+    void maxFrameRateChanged();
+    void recordingChanged();
+    void recordingFormatChanged();
+    void recordingDirectoryChanged();
+    void replayChanged();
+    void replayStatsChanged();
+    void exportChanged();
+    void exportFinished(bool success, const QString &path);
+    void timeShiftChanged();
+    void startReplayExport(qint64 durationMs, const QString &path, const QString &muxer);
+    void snapshotSettingsChanged();
+    void snapshotSaved(bool success, const QString &path);
     void availableDecodersChanged();
+    void streamStatsChanged();
     void frameReady();
     void errorOccurred(const QString &error);
 
@@ -81,13 +243,95 @@ private:
     bool createPipeline();
     void destroyPipeline();
     QString buildPipelineString();
+    QString buildSourceString(const QString &transport) const;
+    QString resolveTransport() const;
+    void restartIfStreaming();
+    void appendRotationElements(QString &pipeline);
+    void applyDecoderTuning(GstElement *decoder, const QString &elementName);
     DecoderInfo selectBestDecoder();
+    DecoderInfo selectSoftwareDecoder() const;
     void setStatus(const QString &status);
     void pollForFrames();
+    void handleSample(GstSample *sample, bool fromCallback);
+    static QImage convertYuvFrame(GstBuffer *buffer, GstVideoInfo *videoInfo, int rotate);
+    void recordFrameMetrics(GstBuffer *buffer);
+    void updateStreamStats();
+    void publishFps(double fps);
+    void resetRtpStats();
+    void resetDropStats();
+    void countDecodeError();
+
+    // Watchdog: stall/error detection and staged recovery
+    enum class RecoveryStage {
+        Healthy,
+        Flushed,            // Flushed the pipeline, waiting for frames
+        KeyframeRequested,  // Asked upstream for a keyframe, waiting for frames
+        Rebuilding          // Rebuilding the pipeline with exponential backoff
+    };
+    void checkStreamHealth();
+    void beginRecovery(const QString &reason, RecoveryStage stage);
+    void flushPipeline();
+    void requestKeyframe();
+    bool rebuildPipeline();
+
+    // Mid-stream hardware -> software decoder swap
+    bool isDecoderChainElement(GstObject *object) const;
+    // A decoder swap is pending or finished less than kFailoverGraceMs ago
+    bool inFailoverGrace() const;
+    bool startDecoderFailover(const QString &reason);
+    bool swapDecoder();
+    void finishDecoderFailover(bool success);
+    void applyViewportScale();
+    QSize scaledSizeFor(const QSize &source) const;
+
+    // Recording branch: attached to / detached from the tee while playing
+    void onRecordingDetached(GstPad *teePad);
+    void finishRecording();
+    void releaseRecording();
+
+    // Replay buffer export and time-shift playback
+    void applyReplayBuffer();
+    void allocateReplayBuffer();
+    void updateReplayStats();
+    void onReplayExportFinished(bool success, const QString &path, const QString &message);
+    // Owns whatever a time-shift snapshot produced until the replay pipeline takes it
+    struct ReplaySnapshot {
+        GstBufferList *units = nullptr;
+        GstCaps *caps = nullptr;
+        ~ReplaySnapshot()
+        {
+            if (units) gst_buffer_list_unref(units);
+            if (caps) gst_caps_unref(caps);
+        }
+    };
+    void finishTimeShift(ReplaySnapshot &snapshot, const QString &decoderElement);
+    void handleReplaySample(GstSample *sample);
+    void destroyReplayPipeline();
+
+    // Snapshots: encoding jobs on m_snapshotPool
+    QString snapshotPath() const;
+    // The sample, if any, is released with the last copy of the pointer, so
+    // a queued call dropped with its receiver does not leak the frame
+    using SamplePtr = std::shared_ptr<GstSample>;
+    void queueSnapshot(const QImage &image, SamplePtr sample, int rotate);
+    static QImage sampleToImage(GstSample *sample, int rotate);
 
     // GStreamer callbacks
     static GstFlowReturn onNewSample(GstAppSink *sink, gpointer userData);
     static gboolean onBusMessage(GstBus *bus, GstMessage *message, gpointer userData);
+    static GstPadProbeReturn onRtpPacket(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onAppSinkBuffer(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onDecoderInput(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onParserIdle(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onRecordBuffer(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static void freeRecordProbe(gpointer data);
+    static GstPadProbeReturn onRecordTeeIdle(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onRecordSinkEvent(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstPadProbeReturn onParsedData(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static GstFlowReturn onReplaySample(GstAppSink *sink, gpointer userData);
+    static gboolean onReplayBusMessage(GstBus *bus, GstMessage *message, gpointer userData);
+    static GstPadProbeReturn onDecodedFrame(GstPad *pad, GstPadProbeInfo *info, gpointer userData);
+    static void onQueueOverrun(GstElement *queue, gpointer userData);
 
     bool m_isStreaming = false;
     bool m_gstInitialized = false;
@@ -98,14 +342,118 @@ private:
     QString m_preferredDecoder;
     int m_port = 8888;
     int m_rotate = 0;
+    int m_pipelineRotate = 0;        // Rotation applied by the fused converter
+    bool m_fusedConversion = true;   // Convert/rotate in ColorConvert instead of GStreamer
+    QSize m_viewportSize;            // Empty = no scaling
+    QSize m_scaledSize;              // Size currently forced on the scaler, invalid = none yet
+    std::atomic<bool> m_lowPower{false};
+    bool m_awaitingKeyframe = false; // Decoder input thread only: resume on the next keyframe
+    int m_decoderProfile = 0;
+    QString m_decoderElement;        // Element name of the decoder in the current pipeline
+    int m_transportIndex = 0;
+    QString m_discoveredProtocol = "udp";
+    QString m_host;                  // Camera address for client-side transports (tcp/rtsp/srt)
+    int m_transportLatency = 50;     // Jitter/receive buffer in ms for rtsp/srt
+    QString m_multicastGroup;
+    QString m_multicastInterface;
+    int m_decoderThreads = 0;
+    std::atomic<int> m_maxFrameRate{0};
+    std::atomic<qint64> m_lastDeliveredMs{0};
+
+    // Recording state (GUI thread; m_recordAwaitKeyframe is cleared on the streaming thread)
+    bool m_isRecording = false;
+    QString m_recordingPath;
+    int m_recordingFormat = 0;
+    QString m_recordingDirectory;
+    GstElement *m_recordBin = nullptr;   // queue ! h264parse ! mux ! filesink, owned by the pipeline
+    GstPad *m_recordTeePad = nullptr;    // Requested tee pad, null once detached
+    int m_recordGeneration = 0;          // Tells a stale finalize timeout apart from a newer recording
+    std::atomic<bool> m_recordAwaitKeyframe{false};
+    std::atomic<bool> m_recordOverrun{false};  // Dropping a GOP because the queue is full (streaming thread)
+
+    // User data of the recording tee-pad probe; holds its own ref on the queue
+    struct RecordProbe {
+        StreamManager *self;
+        GstElement *queue;
+    };
+
+    // Replay buffer (filled on the streaming thread, see EncodedRingBuffer)
+    EncodedRingBuffer m_replayBuffer;
+    bool m_replayEnabled = false;
+    int m_replaySeconds = 30;
+    int m_replayMemoryLimit = 64;        // MB, shared by every stream with replay enabled
+    int m_replayUnits = 0;               // Index size of the current allocation
+    double m_replayBufferedSeconds = 0.0;
+    qint64 m_replayMemoryUsed = 0;
+    qint64 m_replayMemoryAllocated = 0;
+    QThread *m_replayThread = nullptr;   // Started on the first export
+    ReplayExporter *m_replayExporter = nullptr;
+    bool m_isExporting = false;
+    QString m_lastExportPath;
+    GstElement *m_replayPipeline = nullptr;
+    guint m_replayBusWatchId = 0;
+    std::atomic<bool> m_timeShifting{false};
+    bool m_timeShiftPending = false;     // Snapshot being copied on the pool (GUI thread)
+    int m_timeShiftGeneration = 0;
+
+    // Snapshots
+    QThreadPool *m_snapshotPool = nullptr;
+    int m_snapshotFormat = 0;
+    bool m_snapshotFullResolution = false;
+    std::atomic<int> m_pendingSnapshots{0};
+    std::atomic<bool> m_fullResRequested{false};  // Cleared by the scaler probe when it takes a frame
 
     GstElement *m_pipeline = nullptr;
     GstElement *m_appSink = nullptr;
+    GstElement *m_scaleCaps = nullptr;  // capsfilter after videoscale, updated on resize
     guint m_busWatchId = 0;
 
     QList<DecoderInfo> m_decoders;
     VideoFrameProvider *m_imageProvider = nullptr;
     QTimer *m_frameTimer = nullptr;
+    QTimer *m_scaleTimer = nullptr;     // Debounces viewport resizes
+
+    // Watchdog state (GUI thread, except m_lastFrameMs which streaming threads write)
+    QTimer *m_watchdogTimer = nullptr;
+    QElapsedTimer m_sessionClock;
+    std::atomic<qint64> m_lastFrameMs{0};
+    RecoveryStage m_recoveryStage = RecoveryStage::Healthy;
+    qint64 m_outageStartMs = 0;     // Time of the last frame before the stall
+    qint64 m_recoveryStartMs = 0;   // When recovery began; frames after this mean recovered
+    qint64 m_stageStartMs = 0;
+    qint64 m_nextRestartMs = 0;
+    int m_restartAttempt = 0;
+
+    DecoderInfo m_failoverDecoder;    // Software decoder being swapped in
+    bool m_failoverPending = false;
+    qint64 m_lastFailoverMs = -1;     // Session time of the last failover start
+
+    // Stream statistics (fps gauge is refreshed once per second)
+    QTimer *m_statsTimer = nullptr;
+    QElapsedTimer m_statsElapsed;
+    std::atomic<quint64> m_framesDelivered{0};  // This stream only; s_framesDecoded counts all of them
+    quint64 m_statsLastFrames = 0;
+    double m_fps = 0.0;
+    qint64 m_fpsPublishedMilli = 0;             // This stream's share of the f1sh_stream_fps gauge
+
+    // Drop accounting: raw counters are written from streaming threads,
+    // the qint64 snapshots below are published to QML by updateStreamStats()
+    std::atomic<quint64> m_queueLeaks{0};
+    std::atomic<quint64> m_appSinkBuffersIn{0};
+    std::atomic<quint64> m_samplesPulled{0};
+    std::atomic<quint64> m_decodeErrors{0};
+    quint64 m_supersededBase = 0;
+    qint64 m_droppedQueue = 0;
+    qint64 m_droppedAppsink = 0;
+    qint64 m_droppedSuperseded = 0;
+    qint64 m_droppedDecodeError = 0;
+
+    // RTP loss/jitter state, only touched from the udpsrc streaming thread
+    bool m_rtpHaveLast = false;
+    guint16 m_rtpLastSeq = 0;
+    guint32 m_rtpLastTimestamp = 0;
+    gint64 m_rtpLastArrival = 0;  // 90 kHz units
+    double m_rtpJitter = 0.0;     // 90 kHz units, RFC 3550 estimator
 };
 
 #endif // STREAMMANAGER_H
@@ -0,0 +1,268 @@
+#include "trace.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace Trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+const int kCapacity = 1 << 15;   // Power of two, ~3 MB of events
+
+struct Event {
+    // Index + 1 of the event in this slot once it is fully written, 0 while
+    // it is being written. Readers copy the slot and re-check it.
+    std::atomic<quint64> seq{0};
+    const char *category;
+    const char *name;
+    qint64 timestampUs;
+    qint64 durationUs;
+    quint64 id;
+    int threadId;
+    char phase;
+    char detail[40];
+};
+
+Event s_events[kCapacity];
+std::atomic<quint64> s_next{0};
+std::atomic<quint64> s_clearedAt{0};   // Events before this index were cleared
+
+std::atomic<int> s_nextThreadId{1};
+thread_local int t_threadId = 0;
+
+QMutex s_namesMutex;
+QHash<int, QByteArray> s_threadNames;
+QSet<QByteArray> s_interned;
+
+const auto s_epoch = std::chrono::steady_clock::now();
+
+int currentThreadId()
+{
+    if (t_threadId == 0) {
+        t_threadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+        // Once per thread: remember a readable name for the trace viewer
+        QThread *thread = QThread::currentThread();
+        QByteArray name = thread ? thread->objectName().toUtf8() : QByteArray();
+        if (name.isEmpty()) {
+            QCoreApplication *app = QCoreApplication::instance();
+            name = (app && thread == app->thread()) ? QByteArray("main")
+                                                    : QByteArray("thread ") + QByteArray::number(t_threadId);
+        }
+        QMutexLocker locker(&s_namesMutex);
+        s_threadNames.insert(t_threadId, name);
+    }
+    return t_threadId;
+}
+
+void record(char phase, const char *category, const char *name, qint64 timestampUs,
+            qint64 durationUs, quint64 id, const char *detail)
+{
+    const quint64 index = s_next.fetch_add(1, std::memory_order_relaxed);
+    Event &event = s_events[index & (kCapacity - 1)];
+
+    event.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.category = category;
+    event.name = name;
+    event.timestampUs = timestampUs;
+    event.durationUs = durationUs;
+    event.id = id;
+    event.threadId = currentThreadId();
+    event.phase = phase;
+    if (detail) {
+        qstrncpy(event.detail, detail, sizeof(event.detail));
+    } else {
+        event.detail[0] = '\0';
+    }
+
+    event.seq.store(index + 1, std::memory_order_release);
+}
+
+void appendJsonString(QByteArray &out, const char *text)
+{
+    out += '"';
+    for (const char *p = text; *p; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += char(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+void complete(const char *category, const char *name, qint64 startUs, qint64 durationUs,
+              const char *detail)
+{
+    if (isEnabled()) {
+        record('X', category, name, startUs, durationUs, 0, detail);
+    }
+}
+
+void instant(const char *category, const char *name, const char *detail)
+{
+    if (isEnabled()) {
+        record('i', category, name, nowUs(), 0, 0, detail);
+    }
+}
+
+void asyncBegin(const char *category, const char *name, quint64 id, const char *detail)
+{
+    if (isEnabled()) {
+        record('b', category, name, nowUs(), 0, id, detail);
+    }
+}
+
+void asyncEnd(const char *category, const char *name, quint64 id, const char *detail)
+{
+    if (isEnabled()) {
+        record('e', category, name, nowUs(), 0, id, detail);
+    }
+}
+
+const char *intern(const QString &text)
+{
+    QMutexLocker locker(&s_namesMutex);
+    auto it = s_interned.insert(text.toUtf8());
+    return it->constData();
+}
+
+void clear()
+{
+    s_clearedAt.store(s_next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int eventCount()
+{
+    const quint64 end = s_next.load(std::memory_order_relaxed);
+    const quint64 begin = s_clearedAt.load(std::memory_order_relaxed);
+    return int(qMin<quint64>(end - begin, kCapacity));
+}
+
+QByteArray toChromeJson()
+{
+    const quint64 end = s_next.load(std::memory_order_acquire);
+    quint64 begin = s_clearedAt.load(std::memory_order_relaxed);
+    if (end - begin > quint64(kCapacity)) {
+        begin = end - kCapacity;
+    }
+
+    QByteArray out;
+    out.reserve(int(end - begin) * 120 + 1024);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    {
+        QMutexLocker locker(&s_namesMutex);
+        for (auto it = s_threadNames.constBegin(); it != s_threadNames.constEnd(); ++it) {
+            out += first ? "" : ",";
+            first = false;
+            out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":";
+            out += QByteArray::number(it.key());
+            out += ",\"args\":{\"name\":";
+            appendJsonString(out, it.value().constData());
+            out += "}}";
+        }
+    }
+
+    for (quint64 index = begin; index < end; ++index) {
+        const Event &slot = s_events[index & (kCapacity - 1)];
+
+        // Copy, then check the slot was neither mid-write nor overwritten meanwhile
+        const quint64 seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != index + 1) {
+            continue;
+        }
+        Event event;
+        event.category = slot.category;
+        event.name = slot.name;
+        event.timestampUs = slot.timestampUs;
+        event.durationUs = slot.durationUs;
+        event.id = slot.id;
+        event.threadId = slot.threadId;
+        event.phase = slot.phase;
+        std::memcpy(event.detail, slot.detail, sizeof(event.detail));
+        event.detail[sizeof(event.detail) - 1] = '\0';
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            continue;
+        }
+
+        out += first ? "" : ",";
+        first = false;
+        out += "{\"ph\":\"";
+        out += event.phase;
+        out += "\",\"cat\":";
+        appendJsonString(out, event.category);
+        out += ",\"name\":";
+        appendJsonString(out, event.name);
+        out += ",\"pid\":1,\"tid\":";
+        out += QByteArray::number(event.threadId);
+        out += ",\"ts\":";
+        out += QByteArray::number(event.timestampUs);
+        if (event.phase == 'X') {
+            out += ",\"dur\":";
+            out += QByteArray::number(event.durationUs);
+        } else if (event.phase == 'i') {
+            out += ",\"s\":\"t\"";
+        } else {
+            out += ",\"id\":\"0x";
+            out += QByteArray::number(event.id, 16);
+            out += '"';
+        }
+        if (event.detail[0]) {
+            out += ",\"args\":{\"detail\":";
+            appendJsonString(out, event.detail);
+            out += '}';
+        }
+        out += '}';
+    }
+
+    out += "]}\n";
+    return out;
+}
+
+bool writeChromeJson(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(toChromeJson()) >= 0;
+}
+
+} // namespace Trace
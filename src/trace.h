@@ -0,0 +1,96 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// Lightweight event tracing for performance investigations.
+//
+// Events go into a fixed-size in-memory ring (the newest kCapacity events are
+// kept) and can be dumped as Chrome trace JSON, which chrome://tracing and the
+// Perfetto UI both open. Recording is off by default; when off every call is a
+// single relaxed atomic load. When on, recording claims a slot with one atomic
+// increment and never locks, so it is safe on the GStreamer streaming thread.
+//
+// category and name must be string literals (or otherwise outlive the trace);
+// use intern() for dynamic names. detail is copied and truncated.
+namespace Trace {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool isEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+void setEnabled(bool enabled);
+
+// Microseconds on a monotonic clock shared by all events
+qint64 nowUs();
+
+void complete(const char *category, const char *name, qint64 startUs, qint64 durationUs,
+              const char *detail = nullptr);
+void instant(const char *category, const char *name, const char *detail = nullptr);
+// Spans that begin and end in different places (or threads), matched by id
+void asyncBegin(const char *category, const char *name, quint64 id, const char *detail = nullptr);
+void asyncEnd(const char *category, const char *name, quint64 id, const char *detail = nullptr);
+
+// Returns a pointer that stays valid for the lifetime of the process
+const char *intern(const QString &text);
+
+// Drops all recorded events
+void clear();
+int eventCount();
+
+// Chrome trace event format ("traceEvents" object)
+QByteArray toChromeJson();
+bool writeChromeJson(const QString &path);
+
+// Records a complete event for the enclosing scope
+class Scope
+{
+public:
+    Scope(const char *category, const char *name, const char *detail = nullptr)
+        : m_category(category), m_name(name)
+    {
+        if (isEnabled()) {
+            m_startUs = nowUs();
+            if (detail) {
+                qstrncpy(m_detail, detail, sizeof(m_detail));
+            }
+        }
+    }
+
+    // Converts detail only when tracing is on
+    Scope(const char *category, const char *name, const QString &detail)
+        : m_category(category), m_name(name)
+    {
+        if (isEnabled()) {
+            m_startUs = nowUs();
+            qstrncpy(m_detail, detail.toUtf8().constData(), sizeof(m_detail));
+        }
+    }
+
+    ~Scope()
+    {
+        if (m_startUs >= 0 && isEnabled()) {
+            complete(m_category, m_name, m_startUs, nowUs() - m_startUs, m_detail[0] ? m_detail : nullptr);
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_category;
+    const char *m_name;
+    qint64 m_startUs = -1;
+    char m_detail[40] = {};
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// TRACE_SCOPE("grpc", "Health") or TRACE_SCOPE("serial", "command", cmd.constData())
+#define TRACE_SCOPE(...) Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(__VA_ARGS__)
+
+#endif // TRACE_H
@@ -0,0 +1,123 @@
+#include "tracemanager.h"
+#include "trace.h"
+#include "logmanager.h"
+#include <QDateTime>
+#include <QDir>
+#include <QQuickWindow>
+#include <QStandardPaths>
+#include <atomic>
+#include <memory>
+
+TraceManager::TraceManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool TraceManager::enabled() const
+{
+    return Trace::isEnabled();
+}
+
+void TraceManager::setEnabled(bool enabled)
+{
+    if (Trace::isEnabled() == enabled) {
+        return;
+    }
+
+    if (enabled) {
+        // Each recording session starts from an empty ring
+        Trace::clear();
+        m_openSpans.clear();
+    }
+    Trace::setEnabled(enabled);
+    LOG_INFO(General, enabled ? "Tracing started" : "Tracing stopped");
+    emit enabledChanged();
+}
+
+QString TraceManager::saveTrace(const QString &path)
+{
+    QString target = path;
+    if (target.isEmpty()) {
+        QString baseDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+        QDir dir(baseDir + "/traces");
+        if (baseDir.isEmpty() || (!dir.exists() && !dir.mkpath("."))) {
+            LOG_WARNING(General, "Trace: no writable folder for trace files");
+            emit traceSaved(false, QString());
+            return QString();
+        }
+        target = dir.filePath(QDateTime::currentDateTime().toString("'trace-'yyyyMMdd-hhmmss'.json'"));
+    }
+
+    int events = Trace::eventCount();
+    if (!Trace::writeChromeJson(target)) {
+        LOG_WARNING(General, QString("Trace: could not write %1").arg(target));
+        emit traceSaved(false, target);
+        return QString();
+    }
+
+    LOG_INFO(General, QString("Trace saved: %1 (%2 events, open in chrome://tracing or ui.perfetto.dev)")
+             .arg(target).arg(events));
+    m_lastTracePath = target;
+    emit lastTracePathChanged();
+    emit traceSaved(true, target);
+    return target;
+}
+
+void TraceManager::beginSpan(const QString &name)
+{
+    if (!Trace::isEnabled()) {
+        return;
+    }
+
+    // Restarting a span that is still open ends the previous one first
+    if (m_openSpans.contains(name)) {
+        endSpan(name, "restarted");
+    }
+    quint64 id = m_nextSpanId++;
+    m_openSpans.insert(name, id);
+    Trace::asyncBegin("qml", Trace::intern(name), id);
+}
+
+void TraceManager::endSpan(const QString &name, const QString &detail)
+{
+    auto it = m_openSpans.find(name);
+    if (it == m_openSpans.end()) {
+        return;
+    }
+    quint64 id = it.value();
+    m_openSpans.erase(it);
+    Trace::asyncEnd("qml", Trace::intern(name), id,
+                    detail.isEmpty() ? nullptr : detail.toUtf8().constData());
+}
+
+void TraceManager::mark(const QString &name, const QString &detail)
+{
+    if (!Trace::isEnabled()) {
+        return;
+    }
+    Trace::instant("qml", Trace::intern(name), detail.isEmpty() ? nullptr : detail.toUtf8().constData());
+}
+
+void TraceManager::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    // Both signals come from the render thread (direct connections): a render
+    // span from sync to swap, and an instant at each swap.
+    auto renderStart = std::make_shared<std::atomic<qint64>>(-1);
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [renderStart]() {
+        renderStart->store(Trace::isEnabled() ? Trace::nowUs() : -1, std::memory_order_relaxed);
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [renderStart]() {
+        if (!Trace::isEnabled()) {
+            return;
+        }
+        qint64 start = renderStart->exchange(-1, std::memory_order_relaxed);
+        if (start >= 0) {
+            Trace::complete("qml", "render", start, Trace::nowUs() - start);
+        }
+        Trace::instant("qml", "frameSwapped");
+    }, Qt::DirectConnection);
+}
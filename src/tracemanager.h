@@ -0,0 +1,50 @@
+#ifndef TRACEMANAGER_H
+#define TRACEMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+
+class QQuickWindow;
+
+// QML-facing control for the tracing mode in trace.h: switches recording on
+// and off, saves Chrome trace JSON files and lets QML mark its own spans
+// (e.g. the whole "Connect Camera" flow). Also records scene graph frames of
+// an attached window so UI stalls line up with pipeline and network events.
+class TraceManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(QString lastTracePath READ lastTracePath NOTIFY lastTracePathChanged)
+
+public:
+    explicit TraceManager(QObject *parent = nullptr);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    QString lastTracePath() const { return m_lastTracePath; }
+
+    // Writes the recorded events to path, or to a timestamped file in the
+    // app data "traces" folder when path is empty. Returns the file written,
+    // or an empty string on failure.
+    Q_INVOKABLE QString saveTrace(const QString &path = QString());
+
+    Q_INVOKABLE void beginSpan(const QString &name);
+    Q_INVOKABLE void endSpan(const QString &name, const QString &detail = QString());
+    Q_INVOKABLE void mark(const QString &name, const QString &detail = QString());
+
+    // Records render passes and frame swaps of the window
+    void attachWindow(QQuickWindow *window);
+
+signals:
+    void enabledChanged();
+    void lastTracePathChanged();
+    void traceSaved(bool success, const QString &path);
+
+private:
+    QHash<QString, quint64> m_openSpans;   // QML span name -> async id
+    quint64 m_nextSpanId = 1;
+    QString m_lastTracePath;
+};
+
+#endif // TRACEMANAGER_H
@@ -0,0 +1,107 @@
+#include "transportsource.h"
+#include <QHostAddress>
+#include <QNetworkInterface>
+#include <QRegularExpression>
+
+namespace TransportSource {
+
+namespace {
+
+// The host is spliced into gst_parse_launch text and into rtsp:// and
+// srt:// URIs, so only an IP address or an RFC 1123 hostname gets through.
+// Returns the form to splice in, or an empty string if the host is invalid.
+QString validatedHost(const QString &host)
+{
+    const QString trimmed = host.trimmed();
+    const QHostAddress address(trimmed);
+    if (!address.isNull()) {
+        return address.toString();
+    }
+
+    static const QRegularExpression hostname(
+        "^(?=.{1,253}\\.?$)[A-Za-z0-9](?:[A-Za-z0-9-]{0,61}[A-Za-z0-9])?"
+        "(?:\\.[A-Za-z0-9](?:[A-Za-z0-9-]{0,61}[A-Za-z0-9])?)*\\.?$");
+    return hostname.match(trimmed).hasMatch() ? trimmed : QString();
+}
+
+// IPv6 literals need brackets inside a URI authority, and a zone id's '%'
+// must itself be escaped (RFC 6874)
+QString uriHost(QString host)
+{
+    if (!host.contains(':')) {
+        return host;
+    }
+    host.replace('%', "%25");
+    return QString("[%1]").arg(host);
+}
+
+} // namespace
+
+QString build(const QString &transport, const Options &options, QString *error)
+{
+    const QString rtpCaps = "media=video,encoding-name=H264,clock-rate=90000,payload=96";
+
+    if (transport == "udp") {
+        // Camera pushes to us; minimal buffering for low latency
+        QString source = QString("udpsrc name=src port=%1").arg(options.port);
+        if (!options.multicastGroup.isEmpty()) {
+            // Both values are spliced into gst_parse_launch text, so only a
+            // parsed group address and a known interface name get through
+            const QHostAddress group(options.multicastGroup.trimmed());
+            if (!group.isMulticast()) {
+                *error = QString("Invalid multicast group: %1").arg(options.multicastGroup);
+                return QString();
+            }
+            // udpsrc joins the group itself (auto-multicast)
+            source += QString(" address=%1 auto-multicast=true").arg(group.toString());
+
+            if (!options.multicastInterface.isEmpty()) {
+                const QNetworkInterface iface = QNetworkInterface::interfaceFromName(options.multicastInterface.trimmed());
+                if (!iface.isValid()) {
+                    *error = QString("Unknown multicast interface: %1").arg(options.multicastInterface);
+                    return QString();
+                }
+                source += QString(" multicast-iface=%1").arg(iface.name());
+            }
+        }
+        return QString("%1 ! application/x-rtp,%2 ! rtph264depay name=depay ! ").arg(source, rtpCaps);
+    }
+
+    if (options.host.isEmpty()) {
+        *error = QString("Transport %1 needs a camera host address").arg(transport);
+        return QString();
+    }
+    const QString host = validatedHost(options.host);
+    if (host.isEmpty()) {
+        *error = QString("Invalid camera host: %1").arg(options.host);
+        return QString();
+    }
+
+    if (transport == "tcp") {
+        // RFC 4571 framed RTP over a TCP connection to the camera
+        return QString("tcpclientsrc name=src host=%1 port=%2 ! "
+                       "application/x-rtp-stream,%3 ! rtpstreamdepay ! "
+                       "rtph264depay name=depay ! ").arg(host).arg(options.port).arg(rtpCaps);
+    }
+
+    if (transport == "rtsp" || transport == "rtsp-tcp") {
+        // rtspsrc's jitterbuffer drops late packets instead of adding delay
+        QString protocols = transport == "rtsp-tcp" ? "tcp" : "udp+tcp";
+        return QString("rtspsrc name=src location=rtsp://%1:%2/ latency=%3 protocols=%4 "
+                       "drop-on-latency=true buffer-mode=none ! "
+                       "rtph264depay name=depay ! ")
+            .arg(uriHost(host)).arg(options.port).arg(options.latencyMs).arg(protocols);
+    }
+
+    if (transport == "srt") {
+        // MPEG-TS over SRT in caller mode; no RTP layer, so no RTP statistics
+        return QString("srtsrc name=src uri=\"srt://%1:%2?mode=caller\" latency=%3 ! "
+                       "tsdemux latency=0 ! video/x-h264 ! ")
+            .arg(uriHost(host)).arg(options.port).arg(options.latencyMs);
+    }
+
+    *error = QString("Unknown transport: %1").arg(transport);
+    return QString();
+}
+
+} // namespace TransportSource
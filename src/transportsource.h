@@ -0,0 +1,29 @@
+#ifndef TRANSPORTSOURCE_H
+#define TRANSPORTSOURCE_H
+
+#include <QString>
+
+// gst_parse_launch text for the receive side of each transport, up to and
+// including the element that outputs H.264 ("udp", "tcp", "rtsp", "rtsp-tcp",
+// "srt"). Shared by StreamManager and bench/transport_bench.cpp.
+//
+// Every RTP transport ends in the depayloader named "depay" so RTP statistics
+// work the same way; the element producing data is always named "src".
+namespace TransportSource {
+
+struct Options {
+    QString host;                   // Camera IP or hostname; required for all but udp
+    int port = 0;
+    int latencyMs = 50;             // Jitter/receive buffer for rtsp/srt
+    QString multicastGroup;         // udp only; empty = unicast
+    QString multicastInterface;
+};
+
+// Returns the source string ending in "! ", or an empty string with *error
+// set if the transport is unknown, the host is not an IP address or RFC 1123
+// hostname, or the options don't allow it
+QString build(const QString &transport, const Options &options, QString *error);
+
+} // namespace TransportSource
+
+#endif // TRANSPORTSOURCE_H
@@ -1,5 +1,6 @@
 #include "wifimanager.h"
 #include "logmanager.h"
+#include "trace.h"
 #include <QDebug>
 #include <QVariantMap>
 #include <QJsonDocument>
@@ -11,6 +12,7 @@
 
 QByteArray WifiWorker::sendSerialCommand(const QString &portName, const QByteArray &command, int timeoutMs)
 {
+    TRACE_SCOPE("serial", "command", command.constData());
     QSerialPort serial;
     serial.setPortName(portName);
     serial.setBaudRate(QSerialPort::Baud115200);
@@ -68,31 +70,31 @@ int WifiWorker::parseResponseCode(const QByteArray &response)
 void WifiWorker::doCheckStatus(const QString &serialPort)
 {
     if (serialPort.isEmpty()) {
-        LogManager::log("Status check failed: No camera connected");
+        LOG_WARNING(Wifi, "Status check failed: No camera connected");
         emit statusCheckFinished(false, "No camera connected");
         return;
     }
 
-    LogManager::log(QString("Checking program status via %1...").arg(serialPort));
+    LOG_INFO(Wifi, QString("Checking program status via %1...").arg(serialPort));
 
     // Wait for TX to send status 1 (ready) - just read without sending
     // The TX application sends {"status": 1, "payload": null} when ready
     QByteArray response = sendSerialCommand(serialPort, QByteArray(), 2000);
 
     if (response.isEmpty()) {
-        LogManager::log("Status check failed: No response from camera");
+        LOG_WARNING(Wifi, "Status check failed: No response from camera");
         emit statusCheckFinished(false, "No response from camera");
         return;
     }
 
-    LogManager::log(QString("Status response: %1").arg(QString::fromUtf8(response).trimmed()));
+    LOG_DEBUG(Wifi, QString("Status response: %1").arg(QString::fromUtf8(response).trimmed()));
 
     int status = parseResponseCode(response);
     if (status == WifiProtocol::TX_READY) {
-        LogManager::log("Camera ready (status 1 received)");
+        LOG_INFO(Wifi, "Camera ready (status 1 received)");
         emit statusCheckFinished(true, QString());
     } else {
-        LogManager::log(QString("Camera status check failed: unexpected status %1").arg(status));
+        LOG_WARNING(Wifi, QString("Camera status check failed: unexpected status %1").arg(status));
         emit statusCheckFinished(false, "Camera not ready");
     }
 }
@@ -103,12 +105,12 @@ void WifiWorker::doScan(const QString &serialPort)
     QString connectedNetwork;
 
     if (serialPort.isEmpty()) {
-        LogManager::log("WiFi scan failed: No camera connected");
+        LOG_WARNING(Wifi, "WiFi scan failed: No camera connected");
         emit scanFinished(networks, connectedNetwork, false, "No camera connected");
         return;
     }
 
-    LogManager::log(QString("Sending WiFi scan request (status 21) via %1...").arg(serialPort));
+    LOG_INFO(Wifi, QString("Sending WiFi scan request (status 21) via %1...").arg(serialPort));
 
     // Send status 21 to request WiFi network list
     // Format: {"status": 21, "payload": null}
@@ -116,19 +118,19 @@ void WifiWorker::doScan(const QString &serialPort)
     QByteArray response = sendSerialCommand(serialPort, command, 10000); // Longer timeout for WiFi scan
 
     if (response.isEmpty()) {
-        LogManager::log("WiFi scan failed: No response from camera");
+        LOG_WARNING(Wifi, "WiFi scan failed: No response from camera");
         emit scanFinished(networks, connectedNetwork, false, "No response from camera");
         return;
     }
 
-    LogManager::log(QString("WiFi scan response: %1").arg(QString::fromUtf8(response).trimmed()));
+    LOG_DEBUG(Wifi, QString("WiFi scan response: %1").arg(QString::fromUtf8(response).trimmed()));
 
     // Parse JSON response
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(response, &parseError);
 
     if (parseError.error != QJsonParseError::NoError) {
-        LogManager::log(QString("JSON parse error: %1").arg(parseError.errorString()));
+        LOG_WARNING(Wifi, QString("JSON parse error: %1").arg(parseError.errorString()));
         emit scanFinished(networks, connectedNetwork, false, "Invalid response from camera");
         return;
     }
@@ -138,7 +140,7 @@ void WifiWorker::doScan(const QString &serialPort)
 
     // Expect status 4 for WiFi list response
     if (status != WifiProtocol::TX_WIFI_LIST) {
-        LogManager::log(QString("Unexpected response status: %1 (expected 4)").arg(status));
+        LOG_WARNING(Wifi, QString("Unexpected response status: %1 (expected 4)").arg(status));
         emit scanFinished(networks, connectedNetwork, false, "Unexpected response from camera");
         return;
     }
@@ -157,10 +159,10 @@ void WifiWorker::doScan(const QString &serialPort)
         if (payloadDoc.isArray()) {
             wifiArray = payloadDoc.array();
         } else {
-            LogManager::log("Payload string is not a valid JSON array");
+            LOG_WARNING(Wifi, "Payload string is not a valid JSON array");
         }
     } else {
-        LogManager::log("Unexpected payload type in WiFi list response");
+        LOG_WARNING(Wifi, "Unexpected payload type in WiFi list response");
     }
 
     for (const QJsonValue &value : wifiArray) {
@@ -191,19 +193,19 @@ void WifiWorker::doScan(const QString &serialPort)
         networks.append(network);
     }
 
-    LogManager::log(QString("WiFi scan complete (status 4): Found %1 networks").arg(networks.size()));
+    LOG_INFO(Wifi, QString("WiFi scan complete (status 4): Found %1 networks").arg(networks.size()));
     emit scanFinished(networks, connectedNetwork, true, QString());
 }
 
 void WifiWorker::doConnect(const QString &serialPort, const QString &bssid, const QString &password, const QString &rxIp)
 {
     if (serialPort.isEmpty()) {
-        LogManager::log("WiFi connect failed: No camera connected");
+        LOG_WARNING(Wifi, "WiFi connect failed: No camera connected");
         emit connectFinished(false, QString(), "No camera connected");
         return;
     }
 
-    LogManager::log(QString("Connecting to WiFi network (BSSID: %1)...").arg(bssid));
+    LOG_INFO(Wifi, QString("Connecting to WiFi network (BSSID: %1)...").arg(bssid));
 
     // Step 1: Send status 22 with BSSID and password
     // Format: {"status": 22, "payload": {"BSSID": "bssid", "pass": "password"}}
@@ -216,24 +218,24 @@ void WifiWorker::doConnect(const QString &serialPort, const QString &bssid, cons
     connectCmd["payload"] = payload;
 
     QByteArray command = QJsonDocument(connectCmd).toJson(QJsonDocument::Compact) + "\n";
-    LogManager::log(QString("Sending connect request (status 22) for BSSID: %1").arg(bssid));
+    LOG_INFO(Wifi, QString("Sending connect request (status 22) for BSSID: %1").arg(bssid));
 
     QByteArray response = sendSerialCommand(serialPort, command, 30000); // 30s timeout for WiFi connection
 
     if (response.isEmpty()) {
-        LogManager::log("WiFi connect failed: No response from camera");
+        LOG_WARNING(Wifi, "WiFi connect failed: No response from camera");
         emit connectFinished(false, QString(), "No response from camera");
         return;
     }
 
-    LogManager::log(QString("Connect response: %1").arg(QString::fromUtf8(response).trimmed()));
+    LOG_DEBUG(Wifi, QString("Connect response: %1").arg(QString::fromUtf8(response).trimmed()));
 
     // Parse response
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(response, &parseError);
 
     if (parseError.error != QJsonParseError::NoError) {
-        LogManager::log(QString("JSON parse error: %1").arg(parseError.errorString()));
+        LOG_WARNING(Wifi, QString("JSON parse error: %1").arg(parseError.errorString()));
         emit connectFinished(false, QString(), "Invalid response from camera");
         return;
     }
@@ -243,13 +245,13 @@ void WifiWorker::doConnect(const QString &serialPort, const QString &bssid, cons
 
     // Check for status 2 (success) or status 3 (failure)
     if (status == WifiProtocol::TX_WIFI_FAILED) {
-        LogManager::log("WiFi connect error (status 3): Connection failed");
+        LOG_WARNING(Wifi, "WiFi connect error (status 3): Connection failed");
         emit connectFinished(false, QString(), "WiFi connection failed");
         return;
     }
 
     if (status != WifiProtocol::TX_WIFI_SUCCESS) {
-        LogManager::log(QString("Unexpected response status: %1 (expected 2)").arg(status));
+        LOG_WARNING(Wifi, QString("Unexpected response status: %1 (expected 2)").arg(status));
         emit connectFinished(false, QString(), "Unexpected response from camera");
         return;
     }
@@ -269,19 +271,19 @@ void WifiWorker::doConnect(const QString &serialPort, const QString &bssid, cons
         if (payloadDoc.isObject()) {
             responsePayload = payloadDoc.object();
         } else {
-            LogManager::log("Payload string is not a valid JSON object");
+            LOG_WARNING(Wifi, "Payload string is not a valid JSON object");
         }
     }
 
     QString txIp = responsePayload["IPAddr"].toString();
 
     if (txIp.isEmpty()) {
-        LogManager::log("TX IP address is empty in response");
+        LOG_WARNING(Wifi, "TX IP address is empty in response");
         emit connectFinished(false, QString(), "TX IP address not provided");
         return;
     }
 
-    LogManager::log(QString("WiFi connection successful (status 2), TX IP: %1").arg(txIp));
+    LOG_INFO(Wifi, QString("WiFi connection successful (status 2), TX IP: %1").arg(txIp));
 
     // Step 2: Send RX's IP address with status 23
     // Format: {"status": 23, "payload": {"IPAddr": "192.168.x.x"}}
@@ -293,12 +295,12 @@ void WifiWorker::doConnect(const QString &serialPort, const QString &bssid, cons
     ipCmd["payload"] = ipPayload;
 
     command = QJsonDocument(ipCmd).toJson(QJsonDocument::Compact) + "\n";
-    LogManager::log(QString("Sending RX IP address (status 23): %1").arg(rxIp));
+    LOG_INFO(Wifi, QString("Sending RX IP address (status 23): %1").arg(rxIp));
 
     // Send RX IP - no response expected according to protocol
     sendSerialCommand(serialPort, command, 1000);
 
-    LogManager::log("WiFi connection flow completed successfully!");
+    LOG_INFO(Wifi, "WiFi connection flow completed successfully!");
     emit connectFinished(true, txIp, QString());
 }
 
@@ -425,7 +427,7 @@ void WifiManager::onScanFinished(const QVariantList &networks, const QString &co
         }
         m_errorMessage.clear();
     } else {
-        LogManager::log(QString("WiFi scan error: %1").arg(errorMessage));
+        LOG_ERROR(Wifi, QString("WiFi scan error: %1").arg(errorMessage));
         m_errorMessage = errorMessage;
     }
     emit errorMessageChanged();
@@ -442,11 +444,11 @@ void WifiManager::onConnectFinished(bool success, const QString &txIp, const QSt
         m_errorMessage.clear();
         emit errorMessageChanged();
         emit connectionSucceeded(txIp);
-        LogManager::log(QString("WiFi connection complete. TX IP: %1").arg(txIp));
+        LOG_INFO(Wifi, QString("WiFi connection complete. TX IP: %1").arg(txIp));
     } else {
         m_errorMessage = errorMessage;
         emit errorMessageChanged();
         emit connectionFailed(errorMessage);
-        LogManager::log(QString("WiFi connection failed: %1").arg(errorMessage));
+        LOG_ERROR(Wifi, QString("WiFi connection failed: %1").arg(errorMessage));
     }
 }
@@ -0,0 +1,231 @@
+// DiscoveryParser against recorded avahi-browse -rpt and dns-sd -Z output.
+//
+// Usage: discoveryparser-test
+
+#include "discoveryparser.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <cstdio>
+
+namespace {
+
+int s_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            ++s_failures; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto actualValue = (actual); \
+        const auto expectedValue = (expected); \
+        if (!(actualValue == expectedValue)) { \
+            std::printf("FAIL %s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, \
+                        qPrintable(describe(actualValue)), qPrintable(describe(expectedValue))); \
+            ++s_failures; \
+        } \
+    } while (0)
+
+QString describe(const QString &value)
+{
+    return value;
+}
+
+QString describe(int value)
+{
+    return QString::number(value);
+}
+
+QString describe(qsizetype value)
+{
+    return QString::number(value);
+}
+
+QString describe(const QStringList &value)
+{
+    return value.join(", ");
+}
+
+const QString kServiceType = "_f1sh-camera._tcp";
+
+const CameraInfo *find(const QList<CameraInfo> &cameras, const QString &name)
+{
+    for (const CameraInfo &camera : cameras) {
+        if (camera.name == name) {
+            return &camera;
+        }
+    }
+    return nullptr;
+}
+
+void testUnescape()
+{
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"F1sh\\032Camera\\032TX"), QString("F1sh Camera TX"));
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"Pit\\059Lane\\046A"), QString("Pit;Lane.A"));
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"back\\\\slash\\.dot"), QString("back\\slash.dot"));
+    // UTF-8 bytes escaped one by one
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"Cam\\195\\169ra"), QString::fromUtf8("Cam\xc3\xa9ra"));
+    // Too short for \DDD at the end, taken literally
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"cam\\03"), QString("cam03"));
+    CHECK_EQ(DiscoveryParser::unescapeDnsName(u"plain"), QString("plain"));
+}
+
+void testTxtRecord()
+{
+    CameraInfo info;
+    DiscoveryParser::parseTxtRecord(u"\"protocol=tcp\" \"encoding=h265\" \"control_port=50052\"", info);
+    CHECK_EQ(info.protocol, QString("tcp"));
+    CHECK_EQ(info.encoding, QString("h265"));
+    CHECK_EQ(info.controlPort, 50052);
+
+    CameraInfo bare;
+    DiscoveryParser::parseTxtRecord(u"PROTOCOL=udp empty= =x control_port=50053", bare);
+    CHECK_EQ(bare.protocol, QString("udp"));
+    CHECK_EQ(bare.encoding, QString());
+    CHECK_EQ(bare.controlPort, 50053);
+}
+
+void testAvahi()
+{
+    DiscoveryParser parser(kServiceType);
+    parser.feed("+;eth0;IPv4;F1sh\\032Camera\\032TX;_f1sh-camera._tcp;local\n"
+                "+;eth0;IPv4;Pit\\059Lane;_f1sh-camera._tcp;local\n"
+                "+;eth0;IPv4;Printer;_ipp._tcp;local\n");
+    CHECK_EQ(parser.serviceCount(), 2);
+    CHECK(parser.takeResolved(true).isEmpty());
+
+    // ';' inside a TXT string must not cut the record short
+    parser.feed("=;eth0;IPv4;F1sh\\032Camera\\032TX;_f1sh-camera._tcp;local;s4v-cam2-1.local;192.168.3.132;8888;"
+                "\"protocol=tcp\" \"label=car;front\" \"encoding=h265\" \"control_port=50052\"\n"
+                "=;eth0;IPv6;Pit\\059Lane;_f1sh-camera._tcp;local;pit.local;fe80::1;9000;\"protocol=udp\"\n");
+    QList<CameraInfo> resolved = parser.takeResolved(true);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    const CameraInfo *camera = find(resolved, "F1sh Camera TX");
+    CHECK(camera);
+    if (camera) {
+        CHECK_EQ(camera->hostname, QString("s4v-cam2-1.local"));
+        CHECK_EQ(camera->ip, QString("192.168.3.132"));
+        CHECK_EQ(camera->port, 8888);
+        CHECK_EQ(camera->protocol, QString("tcp"));
+        CHECK_EQ(camera->encoding, QString("h265"));
+        CHECK_EQ(camera->controlPort, 50052);
+    }
+
+    // Only an IPv6 answer so far: needs a hostname lookup
+    CHECK_EQ(parser.unresolvedHosts(), QStringList{"pit.local"});
+    parser.feed("=;eth0;IPv4;Pit\\059Lane;_f1sh-camera._tcp;local;pit.local;10.0.0.7;9000;\"protocol=udp\"");
+    CHECK(parser.takeResolved(true).isEmpty());
+    parser.finish();
+    resolved = parser.takeResolved(true);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    CHECK(find(resolved, "Pit;Lane") && find(resolved, "Pit;Lane")->ip == "10.0.0.7");
+
+    // Removal lines and repeats are ignored; nothing is returned twice
+    parser.feed("-;eth0;IPv4;F1sh\\032Camera\\032TX;_f1sh-camera._tcp;local\n");
+    CHECK(parser.takeResolved(false).isEmpty());
+    CHECK(parser.unresolvedHosts().isEmpty());
+}
+
+void testDnsSd()
+{
+    DiscoveryParser parser(kServiceType);
+    // Split mid-line as pipe reads do
+    const QByteArray output =
+        "; Zone file for _f1sh-camera._tcp.local.\n"
+        "_f1sh-camera._tcp                               PTR     F1sh Camera TX._f1sh-camera._tcp\n"
+        "F1sh Camera TX._f1sh-camera._tcp                SRV     0 0 8888 s4v-cam2-1.local.\n"
+        "F1sh Camera TX._f1sh-camera._tcp                TXT     \"protocol=udp\" \"encoding=h264\" \"control_port=50051\"\n"
+        "s4v-cam2-1.local.                               AAAA    fe80::fdc7:793:e4c1:e78e\n"
+        "s4v-cam2-1.local.                               A       192.168.3.132\n";
+    parser.feed(output.left(100));
+    parser.feed(output.mid(100, 77));
+    parser.feed(output.mid(177));
+
+    const QList<CameraInfo> resolved = parser.takeResolved(true);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    const CameraInfo *camera = find(resolved, "F1sh Camera TX");
+    CHECK(camera);
+    if (camera) {
+        CHECK_EQ(camera->hostname, QString("s4v-cam2-1.local"));
+        CHECK_EQ(camera->ip, QString("192.168.3.132"));
+        CHECK_EQ(camera->port, 8888);
+        CHECK_EQ(camera->protocol, QString("udp"));
+        CHECK_EQ(camera->encoding, QString("h264"));
+        CHECK_EQ(camera->controlPort, 50051);
+    }
+}
+
+void testOutOfOrder()
+{
+    DiscoveryParser parser(kServiceType);
+    // Address first, then SRV, PTR and finally TXT; two services share a host
+    parser.feed("CAM-3.local.                                    A       10.1.2.3\n"
+                "Side\\032Cam._f1sh-camera._tcp                  SRV     0 0 8890 cam-3.local.\n"
+                "Rear._f1sh-camera._tcp                          SRV     0 0 8891 cam-3.local.\n"
+                "_f1sh-camera._tcp                               PTR     Side\\032Cam._f1sh-camera._tcp\n");
+    CHECK(parser.takeResolved(true).isEmpty());
+    CHECK(parser.unresolvedHosts().isEmpty());
+
+    parser.feed("Side\\032Cam._f1sh-camera._tcp                  TXT     \"encoding=h265\"\n");
+    QList<CameraInfo> resolved = parser.takeResolved(true);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    const CameraInfo *side = find(resolved, "Side Cam");
+    CHECK(side);
+    if (side) {
+        CHECK_EQ(side->ip, QString("10.1.2.3"));
+        CHECK_EQ(side->port, 8890);
+        CHECK_EQ(side->encoding, QString("h265"));
+        CHECK_EQ(side->controlPort, 50051);
+    }
+
+    // At the end, services without TXT go in with defaults
+    resolved = parser.takeResolved(false);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    CHECK(find(resolved, "Rear") && find(resolved, "Rear")->port == 8891);
+}
+
+void testHostLookup()
+{
+    DiscoveryParser parser(kServiceType);
+    parser.feed("Lone._f1sh-camera._tcp                          SRV     0 0 8888 lone.local.\n");
+    CHECK_EQ(parser.unresolvedHosts(), QStringList{"lone.local"});
+    CHECK(parser.takeResolved(false).isEmpty());
+
+    parser.addHostAddress("lone.local", "fe80::2");
+    CHECK(parser.takeResolved(false).isEmpty());
+    parser.addHostAddress("lone.local", "172.16.0.9");
+    const QList<CameraInfo> resolved = parser.takeResolved(false);
+    CHECK_EQ(resolved.size(), qsizetype(1));
+    CHECK(find(resolved, "Lone") && find(resolved, "Lone")->ip == "172.16.0.9");
+
+    // Windows DNS API results arrive already assembled
+    CameraInfo info;
+    info.name = "Native";
+    info.hostname = "native.local";
+    info.port = 7000;
+    parser.addService(info);
+    CHECK_EQ(parser.unresolvedHosts(), QStringList{"native.local"});
+    parser.addHostAddress("NATIVE.local.", "172.16.0.10");
+    CHECK(find(parser.takeResolved(false), "Native"));
+}
+
+} // namespace
+
+int main()
+{
+    testUnescape();
+    testTxtRecord();
+    testAvahi();
+    testDnsSd();
+    testOutOfOrder();
+    testHostLookup();
+
+    std::printf("%d failures\n", s_failures);
+    return s_failures == 0 ? 0 : 1;
+}
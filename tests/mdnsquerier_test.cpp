@@ -0,0 +1,129 @@
+// Runs MdnsQuerier against scripts/mdns_test_responder.py and checks that
+// every advertised instance resolves with its SRV, TXT and A data.
+//
+// Usage: mdnsquerier-test <python> <mdns_test_responder.py>
+//
+// Needs multicast loopback on 224.0.0.251:5353; exits 77 (skipped) when the
+// responder or the querier cannot use it.
+
+#include "mdnsquerier.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QProcess>
+#include <QTextStream>
+#include <QTimer>
+
+#include <cstdio>
+
+namespace {
+
+constexpr int kInstances = 3;
+constexpr int kPort = 8899;
+constexpr int kControlPort = 50077;
+constexpr int kTimeoutMs = 15000;
+constexpr int kSkipped = 77;
+
+const char kServiceType[] = "_f1sh-camera._tcp.local";
+const char kNamePrefix[] = "Querier Test";
+
+QStringList checkInstance(const MdnsServiceInstance &instance, int number)
+{
+    QStringList problems;
+    const QString host = QString("f1sh-test-%1.local").arg(number);
+    if (instance.hostname.compare(host, Qt::CaseInsensitive) != 0) {
+        problems << QString("hostname %1, expected %2").arg(instance.hostname, host);
+    }
+    if (instance.port != kPort) {
+        problems << QString("port %1, expected %2").arg(instance.port).arg(kPort);
+    }
+    for (const QString &entry : {QString("protocol=udp"), QString("encoding=h264"),
+                                 QString("control_port=%1").arg(kControlPort)}) {
+        if (!instance.txt.contains(entry)) {
+            problems << QString("TXT lacks %1 (got %2)").arg(entry, instance.txt.join(' '));
+        }
+    }
+    if (!instance.addresses.contains(QHostAddress(QHostAddress::LocalHost))) {
+        problems << "address 127.0.0.1 missing";
+    }
+    return problems;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    if (argc != 3) {
+        out << "Usage: mdnsquerier-test <python> <mdns_test_responder.py>\n";
+        return 2;
+    }
+
+    QProcess responder;
+    responder.setProcessChannelMode(QProcess::MergedChannels);
+    responder.start(QString::fromLocal8Bit(argv[1]),
+                    {QString::fromLocal8Bit(argv[2]), "--count", QString::number(kInstances),
+                     "--name", kNamePrefix, "--port", QString::number(kPort),
+                     "--control-port", QString::number(kControlPort), "--address", "127.0.0.1"});
+    if (!responder.waitForStarted(5000)) {
+        out << "Cannot start the responder: " << responder.errorString() << "\n";
+        return 1;
+    }
+    // It prints one line once the socket is bound and joined
+    if (!responder.waitForReadyRead(5000) || responder.state() != QProcess::Running) {
+        out << "Responder did not come up, skipping: " << responder.readAll() << "\n";
+        responder.kill();
+        responder.waitForFinished();
+        return kSkipped;
+    }
+
+    QHash<QString, MdnsServiceInstance> resolved;
+    MdnsQuerier querier;
+    QObject::connect(&querier, &MdnsQuerier::instanceResolved, &app,
+                     [&](const MdnsServiceInstance &instance) {
+        if (!instance.name.startsWith(kNamePrefix) || instance.addresses.isEmpty()) {
+            return;
+        }
+        resolved.insert(instance.name, instance);
+        if (resolved.size() == kInstances) {
+            app.quit();
+        }
+    });
+
+    if (!querier.start(kServiceType)) {
+        out << "Cannot join the mDNS group, skipping\n";
+        responder.kill();
+        responder.waitForFinished();
+        return kSkipped;
+    }
+
+    QTimer::singleShot(kTimeoutMs, &app, &QCoreApplication::quit);
+    app.exec();
+    querier.stop();
+
+    responder.terminate();
+    if (!responder.waitForFinished(3000)) {
+        responder.kill();
+        responder.waitForFinished();
+    }
+
+    int failures = 0;
+    for (int number = 1; number <= kInstances; ++number) {
+        const QString name = QString("%1 %2").arg(kNamePrefix).arg(number);
+        if (!resolved.contains(name)) {
+            out << "FAIL " << name << ": not resolved\n";
+            ++failures;
+            continue;
+        }
+        const QStringList problems = checkInstance(resolved.value(name), number);
+        for (const QString &problem : problems) {
+            out << "FAIL " << name << ": " << problem << "\n";
+        }
+        failures += problems.isEmpty() ? 0 : 1;
+    }
+
+    out << resolved.size() << "/" << kInstances << " instances resolved, " << failures << " failed\n";
+    return failures == 0 ? 0 : 1;
+}